@@ -0,0 +1,145 @@
+#include "core/join_admission.h"
+
+#include <algorithm>
+
+namespace morphic {
+
+namespace {
+constexpr uint64_t k_minute_usec = 60000000;
+// Smoothing of the tick time averages.
+constexpr float k_tick_ema = 0.05f;
+
+uint64_t seconds_to_usec(float seconds) {
+  return static_cast<uint64_t>(seconds * 1000000.0f);
+}
+} // namespace
+
+bool JoinAdmission::try_admit(int peer_id, uint64_t now_usec) {
+  if (_active.count(peer_id)) {
+    return true;
+  }
+  if (_queued_since.count(peer_id)) {
+    return false;
+  }
+  if (has_free_slot()) {
+    admit(peer_id, now_usec);
+    return true;
+  }
+  _queue.push_back(peer_id);
+  _queued_since[peer_id] = now_usec;
+  _queued_total++;
+  return false;
+}
+
+void JoinAdmission::admit_now(int peer_id, uint64_t now_usec) {
+  if (!_active.count(peer_id)) {
+    admit(peer_id, now_usec);
+  }
+}
+
+void JoinAdmission::mark_ready(int peer_id, uint64_t now_usec) {
+  auto it = _active.find(peer_id);
+  if (it != _active.end() && it->second.ready_usec == 0) {
+    it->second.ready_usec = now_usec;
+  }
+}
+
+void JoinAdmission::remove(int peer_id) {
+  _active.erase(peer_id);
+  if (_queued_since.erase(peer_id)) {
+    _queue.erase(std::find(_queue.begin(), _queue.end(), peer_id));
+  }
+}
+
+void JoinAdmission::update(uint64_t now_usec,
+                           const std::function<int64_t(int)> &queued_bytes,
+                           std::vector<int> &r_admitted) {
+  for (auto it = _active.begin(); it != _active.end();) {
+    const Join &join = it->second;
+    const bool settled =
+        join.ready_usec != 0 &&
+        now_usec - join.ready_usec >= seconds_to_usec(k_settle_s) &&
+        queued_bytes(it->first) == 0;
+    const bool overdue =
+        now_usec - join.admitted_usec >= seconds_to_usec(k_max_join_s);
+    if (!settled && !overdue) {
+      ++it;
+      continue;
+    }
+    _completed++;
+    _join_usec += now_usec - join.admitted_usec;
+    _completed_recent.push_back(now_usec);
+    it = _active.erase(it);
+  }
+  while (!_completed_recent.empty() &&
+         now_usec - _completed_recent.front() > k_minute_usec) {
+    _completed_recent.pop_front();
+  }
+
+  while (has_free_slot() && !_queue.empty()) {
+    const int peer_id = _queue.front();
+    _queue.pop_front();
+    _queue_wait_usec += now_usec - _queued_since[peer_id];
+    _dequeued++;
+    _queued_since.erase(peer_id);
+    admit(peer_id, now_usec);
+    r_admitted.push_back(peer_id);
+  }
+}
+
+void JoinAdmission::record_tick(float physics_ms) {
+  float &average =
+      _active.empty() && _queue.empty() ? _tick_ms_idle : _tick_ms_joining;
+  average = average > 0.0f ? average + (physics_ms - average) * k_tick_ema
+                           : physics_ms;
+}
+
+void JoinAdmission::clear() {
+  const int max_concurrent = _max_concurrent;
+  *this = JoinAdmission();
+  _max_concurrent = max_concurrent;
+}
+
+int JoinAdmission::get_queue_position(int peer_id) const {
+  auto it = std::find(_queue.begin(), _queue.end(), peer_id);
+  return it != _queue.end() ? static_cast<int>(it - _queue.begin()) + 1 : 0;
+}
+
+Dictionary JoinAdmission::get_stats(uint64_t now_usec) const {
+  int64_t recent = 0;
+  for (uint64_t completed : _completed_recent) {
+    if (now_usec - completed <= k_minute_usec) {
+      recent++;
+    }
+  }
+
+  Dictionary stats;
+  stats["max_concurrent"] = _max_concurrent;
+  stats["joining"] = get_active_count();
+  stats["queued"] = static_cast<int>(_queue.size());
+  stats["joins_per_minute"] = recent;
+  stats["admitted"] = _admitted;
+  stats["completed"] = _completed;
+  stats["queued_total"] = _queued_total;
+  stats["avg_queue_wait_ms"] =
+      _dequeued > 0 ? _queue_wait_usec / 1000.0 / _dequeued : 0.0;
+  stats["avg_join_ms"] =
+      _completed > 0 ? _join_usec / 1000.0 / _completed : 0.0;
+  stats["tick_ms_joining"] = _tick_ms_joining;
+  stats["tick_ms_idle"] = _tick_ms_idle;
+  return stats;
+}
+
+bool JoinAdmission::has_free_slot() const {
+  return _max_concurrent <= 0 ||
+         static_cast<int>(_active.size()) < _max_concurrent;
+}
+
+void JoinAdmission::admit(int peer_id, uint64_t now_usec) {
+  Join join;
+  join.admitted_usec = now_usec;
+  _active[peer_id] = join;
+  _admitted++;
+}
+
+} // namespace morphic
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <godot_cpp/variant/dictionary.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+using namespace godot;
+
+namespace morphic {
+
+// Server-side limit on how many peers join at once. A join runs from the
+// accepted hello until the player is spawned and its initial terrain
+// burst has drained (or a deadline passed); peers beyond the limit wait in
+// a FIFO and are admitted as slots free up. Without it a server restart
+// has every client handshake, spawn and stream terrain in the same few
+// ticks.
+//
+// Also keeps the numbers to tune the limit by: joins per minute, time in
+// the queue and in the join, and the physics tick time while joins run
+// against while none do.
+class JoinAdmission {
+public:
+  // A ready peer counts as joining at least this long, and until its send
+  // queue is empty, but never longer than k_max_join_s.
+  static constexpr float k_settle_s = 2.0f;
+  static constexpr float k_max_join_s = 15.0f;
+
+  // True when `peer_id` may join now (also when it already is joining);
+  // otherwise it is queued.
+  bool try_admit(int peer_id, uint64_t now_usec);
+  // Admits `peer_id` even when every slot is taken (resumed joins).
+  void admit_now(int peer_id, uint64_t now_usec);
+  void mark_ready(int peer_id, uint64_t now_usec);
+  void remove(int peer_id);
+  // Finishes settled joins and admits queued peers into the free slots,
+  // listing them in `r_admitted`. `queued_bytes` reports a peer's backlog.
+  void update(uint64_t now_usec,
+              const std::function<int64_t(int)> &queued_bytes,
+              std::vector<int> &r_admitted);
+  void record_tick(float physics_ms);
+  void clear();
+
+  int get_max_concurrent() const { return _max_concurrent; }
+  // 0 = no limit.
+  void set_max_concurrent(int count) { _max_concurrent = count; }
+  // 1-based, 0 when not queued.
+  int get_queue_position(int peer_id) const;
+  const std::deque<int> &get_queue() const { return _queue; }
+  int get_active_count() const { return static_cast<int>(_active.size()); }
+  Dictionary get_stats(uint64_t now_usec) const;
+
+private:
+  struct Join {
+    uint64_t admitted_usec = 0;
+    uint64_t ready_usec = 0;
+  };
+
+  int _max_concurrent = 4;
+  std::unordered_map<int, Join> _active;
+  std::deque<int> _queue;
+  std::unordered_map<int, uint64_t> _queued_since;
+  // Completion times within the last minute.
+  std::deque<uint64_t> _completed_recent;
+
+  int64_t _admitted = 0;
+  int64_t _completed = 0;
+  int64_t _queued_total = 0;
+  int64_t _dequeued = 0;
+  uint64_t _queue_wait_usec = 0;
+  uint64_t _join_usec = 0;
+  float _tick_ms_joining = 0.0f;
+  float _tick_ms_idle = 0.0f;
+
+  bool has_free_slot() const;
+  void admit(int peer_id, uint64_t now_usec);
+};
+
+} // namespace morphic
@@ -1,11 +1,20 @@
 #include "core/network_manager.h"
 
+#include "utils/bind_methods.h"
 #include "utils/debug_utils.h"
 #include "utils/network_utils.h"
 
 #include <godot_cpp/classes/e_net_multiplayer_peer.hpp>
+#include <godot_cpp/classes/e_net_packet_peer.hpp>
+#include <godot_cpp/classes/crypto.hpp>
+#include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/file_access.hpp>
 #include <godot_cpp/classes/multiplayer_peer.hpp>
+#include <godot_cpp/classes/performance.hpp>
+#include <godot_cpp/classes/scene_multiplayer.hpp>
 #include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/core/math.hpp>
+#include <algorithm>
 #include <vector>
 
 using namespace godot;
@@ -19,35 +28,53 @@ void NetworkManager::_ready() {
   mp->connect("connected_to_server", Callable(this, "_on_connected_to_server"));
   mp->connect("connection_failed", Callable(this, "_on_connection_failed"));
   mp->connect("server_disconnected", Callable(this, "_on_server_disconnected"));
+  // Typed messages travel as raw bytes (see net/net_message.h).
+  mp->connect("peer_packet", Callable(this, "_on_peer_packet"));
 
-  Dictionary rpc_any_peer;
-  rpc_any_peer["rpc_mode"] = MultiplayerAPI::RPC_MODE_ANY_PEER;
-  rpc_config("_rpc_client_hello", rpc_any_peer);
-  rpc_config("_rpc_client_ready", rpc_any_peer);
-
-  Dictionary rpc_authority;
-  rpc_authority["rpc_mode"] = MultiplayerAPI::RPC_MODE_AUTHORITY;
-  rpc_config("_rpc_server_hello_ack", rpc_authority);
-  rpc_config("_rpc_server_ready_ack", rpc_authority);
+  _bind_message_handlers();
 
   set_process(true);
+  set_physics_process(true);
+}
+
+void NetworkManager::_physics_process(double) {
+  // Autoloads sit before the scene, so gameplay reading the tick during
+  // this physics frame already sees the new value.
+  if (NetUtils::is_server(this)) {
+    _server_tick++;
+    _server_tick_usec = _get_local_server_time_usec();
+    // Duration of the previous physics frame.
+    _joins.record_tick(static_cast<float>(
+        Performance::get_singleton()->get_monitor(
+            Performance::TIME_PHYSICS_PROCESS) *
+        1000.0));
+  }
 }
 
 void NetworkManager::_process(double delta) {
   const float d = static_cast<float>(delta);
+  // Feeds the automatic terrain radius request.
+  const float frame_ms = d * 1000.0f;
+  _frame_ms_average = _frame_ms_average > 0.0f
+                          ? _frame_ms_average * 0.95f + frame_ms * 0.05f
+                          : frame_ms;
 
   if (NetUtils::is_server(this)) {
     std::vector<int> timed_out_peers;
-    for (auto &entry : _server_handshakes) {
-      entry.second.timeout_s -= d;
-      if (entry.second.timeout_s <= 0.0f) {
-        timed_out_peers.push_back(entry.first);
+    for (PeerRecord &record : _peers.records()) {
+      if (!record.handshake_pending || record.handshake.queued) {
+        continue;
+      }
+      record.handshake.timeout_s -= d;
+      if (record.handshake.timeout_s <= 0.0f) {
+        timed_out_peers.push_back(record.peer_id);
       }
     }
 
     for (int peer_id : timed_out_peers) {
       _disconnect_peer(peer_id, "Handshake timeout");
     }
+    _update_join_admission();
   }
 
   if (_client_handshake_stage != ClientHandshakeStage::NONE) {
@@ -56,17 +83,35 @@ void NetworkManager::_process(double delta) {
       _close_client_connection("Client handshake timeout");
     }
   }
+
+  _update_clock_sync(d);
+  _flush_send_queues(d);
+  _sample_peer_stats(d);
 }
 
 bool NetworkManager::start_host(int port) {
-  connected_players.clear();
-  ready_players.clear();
-  _server_handshakes.clear();
+  _peers.clear();
+  _joins.clear();
   _reset_client_handshake_state();
-
-  Ref<ENetMultiplayerPeer> peer;
-  peer.instantiate();
-  Error err = peer->create_server(port);
+  _server_epoch_usec = Time::get_singleton()->get_ticks_usec();
+  _server_tick = 0;
+  _server_tick_usec = 0;
+  _tickets.reset_key();
+
+  Ref<MultiplayerPeer> peer;
+  Error err;
+  if (_network_thread) {
+    Ref<ThreadedENetPeer> threaded;
+    threaded.instantiate();
+    err = threaded->create_server(port, 32,
+                                  _channel_layout.get_channel_count());
+    peer = threaded;
+  } else {
+    Ref<ENetMultiplayerPeer> enet;
+    enet.instantiate();
+    err = enet->create_server(port, 32, _channel_layout.get_channel_count());
+    peer = enet;
+  }
   if (err != Error::OK) {
     ERR_PRINT(DebugUtils::format_log(
         "Error: failed creating the server. status: %d", err));
@@ -74,11 +119,14 @@ bool NetworkManager::start_host(int port) {
   }
 
   NetUtils::get_mp(this)->set_multiplayer_peer(peer);
-  connected_players[1] = "Host";
-  emit_signal("player_joined", 1);
+  _configure_threaded_channels(_channel_layout);
+  if (!_dedicated) {
+    _peers.add(1).name = "Host";
+    emit_signal("player_joined", 1);
 
-  if (!_server_world_id.is_empty()) {
-    _mark_peer_ready(1);
+    if (!_server_world_id.is_empty()) {
+      _mark_peer_ready(1);
+    }
   }
 
   LOG("Successfuly created the server");
@@ -86,14 +134,29 @@ bool NetworkManager::start_host(int port) {
 }
 
 bool NetworkManager::start_client(const String &p_address, int p_port) {
-  connected_players.clear();
-  ready_players.clear();
-  _server_handshakes.clear();
+  _peers.clear();
   _reset_client_handshake_state();
-
-  Ref<ENetMultiplayerPeer> peer;
-  peer.instantiate();
-  Error err = peer->create_client(p_address, p_port);
+  _client_connect_usec = Time::get_singleton()->get_ticks_usec();
+  _client_transport_usec = 0;
+  _client_accepted_usec = 0;
+  _client_spawn_usec = 0;
+  _client_resumed = false;
+
+  Ref<MultiplayerPeer> peer;
+  Error err;
+  if (_network_thread) {
+    Ref<ThreadedENetPeer> threaded;
+    threaded.instantiate();
+    err = threaded->create_client(p_address, p_port,
+                                  NetChannelLayout::k_max_channels);
+    peer = threaded;
+  } else {
+    Ref<ENetMultiplayerPeer> enet;
+    enet.instantiate();
+    err = enet->create_client(p_address, p_port,
+                              NetChannelLayout::k_max_channels);
+    peer = enet;
+  }
   if (err != Error::OK) {
     ERR_PRINT(DebugUtils::format_log(
         "Error: failed joining to the server. status: %d", err));
@@ -110,9 +173,10 @@ void NetworkManager::configure_server_handshake_context(const String &world_id,
   _server_world_id = world_id;
   _server_seed = seed;
 
-  if (NetUtils::is_server(this) && !_server_world_id.is_empty()) {
-    if (!connected_players.has(1)) {
-      connected_players[1] = "Host";
+  if (NetUtils::is_server(this) && !_server_world_id.is_empty() &&
+      !_dedicated) {
+    if (!_peers.find(1)) {
+      _peers.add(1).name = "Host";
       emit_signal("player_joined", 1);
     }
     _mark_peer_ready(1);
@@ -135,70 +199,136 @@ void NetworkManager::_start_client_handshake() {
                     "NetworkManager: multiplayer peer is not set");
 
   const int my_id = mp->get_unique_id();
-  _client_nonce = String::num_int64(Time::get_singleton()->get_ticks_usec()) +
-                  "-" + String::num_int64(my_id);
-  _client_session_nonce = "";
+  _client_nonce = Time::get_singleton()->get_ticks_usec() ^
+                  (static_cast<uint64_t>(my_id) << 32);
   _client_handshake_stage = ClientHandshakeStage::WAIT_HELLO_ACK;
   _client_handshake_timeout_left = k_client_handshake_timeout_s;
 
-  const Error err = rpc_id(1, "_rpc_client_hello", k_protocol_version,
-                           _client_build_hash, _client_requested_world_id,
-                           _client_nonce);
+  ClientHelloMessage hello;
+  hello.protocol_version = k_protocol_version;
+  hello.build_hash.set(_client_build_hash);
+  hello.world_id_hash = net_hash_string(_client_requested_world_id);
+  hello.client_nonce = _client_nonce;
+  hello.client_identity = _get_client_identity();
+  hello.resume_ticket.bytes = _get_client_resume_ticket();
+  hello.channel_capacity = NetChannelLayout::k_max_channels;
+  hello.terrain_dictionary =
+      _terrain_dictionary_enabled ? k_terrain_dictionary_version : 0;
+
+  // Slower than the frame target: ask for proportionally less terrain.
+  const float frame_headroom =
+      _frame_ms_average > 0.0f
+          ? Math::clamp(k_target_frame_ms / _frame_ms_average, 0.25f, 1.0f)
+          : 1.0f;
+  const int auto_view = static_cast<int>(k_auto_view_distance * frame_headroom);
+  const int view =
+      _requested_view_distance > 0 ? _requested_view_distance : auto_view;
+  const int collision = _requested_collision_distance > 0
+                            ? _requested_collision_distance
+                            : Math::min(view, k_auto_collision_distance);
+  hello.view_distance = static_cast<uint16_t>(Math::clamp(view, 0, 65535));
+  hello.collision_distance =
+      static_cast<uint16_t>(Math::clamp(collision, 0, 65535));
+
+  const Error err = send_message(1, hello);
   if (err != OK) {
     _close_client_connection(
         DebugUtils::format_log("Failed sending client hello. status: %d", err));
   }
 }
 
-void NetworkManager::_rpc_client_hello(int protocol_version,
-                                       const String &client_build_hash,
-                                       const String &requested_world_id,
-                                       const String &client_nonce) {
-  ERR_FAIL_COND_MSG(!NetUtils::is_server(this),
-                    "NetworkManager: client handled client hello RPC");
-
-  Ref<MultiplayerAPI> mp = NetUtils::get_mp(this);
-  ERR_FAIL_COND_MSG(mp.is_null(), "NetworkManager: MultiplayerAPI is null");
-
-  const int sender_id = mp->get_remote_sender_id();
+void NetworkManager::_on_client_hello(int sender_id,
+                                      const ClientHelloMessage &message) {
   ERR_FAIL_COND_MSG(sender_id <= 0, "NetworkManager: invalid hello sender");
 
-  ServerHandshakePeerState &state = _server_handshakes[sender_id];
-  if (!state.hello_received) {
+  PeerRecord &record = _peers.add(sender_id);
+  PeerHandshakeState &state = record.handshake;
+  // A ready peer is past the handshake, and a queued one is answered once
+  // admitted; neither may take another join slot or ticket.
+  if (record.ready ||
+      (state.queued && _joins.get_queue_position(sender_id) > 0)) {
+    _duplicate_hellos++;
+    return;
+  }
+  if (!record.handshake_pending) {
+    record.handshake_pending = true;
+    state = PeerHandshakeState();
     state.timeout_s = k_server_hello_timeout_s;
   }
 
-  bool accepted = true;
-  String reject_reason;
-  if (protocol_version != k_protocol_version) {
-    accepted = false;
-    reject_reason = "Protocol version mismatch";
+  ServerHelloAckMessage ack;
+  ack.protocol_version = k_protocol_version;
+  ack.world_id_hash = net_hash_string(_server_world_id);
+  ack.seed = _server_seed;
+  ack.client_nonce = message.client_nonce;
+  for (int i = 0; i < NetChannelLayout::k_class_count; i++) {
+    ack.channels[i] = _channel_layout.channels[i];
+  }
+  // Radii: what the client asked for within our policy; 0 = our maximum.
+  const int max_view = Math::max(_max_peer_view_distance, k_min_view_distance);
+  ack.view_distance = static_cast<uint16_t>(
+      message.view_distance > 0
+          ? Math::clamp<int>(message.view_distance, k_min_view_distance,
+                             max_view)
+          : max_view);
+  ack.collision_distance = static_cast<uint16_t>(Math::clamp<int>(
+      message.collision_distance > 0 ? message.collision_distance
+                                     : _max_peer_collision_distance,
+      0, Math::min<int>(_max_peer_collision_distance, ack.view_distance)));
+  // Anything but an exact dictionary match falls back to plain blocks.
+  if (_terrain_dictionary_enabled &&
+      message.terrain_dictionary == k_terrain_dictionary_version) {
+    ack.terrain_codec = TerrainCodec::GENERATOR_DELTA;
+  }
+
+  if (message.protocol_version != k_protocol_version) {
+    ack.reject = HandshakeReject::PROTOCOL_MISMATCH;
   } else if (_server_world_id.is_empty()) {
-    accepted = false;
-    reject_reason = "Server world context not set";
-  } else if (!requested_world_id.is_empty() &&
-             requested_world_id != _server_world_id) {
-    accepted = false;
-    reject_reason = "Requested world id mismatch";
-  }
-
-  String session_nonce;
-  if (accepted) {
-    state.hello_received = true;
-    state.ready_received = false;
-    state.protocol_version = protocol_version;
-    state.client_build_hash = client_build_hash;
-    state.requested_world_id = requested_world_id;
-    state.client_nonce = client_nonce;
-    state.session_nonce = _make_server_session_nonce(sender_id);
-    state.timeout_s = k_server_ready_timeout_s;
-    session_nonce = state.session_nonce;
-  }
-
-  const Error ack_err = rpc_id(sender_id, "_rpc_server_hello_ack", accepted,
-                               reject_reason, k_protocol_version,
-                               _server_world_id, _server_seed, client_nonce,
-                               session_nonce);
+    ack.reject = HandshakeReject::NO_WORLD_CONTEXT;
+  } else if (message.world_id_hash != 0 &&
+             message.world_id_hash != ack.world_id_hash) {
+    ack.reject = HandshakeReject::WORLD_MISMATCH;
+  } else if (!_channel_layout.fits(message.channel_capacity)) {
+    ack.reject = HandshakeReject::CHANNEL_LAYOUT;
+  }
+
+  // A ticket from an earlier join on this server and world skips the queue.
+  const uint64_t now_usec = Time::get_singleton()->get_ticks_usec();
+  const uint64_t now_unix =
+      static_cast<uint64_t>(Time::get_singleton()->get_unix_time_from_system());
+  ResumeTicket ticket;
+  bool resumed = false;
+  if (ack.reject == HandshakeReject::NONE &&
+      !message.resume_ticket.bytes.is_empty()) {
+    resumed = _tickets.verify(message.resume_ticket.bytes, now_unix,
+                              ticket) == ResumeTicketIssuer::Result::VALID &&
+              ticket.world_id_hash == ack.world_id_hash;
+    // A queued hello comes through here again once admitted.
+    if (!resumed && !state.queued) {
+      _rejected_tickets++;
+    }
+  }
+  if (resumed) {
+    _joins.admit_now(sender_id, now_usec);
+  } else if (ack.reject == HandshakeReject::NONE &&
+             !_joins.try_admit(sender_id, now_usec)) {
+    // Answered from _update_join_admission() once a slot frees up.
+    state.queued = true;
+    state.queued_hello = message;
+    _send_join_queue_positions();
+    return;
+  }
+
+  if (ack.reject == HandshakeReject::NONE) {
+    state.queued = false;
+    record.client_identity =
+        resumed ? ticket.client_identity : message.client_identity;
+    ack.resumed = resumed;
+    ack.resume_ticket.bytes =
+        _tickets.issue(record.client_identity, ack.world_id_hash, now_unix);
+  }
+
+  const Error ack_err = send_message(sender_id, ack);
   if (ack_err != OK) {
     _disconnect_peer(sender_id, DebugUtils::format_log(
                                     "Failed sending hello ack. status: %d",
@@ -206,144 +336,305 @@ void NetworkManager::_rpc_client_hello(int protocol_version,
     return;
   }
 
-  if (!accepted) {
-    _disconnect_peer(sender_id, String("Handshake rejected: ") + reject_reason);
+  if (ack.reject == HandshakeReject::NONE) {
+    // From here on this peer gets every class on its own channel.
+    PeerRecord *accepted = _peers.find(sender_id);
+    if (accepted) {
+      accepted->channels_ready = true;
+      accepted->terrain_codec = ack.terrain_codec;
+      accepted->view_distance = ack.view_distance;
+      accepted->collision_distance = ack.collision_distance;
+      accepted->handshake_pending = false;
+      accepted->handshake = PeerHandshakeState();
+    }
+    if (resumed) {
+      _resumed_joins++;
+    }
+    // No ready round trip: the ack went out first on the reliable session
+    // channel, so the client has the seed before its player arrives.
+    _mark_peer_ready(sender_id);
+  } else {
+    _disconnect_peer(sender_id,
+                     String("Handshake rejected: ") +
+                         handshake_reject_to_string(ack.reject));
   }
 }
 
-void NetworkManager::_rpc_server_hello_ack(bool accepted,
-                                           const String &reject_reason,
-                                           int protocol_version,
-                                           const String &authoritative_world_id,
-                                           int authoritative_seed,
-                                           const String &client_nonce,
-                                           const String &session_nonce) {
-  ERR_FAIL_COND_MSG(NetUtils::is_server(this),
-                    "NetworkManager: server handled server hello ack RPC");
-
+void NetworkManager::_on_server_hello_ack(
+    int, const ServerHelloAckMessage &message) {
   if (_client_handshake_stage != ClientHandshakeStage::WAIT_HELLO_ACK) {
     return;
   }
 
-  if (client_nonce != _client_nonce) {
+  if (message.client_nonce != _client_nonce) {
     _close_client_connection("Handshake nonce mismatch on hello ack");
     return;
   }
 
-  if (!accepted) {
+  if (message.reject != HandshakeReject::NONE) {
     _close_client_connection(String("Server rejected handshake: ") +
-                             reject_reason);
+                             handshake_reject_to_string(message.reject));
     return;
   }
 
-  if (protocol_version != k_protocol_version) {
+  if (message.protocol_version != k_protocol_version) {
     _close_client_connection("Server protocol version mismatch");
     return;
   }
 
   if (!_client_requested_world_id.is_empty() &&
-      authoritative_world_id != _client_requested_world_id) {
+      message.world_id_hash != net_hash_string(_client_requested_world_id)) {
     _close_client_connection("Authoritative world id mismatch");
     return;
   }
 
-  if (_client_expected_seed > 0 && authoritative_seed != _client_expected_seed) {
+  if (_client_expected_seed > 0 && message.seed != _client_expected_seed) {
     _close_client_connection("Authoritative seed mismatch");
     return;
   }
 
-  _client_session_nonce = session_nonce;
-  _client_handshake_stage = ClientHandshakeStage::WAIT_READY_ACK;
-  _client_handshake_timeout_left = k_client_handshake_timeout_s;
+  NetChannelLayout layout;
+  for (int i = 0; i < NetChannelLayout::k_class_count; i++) {
+    layout.channels[i] = message.channels[i];
+  }
+  if (!layout.fits(NetChannelLayout::k_max_channels)) {
+    _close_client_connection("Server channel layout exceeds our channels");
+    return;
+  }
+  _client_channel_layout = layout;
+  _client_channels_ready = true;
+  _configure_threaded_channels(layout);
+  _client_join_queue_position = 0;
+  _client_terrain_codec = message.terrain_codec;
+  _client_view_distance = message.view_distance;
+  _client_collision_distance = message.collision_distance;
+  _client_session_seed = message.seed;
+  _client_world_id_hash = message.world_id_hash;
+
+  // Start syncing now so the estimate has settled by the time we spawn.
+  _clock.reset();
+  _clock_active = true;
+  _clock_pings_sent = 0;
+  _clock_ping_left = 0.0f;
+
+  _client_resumed = message.resumed;
+  _set_client_resume_ticket(message.resume_ticket.bytes);
+
+  // The world must be able to generate terrain by the time our player
+  // arrives, which the server sends right behind this ack.
+  emit_signal("session_seed_received", message.seed);
+
+  // The ack completed the join: keep the negotiated channels, only stop
+  // the timer.
+  _client_handshake_stage = ClientHandshakeStage::NONE;
+  _client_handshake_timeout_left = 0.0f;
+  _client_accepted_usec = Time::get_singleton()->get_ticks_usec();
+  emit_signal("connection_success");
+}
 
-  const Error err = rpc_id(1, "_rpc_client_ready", _client_session_nonce);
-  if (err != OK) {
-    _close_client_connection(
-        DebugUtils::format_log("Failed sending client ready. status: %d", err));
+void NetworkManager::_on_join_queued(int, const JoinQueuedMessage &message) {
+  if (_client_handshake_stage != ClientHandshakeStage::WAIT_HELLO_ACK) {
+    return;
   }
+  // Still alive and in line: the hello ack is allowed to take longer.
+  _client_join_queue_position = message.position;
+  _client_handshake_timeout_left = k_client_join_queue_timeout_s;
+  emit_signal("join_queued", message.position, message.queue_length);
 }
 
-void NetworkManager::_rpc_client_ready(const String &session_nonce) {
-  ERR_FAIL_COND_MSG(!NetUtils::is_server(this),
-                    "NetworkManager: client handled client ready RPC");
+//////// MESSAGES ////////////////
+
+void NetworkManager::_bind_message_handlers() {
+  // Gameplay handlers only ever see peers that finished the handshake.
+  _dispatcher.set_admission_check([this](int sender_id) {
+    const PeerRecord *record = _peers.find(sender_id);
+    return record && record->ready;
+  });
+  _dispatcher.bind<ClientHelloMessage>(
+      [this](int sender_id, const ClientHelloMessage &message) {
+        _on_client_hello(sender_id, message);
+      });
+  _dispatcher.bind<ServerHelloAckMessage>(
+      [this](int sender_id, const ServerHelloAckMessage &message) {
+        _on_server_hello_ack(sender_id, message);
+      });
+  _dispatcher.bind<JoinQueuedMessage>(
+      [this](int sender_id, const JoinQueuedMessage &message) {
+        _on_join_queued(sender_id, message);
+      });
+  _dispatcher.bind<ClockPingMessage>(
+      [this](int sender_id, const ClockPingMessage &message) {
+        _on_clock_ping(sender_id, message);
+      });
+  _dispatcher.bind<ClockPongMessage>(
+      [this](int sender_id, const ClockPongMessage &message) {
+        _on_clock_pong(sender_id, message);
+      });
+}
 
-  Ref<MultiplayerAPI> mp = NetUtils::get_mp(this);
-  ERR_FAIL_COND_MSG(mp.is_null(), "NetworkManager: MultiplayerAPI is null");
+Error NetworkManager::send_packet(int peer_id, const PackedByteArray &packet,
+                                  NetMessageClass message_class) {
+  ERR_FAIL_COND_V_MSG(packet.is_empty(), ERR_INVALID_PARAMETER,
+                      "NetworkManager: refusing to send an empty message");
 
-  const int sender_id = mp->get_remote_sender_id();
-  auto it = _server_handshakes.find(sender_id);
-  if (it == _server_handshakes.end() || !it->second.hello_received) {
-    _disconnect_peer(sender_id, "Ready received before hello");
-    return;
+  const Error err = _send_now(peer_id, packet, message_class);
+  if (err == OK && NetUtils::is_server(this)) {
+    PeerRecord *record = _peers.find(peer_id);
+    if (record) {
+      record->send_queue.charge(static_cast<int>(packet.size()));
+    }
   }
+  return err;
+}
 
-  if (it->second.session_nonce != session_nonce) {
-    _disconnect_peer(sender_id, "Ready session nonce mismatch");
-    return;
+Error NetworkManager::queue_packet(int peer_id, const PackedByteArray &packet,
+                                   NetMessageClass message_class,
+                                   float priority) {
+  ERR_FAIL_COND_V_MSG(packet.is_empty(), ERR_INVALID_PARAMETER,
+                      "NetworkManager: refusing to queue an empty message");
+  PeerRecord *record = _peers.find(peer_id);
+  if (!NetUtils::is_server(this) || _peer_send_budget <= 0 || !record) {
+    return send_packet(peer_id, packet, message_class);
   }
+  record->send_queue.push(packet, message_class, priority,
+                          Time::get_singleton()->get_ticks_usec());
+  return OK;
+}
 
-  _server_handshakes.erase(it);
-  _mark_peer_ready(sender_id);
+int64_t NetworkManager::get_peer_queued_bytes(int peer_id) const {
+  const PeerRecord *record = _peers.find(peer_id);
+  return record ? record->send_queue.get_queued_bytes() : 0;
+}
 
-  const Error ack_err = rpc_id(sender_id, "_rpc_server_ready_ack", session_nonce);
-  if (ack_err != OK) {
-    _disconnect_peer(sender_id, DebugUtils::format_log(
-                                    "Failed sending ready ack. status: %d",
-                                    ack_err));
+Error NetworkManager::_send_now(int peer_id, const PackedByteArray &packet,
+                                NetMessageClass message_class) {
+  Ref<SceneMultiplayer> mp = NetUtils::get_mp(this);
+  if (mp.is_null() || !mp->has_multiplayer_peer()) {
+    return ERR_UNCONFIGURED;
   }
-}
 
-void NetworkManager::_rpc_server_ready_ack(const String &session_nonce) {
-  ERR_FAIL_COND_MSG(NetUtils::is_server(this),
-                    "NetworkManager: server handled server ready ack RPC");
+  const Error err =
+      mp->send_bytes(packet, peer_id, net_transfer_mode(message_class),
+                     get_peer_channel(peer_id, message_class));
+  if (err == OK) {
+    record_traffic_out(peer_id, static_cast<int>(packet.size()));
+  }
+  return err;
+}
 
-  if (_client_handshake_stage != ClientHandshakeStage::WAIT_READY_ACK) {
+void NetworkManager::_update_join_admission() {
+  _admitted_joins.clear();
+  _joins.update(
+      Time::get_singleton()->get_ticks_usec(),
+      [this](int peer_id) { return get_peer_queued_bytes(peer_id); },
+      _admitted_joins);
+  if (_admitted_joins.empty()) {
     return;
   }
+  for (int peer_id : _admitted_joins) {
+    PeerRecord *record = _peers.find(peer_id);
+    if (record && record->handshake.queued) {
+      const ClientHelloMessage hello = record->handshake.queued_hello;
+      _on_client_hello(peer_id, hello);
+    }
+  }
+  _send_join_queue_positions();
+}
+
+void NetworkManager::_send_join_queue_positions() {
+  const std::deque<int> &queue = _joins.get_queue();
+  JoinQueuedMessage message;
+  message.queue_length = static_cast<uint16_t>(queue.size());
+  for (size_t i = 0; i < queue.size(); i++) {
+    message.position = static_cast<uint16_t>(i + 1);
+    send_message(queue[i], message);
+  }
+}
 
-  if (_client_session_nonce != session_nonce) {
-    _close_client_connection("Ready ack session nonce mismatch");
+void NetworkManager::_flush_send_queues(float delta) {
+  if (!NetUtils::is_server(this)) {
     return;
   }
+  const uint64_t now = Time::get_singleton()->get_ticks_usec();
+  for (PeerRecord &record : _peers.records()) {
+    PeerSendQueue &queue = record.send_queue;
+    queue.set_configured_budget(static_cast<float>(_peer_send_budget));
+    _send_ready.clear();
+    queue.pop_ready(delta, now, _send_ready);
+    // Sending may not touch the table: `record` stays valid.
+    const int peer_id = record.peer_id;
+    for (const PeerSendQueue::Packet &packet : _send_ready) {
+      _send_now(peer_id, packet.bytes, packet.message_class);
+    }
+  }
+}
 
-  _reset_client_handshake_state();
-  emit_signal("connection_success");
+int NetworkManager::get_peer_channel(int peer_id,
+                                     NetMessageClass message_class) const {
+  if (NetUtils::is_server(this)) {
+    const PeerRecord *record = _peers.find(peer_id);
+    return record && record->channels_ready
+               ? _channel_layout.get_channel(message_class)
+               : 0;
+  }
+  return _client_channels_ready
+             ? _client_channel_layout.get_channel(message_class)
+             : 0;
+}
+
+const NetChannelLayout &NetworkManager::get_channel_layout() const {
+  if (!NetUtils::is_server(this) && _client_channels_ready) {
+    return _client_channel_layout;
+  }
+  return _channel_layout;
+}
+
+void NetworkManager::_on_peer_packet(int p_peer_id,
+                                     const PackedByteArray &p_packet) {
+  record_traffic_in(p_peer_id, static_cast<int>(p_packet.size()));
+  _dispatcher.dispatch(p_peer_id, p_packet, NetUtils::is_server(this));
 }
 
 void NetworkManager::_on_peer_connected(int p_peer_id) {
   if (NetUtils::is_server(this)) {
     LOG("NetworkManager: Wykryto gracza %d", p_peer_id);
     emit_signal("player_joined", p_peer_id);
-
-    if (p_peer_id != 1) {
-      ServerHandshakePeerState state;
-      state.timeout_s = k_server_hello_timeout_s;
-      _server_handshakes[p_peer_id] = state;
-    }
   }
 
-  connected_players[p_peer_id] = "Player_" + String::num(p_peer_id);
+  PeerRecord &record = _peers.add(p_peer_id);
+  record.name = "Player_" + String::num(p_peer_id);
+  if (NetUtils::is_server(this) && p_peer_id != 1) {
+    record.connected_usec = Time::get_singleton()->get_ticks_usec();
+    record.handshake_pending = true;
+    record.handshake = PeerHandshakeState();
+    record.handshake.timeout_s = k_server_hello_timeout_s;
+  }
 }
 
 void NetworkManager::_on_peer_disconnected(int p_peer_id) {
-  connected_players.erase(p_peer_id);
-  ready_players.erase(p_peer_id);
-  _server_handshakes.erase(p_peer_id);
+  // Listeners still see the peer record (e.g. its client identity).
+  if (NetUtils::is_server(this)) {
+    emit_signal("player_left", p_peer_id);
+  }
 
-  if (!NetUtils::is_server(this) && p_peer_id == 1) {
-    _reset_client_handshake_state();
+  const bool was_queued = _joins.get_queue_position(p_peer_id) > 0;
+  _peers.remove(p_peer_id);
+  _joins.remove(p_peer_id);
+  if (was_queued) {
+    _send_join_queue_positions();
   }
 
-  if (NetUtils::is_server(this)) {
-    emit_signal("player_left", p_peer_id);
+  if (!NetUtils::is_server(this) && p_peer_id == 1) {
+    _reset_client_handshake_state();
   }
 }
 
 void NetworkManager::_on_connected_to_server() {
   LOG("NetworkManager: connection transport established");
 
+  _client_transport_usec = Time::get_singleton()->get_ticks_usec();
   const int my_id = NetUtils::get_mp(this)->get_unique_id();
-  connected_players[my_id] = "Me";
+  _peers.add(my_id).name = "Me";
 
   _start_client_handshake();
 }
@@ -356,9 +647,7 @@ void NetworkManager::_on_connection_failed() {
 
 void NetworkManager::_on_server_disconnected() {
   LOG("NetworkManager: Rozłączono z serwerem.");
-  connected_players.clear();
-  ready_players.clear();
-  _server_handshakes.clear();
+  _peers.clear();
   _reset_client_handshake_state();
   emit_signal("server_disconnected");
 }
@@ -366,16 +655,27 @@ void NetworkManager::_on_server_disconnected() {
 void NetworkManager::_reset_client_handshake_state() {
   _client_handshake_stage = ClientHandshakeStage::NONE;
   _client_handshake_timeout_left = 0.0f;
-  _client_nonce = "";
-  _client_session_nonce = "";
+  _client_nonce = 0;
+  _client_channels_ready = false;
+  _client_join_queue_position = 0;
+  _client_terrain_codec = TerrainCodec::VOXEL;
+  _client_view_distance = 0;
+  _client_collision_distance = 0;
+  _client_session_seed = 0;
+  _client_world_id_hash = 0;
+  _clock_active = false;
+  _clock.reset();
 }
 
 void NetworkManager::_disconnect_peer(int peer_id, const String &reason) {
   WARN_PRINT(String("NetworkManager: disconnect peer ") + String::num(peer_id) +
              String(" - ") + reason);
 
-  _server_handshakes.erase(peer_id);
-  ready_players.erase(peer_id);
+  PeerRecord *record = _peers.find(peer_id);
+  if (record) {
+    record->handshake_pending = false;
+    record->ready = false;
+  }
 
   Ref<MultiplayerAPI> mp = NetUtils::get_mp(this);
   if (mp.is_null() || !mp->has_multiplayer_peer()) {
@@ -405,27 +705,544 @@ void NetworkManager::_close_client_connection(const String &reason) {
 }
 
 void NetworkManager::_mark_peer_ready(int peer_id) {
-  if (ready_players.find(peer_id) != ready_players.end()) {
+  PeerRecord &record = _peers.add(peer_id);
+  if (record.ready) {
     return;
   }
 
-  ready_players.insert(peer_id);
+  record.ready = true;
+  const uint64_t now = Time::get_singleton()->get_ticks_usec();
+  if (record.connected_usec > 0) {
+    _time_to_ready_usec += now - record.connected_usec;
+    _ready_joins++;
+  }
+  _joins.mark_ready(peer_id, now);
   emit_signal("player_ready_for_spawn", peer_id);
 }
 
-String NetworkManager::_make_server_session_nonce(int peer_id) {
-  const uint64_t next = _server_next_nonce++;
-  return String::num(peer_id) + "-" + String::num_uint64(next);
+uint64_t NetworkManager::_get_client_identity() {
+  if (_client_identity != 0) {
+    return _client_identity;
+  }
+  const String path = "user://client_identity.bin";
+  if (FileAccess::file_exists(path)) {
+    Ref<FileAccess> file = FileAccess::open(path, FileAccess::READ);
+    if (file.is_valid()) {
+      _client_identity = file->get_64();
+    }
+  }
+  if (_client_identity == 0) {
+    Ref<Crypto> crypto;
+    crypto.instantiate();
+    const PackedByteArray bytes = crypto->generate_random_bytes(8);
+    _client_identity = static_cast<uint64_t>(bytes.decode_u64(0));
+    Ref<FileAccess> file = FileAccess::open(path, FileAccess::WRITE);
+    if (file.is_valid()) {
+      file->store_64(_client_identity);
+    }
+  }
+  return _client_identity;
+}
+
+const PackedByteArray &NetworkManager::_get_client_resume_ticket() {
+  if (!_client_resume_ticket_loaded) {
+    _client_resume_ticket_loaded = true;
+    const String path = "user://resume_ticket.bin";
+    if (FileAccess::file_exists(path)) {
+      Ref<FileAccess> file = FileAccess::open(path, FileAccess::READ);
+      if (file.is_valid()) {
+        _client_resume_ticket = file->get_buffer(k_resume_ticket_size);
+      }
+    }
+  }
+  return _client_resume_ticket;
+}
+
+void NetworkManager::_set_client_resume_ticket(const PackedByteArray &ticket) {
+  _client_resume_ticket = ticket;
+  _client_resume_ticket_loaded = true;
+  Ref<FileAccess> file =
+      FileAccess::open("user://resume_ticket.bin", FileAccess::WRITE);
+  if (file.is_valid()) {
+    file->store_buffer(ticket);
+  }
+}
+
+void NetworkManager::_sample_peer_stats(float delta) {
+  _stats_window_s += delta;
+  if (_stats_window_s < k_stats_sample_interval_s) {
+    return;
+  }
+  const float window = _stats_window_s;
+  _stats_window_s = 0.0f;
+
+  Ref<ENetMultiplayerPeer> enet;
+  Ref<ThreadedENetPeer> threaded;
+  Ref<MultiplayerAPI> mp = NetUtils::get_mp(this);
+  if (mp.is_valid() && mp->has_multiplayer_peer()) {
+    enet = mp->get_multiplayer_peer();
+    threaded = mp->get_multiplayer_peer();
+  }
+  const int my_id = mp.is_valid() && mp->has_multiplayer_peer()
+                        ? mp->get_unique_id()
+                        : 0;
+
+  for (PeerRecord &record : _peers.records()) {
+    PeerLinkStats &link = record.link;
+    link.bytes_in_per_sec = record.window_bytes_in / window;
+    link.bytes_out_per_sec = record.window_bytes_out / window;
+    link.packets_in_per_sec = record.window_packets_in / window;
+    link.packets_out_per_sec = record.window_packets_out / window;
+    record.window_bytes_in = 0;
+    record.window_bytes_out = 0;
+    record.window_packets_in = 0;
+    record.window_packets_out = 0;
+
+    // Clients only hold an ENet peer for the server.
+    if ((enet.is_null() && threaded.is_null()) || record.peer_id == my_id ||
+        (!NetUtils::is_server(this) && record.peer_id != 1)) {
+      continue;
+    }
+    if (threaded.is_valid()) {
+      // Published by the I/O thread, which owns the ENet peers.
+      ThreadedENetPeer::LinkSample sample;
+      if (threaded->get_link_sample(record.peer_id, sample)) {
+        link.rtt_ms = sample.rtt_ms;
+        link.rtt_variance_ms = sample.rtt_variance_ms;
+        link.packet_loss = sample.packet_loss;
+        link.packet_throttle = sample.packet_throttle;
+        record.send_queue.adapt(link.rtt_ms, link.packet_loss);
+      }
+      continue;
+    }
+    Ref<ENetPacketPeer> peer = enet->get_peer(record.peer_id);
+    if (peer.is_null()) {
+      continue;
+    }
+    link.rtt_ms = static_cast<float>(
+        peer->get_statistic(ENetPacketPeer::PEER_ROUND_TRIP_TIME));
+    link.rtt_variance_ms = static_cast<float>(
+        peer->get_statistic(ENetPacketPeer::PEER_ROUND_TRIP_TIME_VARIANCE));
+    link.packet_loss = static_cast<float>(
+        peer->get_statistic(ENetPacketPeer::PEER_PACKET_LOSS) /
+        ENetPacketPeer::PACKET_LOSS_SCALE);
+    link.packet_throttle = static_cast<float>(
+        peer->get_statistic(ENetPacketPeer::PEER_PACKET_THROTTLE) /
+        ENetPacketPeer::PACKET_THROTTLE_SCALE);
+    record.send_queue.adapt(link.rtt_ms, link.packet_loss);
+  }
+
+  // Share of its own budget each backlogged peer got; idle peers are not
+  // competing for anything.
+  const uint64_t now = Time::get_singleton()->get_ticks_usec();
+  double share_sum = 0.0;
+  double share_sq_sum = 0.0;
+  int backlogged = 0;
+  for (PeerRecord &record : _peers.records()) {
+    const PeerSendQueue &queue = record.send_queue;
+    PeerLinkStats &link = record.link;
+    link.send_queue_depth = queue.get_depth();
+    link.send_queued_bytes = queue.get_queued_bytes();
+    link.send_budget_bytes_per_sec = queue.get_budget();
+    link.send_oldest_wait_ms = queue.get_oldest_wait_ms(now);
+    link.send_starved = queue.get_starved_count();
+    if (queue.get_depth() > 0 && queue.get_budget() > 0.0f) {
+      const double share = link.bytes_out_per_sec / queue.get_budget();
+      share_sum += share;
+      share_sq_sum += share * share;
+      backlogged++;
+    }
+  }
+  _send_fairness =
+      share_sq_sum > 0.0
+          ? static_cast<float>(share_sum * share_sum /
+                               (backlogged * share_sq_sum))
+          : 1.0f;
+}
+
+//////// CLOCK ////////////////
+
+void NetworkManager::_update_clock_sync(float delta) {
+  if (!_clock_active || NetUtils::is_server(this)) {
+    return;
+  }
+  _clock_ping_left -= delta;
+  if (_clock_ping_left > 0.0f) {
+    return;
+  }
+  _clock_ping_left = _clock_pings_sent < k_clock_burst_pings
+                         ? k_clock_burst_interval_s
+                         : k_clock_ping_interval_s;
+  _clock_pings_sent++;
+
+  ClockPingMessage ping;
+  ping.client_time_usec = Time::get_singleton()->get_ticks_usec();
+  send_message(1, ping);
+}
+
+void NetworkManager::_on_clock_ping(int sender_id,
+                                    const ClockPingMessage &message) {
+  // Only peers past the hello ack; anyone else is not in a session yet.
+  const PeerRecord *record = _peers.find(sender_id);
+  if (!record || !record->channels_ready) {
+    return;
+  }
+
+  ClockPongMessage pong;
+  pong.client_time_usec = message.client_time_usec;
+  pong.server_time_usec = _get_local_server_time_usec();
+  pong.server_tick = _server_tick;
+  pong.server_tick_usec = _server_tick_usec;
+  pong.tick_rate = static_cast<uint16_t>(
+      Engine::get_singleton()->get_physics_ticks_per_second());
+  send_message(sender_id, pong);
+}
+
+void NetworkManager::_on_clock_pong(int, const ClockPongMessage &message) {
+  if (!_clock_active) {
+    return;
+  }
+  ClockSync::Pong pong;
+  pong.client_send_usec = message.client_time_usec;
+  pong.client_receive_usec = Time::get_singleton()->get_ticks_usec();
+  pong.server_time_usec = message.server_time_usec;
+  pong.server_tick = message.server_tick;
+  pong.server_tick_usec = message.server_tick_usec;
+  pong.tick_rate = message.tick_rate;
+  _clock.add_sample(pong);
+}
+
+uint64_t NetworkManager::_get_local_server_time_usec() const {
+  return Time::get_singleton()->get_ticks_usec() - _server_epoch_usec;
+}
+
+int NetworkManager::get_session_seed() const {
+  return NetUtils::is_server(this) ? _server_seed : _client_session_seed;
+}
+
+uint64_t NetworkManager::get_session_world_id_hash() const {
+  return NetUtils::is_server(this) ? net_hash_string(_server_world_id)
+                                   : _client_world_id_hash;
+}
+
+uint32_t NetworkManager::get_server_tick() const {
+  if (NetUtils::is_server(this)) {
+    return _server_tick;
+  }
+  return _clock.get_server_tick(Time::get_singleton()->get_ticks_usec());
+}
+
+uint64_t NetworkManager::get_server_time_usec() const {
+  if (NetUtils::is_server(this)) {
+    return _get_local_server_time_usec();
+  }
+  return _clock.get_server_time_usec(Time::get_singleton()->get_ticks_usec());
+}
+
+bool NetworkManager::is_clock_synced() const {
+  return NetUtils::is_server(this) || _clock.is_synced();
+}
+
+Dictionary NetworkManager::get_clock_stats() const {
+  Dictionary stats;
+  stats["synced"] = is_clock_synced();
+  stats["server_tick"] = get_server_tick();
+  stats["server_time_usec"] = get_server_time_usec();
+  stats["offset_usec"] = _clock.get_offset_usec();
+  stats["drift_ppm"] = _clock.get_drift_ppm();
+  stats["rtt_usec"] = _clock.get_last_rtt_usec();
+  stats["min_rtt_usec"] = _clock.get_min_rtt_usec();
+  stats["accepted_samples"] = _clock.get_accepted_count();
+  stats["rejected_samples"] = _clock.get_rejected_count();
+  stats["steps"] = _clock.get_step_count();
+  return stats;
+}
+
+//////// STATS ////////////////
+
+void NetworkManager::record_traffic_in(int peer_id, int bytes) {
+  PeerRecord *record = _peers.find(peer_id);
+  if (!record) {
+    return;
+  }
+  record->window_bytes_in += static_cast<uint32_t>(bytes);
+  record->window_packets_in++;
+  record->link.bytes_in += static_cast<uint64_t>(bytes);
+  record->link.packets_in++;
+}
+
+void NetworkManager::record_traffic_out(int peer_id, int bytes) {
+  PeerRecord *record = _peers.find(peer_id);
+  if (!record) {
+    return;
+  }
+  record->window_bytes_out += static_cast<uint32_t>(bytes);
+  record->window_packets_out++;
+  record->link.bytes_out += static_cast<uint64_t>(bytes);
+  record->link.packets_out++;
+}
+
+Dictionary NetworkManager::get_player_list() const {
+  Dictionary players;
+  for (const PeerRecord &record : _peers.records()) {
+    players[record.peer_id] = record.name;
+  }
+  return players;
 }
 
 Array NetworkManager::get_ready_player_ids() const {
   Array ids;
-  for (int peer_id : ready_players) {
-    ids.push_back(peer_id);
+  for (const PeerRecord &record : _peers.records()) {
+    if (record.ready) {
+      ids.push_back(record.peer_id);
+    }
   }
   return ids;
 }
 
+Dictionary NetworkManager::get_peer_stats(int peer_id) const {
+  const PeerRecord *record = _peers.find(peer_id);
+  ERR_FAIL_COND_V_MSG(!record, Dictionary(),
+                      "NetworkManager: unknown peer for stats");
+  return record->to_stats_dictionary();
+}
+
+Array NetworkManager::get_all_peer_stats() const {
+  Array stats;
+  for (const PeerRecord &record : _peers.records()) {
+    stats.push_back(record.to_stats_dictionary());
+  }
+  return stats;
+}
+
+Dictionary NetworkManager::get_send_scheduler_stats() const {
+  const uint64_t now = Time::get_singleton()->get_ticks_usec();
+  int depth = 0;
+  int64_t queued_bytes = 0;
+  int64_t starved = 0;
+  float oldest_wait_ms = 0.0f;
+  uint64_t longest_wait_usec = 0;
+  for (const PeerRecord &record : _peers.records()) {
+    const PeerSendQueue &queue = record.send_queue;
+    depth += queue.get_depth();
+    queued_bytes += queue.get_queued_bytes();
+    starved += static_cast<int64_t>(queue.get_starved_count());
+    oldest_wait_ms = Math::max(oldest_wait_ms, queue.get_oldest_wait_ms(now));
+    longest_wait_usec =
+        std::max(longest_wait_usec, queue.get_longest_wait_usec());
+  }
+
+  Dictionary stats;
+  stats["budget_bytes_per_sec"] = _peer_send_budget;
+  stats["fairness"] = _send_fairness;
+  stats["queue_depth"] = depth;
+  stats["queued_bytes"] = queued_bytes;
+  stats["starved"] = starved;
+  stats["oldest_wait_ms"] = oldest_wait_ms;
+  stats["longest_wait_ms"] = static_cast<double>(longest_wait_usec) / 1000.0;
+  return stats;
+}
+
+int NetworkManager::get_session_channel() const {
+  return _channel_layout.get_channel(NetMessageClass::SESSION);
+}
+void NetworkManager::set_session_channel(int p_channel) {
+  _channel_layout.set_channel(
+      NetMessageClass::SESSION,
+      Math::clamp(p_channel, 0, NetChannelLayout::k_max_channels));
+}
+
+int NetworkManager::get_state_channel() const {
+  return _channel_layout.get_channel(NetMessageClass::STATE);
+}
+void NetworkManager::set_state_channel(int p_channel) {
+  _channel_layout.set_channel(
+      NetMessageClass::STATE,
+      Math::clamp(p_channel, 0, NetChannelLayout::k_max_channels));
+}
+
+int NetworkManager::get_event_channel() const {
+  return _channel_layout.get_channel(NetMessageClass::EVENTS);
+}
+void NetworkManager::set_event_channel(int p_channel) {
+  _channel_layout.set_channel(
+      NetMessageClass::EVENTS,
+      Math::clamp(p_channel, 0, NetChannelLayout::k_max_channels));
+}
+
+int NetworkManager::get_terrain_channel() const {
+  return _channel_layout.get_channel(NetMessageClass::TERRAIN);
+}
+void NetworkManager::set_terrain_channel(int p_channel) {
+  _channel_layout.set_channel(
+      NetMessageClass::TERRAIN,
+      Math::clamp(p_channel, 0, NetChannelLayout::k_max_channels));
+}
+
+void NetworkManager::set_dedicated(bool p_dedicated) {
+  _dedicated = p_dedicated;
+}
+
+bool NetworkManager::get_network_thread() const { return _network_thread; }
+void NetworkManager::set_network_thread(bool p_enabled) {
+  _network_thread = p_enabled;
+}
+
+Ref<ThreadedENetPeer> NetworkManager::_get_threaded_peer() const {
+  Ref<MultiplayerAPI> mp = NetUtils::get_mp(this);
+  if (mp.is_null() || !mp->has_multiplayer_peer()) {
+    return Ref<ThreadedENetPeer>();
+  }
+  return mp->get_multiplayer_peer();
+}
+
+// Lets the I/O thread tell unreliable traffic apart, which it may drop when
+// the game thread falls behind. A channel shared with a reliable class
+// stays reliable.
+void NetworkManager::_configure_threaded_channels(
+    const NetChannelLayout &layout) {
+  Ref<ThreadedENetPeer> threaded = _get_threaded_peer();
+  if (threaded.is_null()) {
+    return;
+  }
+  uint32_t unreliable = 0;
+  uint32_t reliable = 0;
+  for (int i = 0; i < NetChannelLayout::k_class_count; i++) {
+    const NetMessageClass message_class = static_cast<NetMessageClass>(i);
+    const uint32_t bit = 1u << layout.get_channel(message_class);
+    if (net_transfer_mode(message_class) ==
+        MultiplayerPeer::TRANSFER_MODE_RELIABLE) {
+      reliable |= bit;
+    } else {
+      unreliable |= bit;
+    }
+  }
+  for (int channel = 1; channel <= NetChannelLayout::k_max_channels;
+       channel++) {
+    const uint32_t bit = 1u << channel;
+    threaded->set_transfer_channel_unreliable(
+        channel, (unreliable & bit) != 0 && (reliable & bit) == 0);
+  }
+}
+
+Dictionary NetworkManager::get_network_thread_stats() const {
+  Ref<ThreadedENetPeer> threaded = _get_threaded_peer();
+  return threaded.is_valid() ? threaded->get_io_stats() : Dictionary();
+}
+
+bool NetworkManager::get_terrain_dictionary_enabled() const {
+  return _terrain_dictionary_enabled;
+}
+void NetworkManager::set_terrain_dictionary_enabled(bool p_enabled) {
+  _terrain_dictionary_enabled = p_enabled;
+}
+
+uint64_t NetworkManager::get_peer_identity(int peer_id) const {
+  const PeerRecord *record = _peers.find(peer_id);
+  return record ? record->client_identity : 0;
+}
+
+int NetworkManager::get_peer_view_distance(int peer_id) const {
+  if (!NetUtils::is_server(this)) {
+    return _client_view_distance;
+  }
+  const PeerRecord *record = _peers.find(peer_id);
+  return record ? record->view_distance : 0;
+}
+
+int NetworkManager::get_peer_collision_distance(int peer_id) const {
+  if (!NetUtils::is_server(this)) {
+    return _client_collision_distance;
+  }
+  const PeerRecord *record = _peers.find(peer_id);
+  return record ? record->collision_distance : 0;
+}
+
+int NetworkManager::get_max_peer_view_distance() const {
+  return _max_peer_view_distance;
+}
+void NetworkManager::set_max_peer_view_distance(int p_distance) {
+  _max_peer_view_distance = Math::max(p_distance, k_min_view_distance);
+}
+
+int NetworkManager::get_max_peer_collision_distance() const {
+  return _max_peer_collision_distance;
+}
+void NetworkManager::set_max_peer_collision_distance(int p_distance) {
+  _max_peer_collision_distance = Math::max(p_distance, 0);
+}
+
+int NetworkManager::get_requested_view_distance() const {
+  return _requested_view_distance;
+}
+void NetworkManager::set_requested_view_distance(int p_distance) {
+  _requested_view_distance = Math::max(p_distance, 0);
+}
+
+int NetworkManager::get_requested_collision_distance() const {
+  return _requested_collision_distance;
+}
+void NetworkManager::set_requested_collision_distance(int p_distance) {
+  _requested_collision_distance = Math::max(p_distance, 0);
+}
+
+int NetworkManager::get_max_concurrent_joins() const {
+  return _joins.get_max_concurrent();
+}
+void NetworkManager::set_max_concurrent_joins(int p_count) {
+  _joins.set_max_concurrent(Math::max(p_count, 0));
+}
+
+Dictionary NetworkManager::get_join_stats() const {
+  Dictionary stats = _joins.get_stats(Time::get_singleton()->get_ticks_usec());
+  stats["resumed"] = _resumed_joins;
+  stats["rejected_tickets"] = _rejected_tickets;
+  stats["duplicate_hellos"] = _duplicate_hellos;
+  stats["avg_time_to_ready_ms"] =
+      _ready_joins > 0 ? _time_to_ready_usec / 1000.0 / _ready_joins : 0.0;
+  return stats;
+}
+
+void NetworkManager::notify_local_player_spawned() {
+  if (_client_connect_usec == 0 || _client_spawn_usec != 0) {
+    return;
+  }
+  _client_spawn_usec = Time::get_singleton()->get_ticks_usec();
+  LOG("NetworkManager: spawned %d ms after connecting%s",
+      static_cast<int>((_client_spawn_usec - _client_connect_usec) / 1000),
+      _client_resumed ? " (resumed)" : "");
+}
+
+Dictionary NetworkManager::get_join_timing() const {
+  // Milliseconds since start_client(); 0 for steps not reached yet.
+  auto since_connect = [this](uint64_t usec) {
+    return usec > 0 ? (usec - _client_connect_usec) / 1000.0 : 0.0;
+  };
+  Dictionary timing;
+  timing["transport_ms"] = since_connect(_client_transport_usec);
+  timing["accepted_ms"] = since_connect(_client_accepted_usec);
+  timing["spawn_ms"] = since_connect(_client_spawn_usec);
+  timing["handshake_ms"] =
+      _client_accepted_usec > 0 && _client_transport_usec > 0
+          ? (_client_accepted_usec - _client_transport_usec) / 1000.0
+          : 0.0;
+  timing["resumed"] = _client_resumed;
+  return timing;
+}
+
+int NetworkManager::get_peer_send_budget() const { return _peer_send_budget; }
+void NetworkManager::set_peer_send_budget(int p_bytes_per_sec) {
+  _peer_send_budget = Math::max(p_bytes_per_sec, 0);
+}
+
+TerrainCodec NetworkManager::get_peer_terrain_codec(int peer_id) const {
+  if (!NetUtils::is_server(this)) {
+    return _client_terrain_codec;
+  }
+  const PeerRecord *record = _peers.find(peer_id);
+  return record ? record->terrain_codec : TerrainCodec::VOXEL;
+}
+
 void NetworkManager::_bind_methods() {
   ClassDB::bind_method(D_METHOD("start_host", "p_port"),
                        &NetworkManager::start_host);
@@ -440,6 +1257,38 @@ void NetworkManager::_bind_methods() {
                        DEFVAL(0));
   ClassDB::bind_method(D_METHOD("get_ready_player_ids"),
                        &NetworkManager::get_ready_player_ids);
+  ClassDB::bind_method(D_METHOD("get_player_list"),
+                       &NetworkManager::get_player_list);
+  ClassDB::bind_method(D_METHOD("get_peer_stats", "peer_id"),
+                       &NetworkManager::get_peer_stats);
+  ClassDB::bind_method(D_METHOD("get_all_peer_stats"),
+                       &NetworkManager::get_all_peer_stats);
+  ClassDB::bind_method(D_METHOD("get_peer_view_distance", "peer_id"),
+                       &NetworkManager::get_peer_view_distance);
+  ClassDB::bind_method(D_METHOD("get_peer_collision_distance", "peer_id"),
+                       &NetworkManager::get_peer_collision_distance);
+  ClassDB::bind_method(D_METHOD("get_join_stats"),
+                       &NetworkManager::get_join_stats);
+  ClassDB::bind_method(D_METHOD("get_join_timing"),
+                       &NetworkManager::get_join_timing);
+  ClassDB::bind_method(D_METHOD("is_dedicated"),
+                       &NetworkManager::is_dedicated);
+  ClassDB::bind_method(D_METHOD("get_join_queue_position"),
+                       &NetworkManager::get_join_queue_position);
+  ClassDB::bind_method(D_METHOD("get_send_scheduler_stats"),
+                       &NetworkManager::get_send_scheduler_stats);
+  ClassDB::bind_method(D_METHOD("get_network_thread_stats"),
+                       &NetworkManager::get_network_thread_stats);
+  ClassDB::bind_method(D_METHOD("get_session_seed"),
+                       &NetworkManager::get_session_seed);
+  ClassDB::bind_method(D_METHOD("get_server_tick"),
+                       &NetworkManager::get_server_tick);
+  ClassDB::bind_method(D_METHOD("get_server_time_usec"),
+                       &NetworkManager::get_server_time_usec);
+  ClassDB::bind_method(D_METHOD("is_clock_synced"),
+                       &NetworkManager::is_clock_synced);
+  ClassDB::bind_method(D_METHOD("get_clock_stats"),
+                       &NetworkManager::get_clock_stats);
 
   ClassDB::bind_method(D_METHOD("_on_peer_connected", "p_peer_id"),
                        &NetworkManager::_on_peer_connected);
@@ -452,19 +1301,31 @@ void NetworkManager::_bind_methods() {
   ClassDB::bind_method(D_METHOD("_on_server_disconnected"),
                        &NetworkManager::_on_server_disconnected);
 
-  ClassDB::bind_method(
-      D_METHOD("_rpc_client_hello", "protocol_version", "client_build_hash",
-               "requested_world_id", "client_nonce"),
-      &NetworkManager::_rpc_client_hello);
-  ClassDB::bind_method(
-      D_METHOD("_rpc_server_hello_ack", "accepted", "reject_reason",
-               "protocol_version", "authoritative_world_id",
-               "authoritative_seed", "client_nonce", "session_nonce"),
-      &NetworkManager::_rpc_server_hello_ack);
-  ClassDB::bind_method(D_METHOD("_rpc_client_ready", "session_nonce"),
-                       &NetworkManager::_rpc_client_ready);
-  ClassDB::bind_method(D_METHOD("_rpc_server_ready_ack", "session_nonce"),
-                       &NetworkManager::_rpc_server_ready_ack);
+  ClassDB::bind_method(D_METHOD("_on_peer_packet", "p_peer_id", "p_packet"),
+                       &NetworkManager::_on_peer_packet);
+
+  BIND_PROPERTY(NetworkManager, Variant::INT, "session_channel",
+                session_channel);
+  BIND_PROPERTY(NetworkManager, Variant::INT, "state_channel", state_channel);
+  BIND_PROPERTY(NetworkManager, Variant::INT, "event_channel", event_channel);
+  BIND_PROPERTY(NetworkManager, Variant::INT, "terrain_channel",
+                terrain_channel);
+  BIND_PROPERTY(NetworkManager, Variant::BOOL, "terrain_dictionary_enabled",
+                terrain_dictionary_enabled);
+  BIND_PROPERTY(NetworkManager, Variant::BOOL, "network_thread",
+                network_thread);
+  BIND_PROPERTY(NetworkManager, Variant::INT, "peer_send_budget",
+                peer_send_budget);
+  BIND_PROPERTY(NetworkManager, Variant::INT, "max_concurrent_joins",
+                max_concurrent_joins);
+  BIND_PROPERTY(NetworkManager, Variant::INT, "max_peer_view_distance",
+                max_peer_view_distance);
+  BIND_PROPERTY(NetworkManager, Variant::INT, "max_peer_collision_distance",
+                max_peer_collision_distance);
+  BIND_PROPERTY(NetworkManager, Variant::INT, "requested_view_distance",
+                requested_view_distance);
+  BIND_PROPERTY(NetworkManager, Variant::INT, "requested_collision_distance",
+                requested_collision_distance);
 
   ADD_SIGNAL(
       MethodInfo("player_joined", PropertyInfo(Variant::INT, "p_peer_id")));
@@ -473,6 +1334,10 @@ void NetworkManager::_bind_methods() {
   ADD_SIGNAL(MethodInfo("player_ready_for_spawn",
                         PropertyInfo(Variant::INT, "p_peer_id")));
 
+  ADD_SIGNAL(MethodInfo("join_queued", PropertyInfo(Variant::INT, "position"),
+                        PropertyInfo(Variant::INT, "queue_length")));
+  ADD_SIGNAL(MethodInfo("session_seed_received",
+                        PropertyInfo(Variant::INT, "seed")));
   ADD_SIGNAL(MethodInfo("connection_success"));
   ADD_SIGNAL(MethodInfo("connection_failed"));
   ADD_SIGNAL(MethodInfo("server_disconnected"));
@@ -1,10 +1,17 @@
 #pragma once
+#include "core/join_admission.h"
+#include "core/peer_table.h"
+#include "core/resume_ticket.h"
+#include "core/threaded_enet_peer.h"
+#include "net/clock_sync.h"
+#include "net/net_dispatcher.h"
+#include "net/net_messages.h"
+
 #include <godot_cpp/classes/multiplayer_api.hpp>
+#include <godot_cpp/classes/multiplayer_peer.hpp>
 #include <godot_cpp/classes/node.hpp>
 #include <godot_cpp/variant/array.hpp>
 #include <godot_cpp/variant/dictionary.hpp>
-#include <unordered_map>
-#include <unordered_set>
 
 using namespace godot;
 
@@ -14,63 +21,126 @@ class NetworkManager : public Node {
   GDCLASS(NetworkManager, Node)
 
 private:
-  enum class ClientHandshakeStage {
-    NONE = 0,
-    WAIT_HELLO_ACK = 1,
-    WAIT_READY_ACK = 2
-  };
-
-  struct ServerHandshakePeerState {
-    float timeout_s = 0.0f;
-    bool hello_received = false;
-    bool ready_received = false;
-    int protocol_version = 0;
-    String client_build_hash;
-    String requested_world_id;
-    String client_nonce;
-    String session_nonce;
-  };
-
-  static constexpr int k_protocol_version = 1;
+  enum class ClientHandshakeStage { NONE = 0, WAIT_HELLO_ACK = 1 };
+
+  static constexpr int k_protocol_version = 10;
   static constexpr float k_server_hello_timeout_s = 5.0f;
-  static constexpr float k_server_ready_timeout_s = 10.0f;
   static constexpr float k_client_handshake_timeout_s = 10.0f;
+  // Per queue position update while waiting for a join slot.
+  static constexpr float k_client_join_queue_timeout_s = 60.0f;
+  static constexpr float k_stats_sample_interval_s = 0.5f;
+  // A burst of pings right after the hello ack, then a slow keepalive.
+  static constexpr int k_clock_burst_pings = 8;
+  static constexpr float k_clock_burst_interval_s = 0.1f;
+  static constexpr float k_clock_ping_interval_s = 1.0f;
+  // Terrain radii: the server never grants less than the minimum; the
+  // auto request scales the ceiling by how well we hold the frame target.
+  static constexpr int k_min_view_distance = 32;
+  static constexpr int k_auto_view_distance = 128;
+  static constexpr int k_auto_collision_distance = 48;
+  static constexpr float k_target_frame_ms = 1000.0f / 60.0f;
 
-  Dictionary connected_players;
-  std::unordered_set<int> ready_players;
-  std::unordered_map<int, ServerHandshakePeerState> _server_handshakes;
+  PeerTable _peers;
+  NetDispatcher _dispatcher;
+  // Layout the server announces to clients, and the one a client received.
+  NetChannelLayout _channel_layout;
+  NetChannelLayout _client_channel_layout;
+  bool _client_channels_ready = false;
+  // Off forces TerrainCodec::VOXEL, on either side.
+  bool _terrain_dictionary_enabled = true;
+  TerrainCodec _client_terrain_codec = TerrainCodec::VOXEL;
+  // Server policy for the per-peer terrain radii, in voxels.
+  int _max_peer_view_distance = 96;
+  int _max_peer_collision_distance = 64;
+  // Client request; 0 derives it from the measured frame time.
+  int _requested_view_distance = 0;
+  int _requested_collision_distance = 0;
+  int _client_view_distance = 0;
+  int _client_collision_distance = 0;
+  float _frame_ms_average = 0.0f;
+  float _stats_window_s = 0.0f;
+  // Per-peer bulk send budget in bytes per second; 0 sends unpaced.
+  int _peer_send_budget = 256 * 1024;
+  // Jain's index over the budget share each backlogged peer got in the
+  // last sampling window: 1 = even, 1/n = one peer got everything.
+  float _send_fairness = 1.0f;
+  std::vector<PeerSendQueue::Packet> _send_ready;
 
   String _server_world_id;
   int _server_seed = 0;
+  // Dedicated server: no local host player (peer 1) and nothing rendered.
+  bool _dedicated = false;
+  // Service ENet on its own thread (ThreadedENetPeer) instead of in the
+  // SceneTree's multiplayer poll.
+  bool _network_thread = false;
 
   String _client_requested_world_id;
   int _client_expected_seed = 0;
+  int _client_session_seed = 0;
+  uint64_t _client_world_id_hash = 0;
   String _client_build_hash = "dev";
-  String _client_nonce;
-  String _client_session_nonce;
+  uint64_t _client_nonce = 0;
+  uint64_t _client_identity = 0;
+  PackedByteArray _client_resume_ticket;
+  bool _client_resume_ticket_loaded = false;
   float _client_handshake_timeout_left = 0.0f;
   ClientHandshakeStage _client_handshake_stage = ClientHandshakeStage::NONE;
+  // Milestones of the current join (ticks usec, 0 = not reached yet).
+  uint64_t _client_connect_usec = 0;
+  uint64_t _client_transport_usec = 0;
+  uint64_t _client_accepted_usec = 0;
+  uint64_t _client_spawn_usec = 0;
+  bool _client_resumed = false;
+
+  ResumeTicketIssuer _tickets;
+  int64_t _resumed_joins = 0;
+  int64_t _rejected_tickets = 0;
+  // Hellos from peers already ready or still queued; ignored.
+  int64_t _duplicate_hellos = 0;
+  // Transport connect to ready (spawned), over every remote join.
+  uint64_t _time_to_ready_usec = 0;
+  int64_t _ready_joins = 0;
+  JoinAdmission _joins;
+  std::vector<int> _admitted_joins;
+  // Position in the server's join queue, 0 when not queued.
+  int _client_join_queue_position = 0;
 
-  uint64_t _server_next_nonce = 1;
+  // Server timeline: microseconds since start_host and physics ticks.
+  uint64_t _server_epoch_usec = 0;
+  uint32_t _server_tick = 0;
+  uint64_t _server_tick_usec = 0;
+
+  ClockSync _clock;
+  bool _clock_active = false;
+  int _clock_pings_sent = 0;
+  float _clock_ping_left = 0.0f;
 
   void _reset_client_handshake_state();
   void _start_client_handshake();
   void _disconnect_peer(int peer_id, const String &reason);
   void _close_client_connection(const String &reason);
   void _mark_peer_ready(int peer_id);
-  String _make_server_session_nonce(int peer_id);
-
-  void _rpc_client_hello(int protocol_version, const String &client_build_hash,
-                         const String &requested_world_id,
-                         const String &client_nonce);
-  void _rpc_server_hello_ack(bool accepted, const String &reject_reason,
-                             int protocol_version,
-                             const String &authoritative_world_id,
-                             int authoritative_seed,
-                             const String &client_nonce,
-                             const String &session_nonce);
-  void _rpc_client_ready(const String &session_nonce);
-  void _rpc_server_ready_ack(const String &session_nonce);
+  uint64_t _get_client_identity();
+  const PackedByteArray &_get_client_resume_ticket();
+  void _set_client_resume_ticket(const PackedByteArray &ticket);
+  void _sample_peer_stats(float delta);
+  Ref<ThreadedENetPeer> _get_threaded_peer() const;
+  void _configure_threaded_channels(const NetChannelLayout &layout);
+  void _flush_send_queues(float delta);
+  void _update_join_admission();
+  void _send_join_queue_positions();
+  Error _send_now(int peer_id, const PackedByteArray &packet,
+                  NetMessageClass message_class);
+  void _update_clock_sync(float delta);
+  uint64_t _get_local_server_time_usec() const;
+
+  void _bind_message_handlers();
+  void _on_client_hello(int sender_id, const ClientHelloMessage &message);
+  void _on_server_hello_ack(int sender_id,
+                            const ServerHelloAckMessage &message);
+  void _on_join_queued(int sender_id, const JoinQueuedMessage &message);
+  void _on_clock_ping(int sender_id, const ClockPingMessage &message);
+  void _on_clock_pong(int sender_id, const ClockPongMessage &message);
 
 protected:
   static void _bind_methods();
@@ -78,8 +148,17 @@ protected:
 public:
   void _ready() override;
   void _process(double delta) override;
+  void _physics_process(double delta) override;
 
   bool start_host(int port);
+  // Set before start_host(); see DedicatedServer.
+  bool is_dedicated() const { return _dedicated; }
+  void set_dedicated(bool p_dedicated);
+  // Set before start_host()/start_client().
+  bool get_network_thread() const;
+  void set_network_thread(bool p_enabled);
+  // ThreadedENetPeer ring depths and drop counters; empty without it.
+  Dictionary get_network_thread_stats() const;
   bool start_client(const String &address, int port);
   void configure_server_handshake_context(const String &world_id, int seed);
   void configure_client_handshake_context(const String &requested_world_id,
@@ -90,10 +169,97 @@ public:
   void _on_connected_to_server();
   void _on_connection_failed();
   void _on_server_disconnected();
+  void _on_peer_packet(int p_peer_id, const PackedByteArray &p_packet);
 
-  inline Dictionary get_player_list() const { return connected_players; }
+  // Typed messages: encoded from the schema and sent as raw bytes with the
+  // message's transfer mode. Handlers are registered on the dispatcher.
+  template <typename T> Error send_message(int peer_id, const T &message) {
+    return send_packet(peer_id, net_encode(message), T::k_class);
+  }
+  Error send_packet(int peer_id, const PackedByteArray &packet,
+                    NetMessageClass message_class);
+  // Bulk traffic: on the server it waits in the peer's PeerSendQueue and
+  // goes out within the peer's budget, higher `priority` first. Everything
+  // sent with send_message() is charged to the same budget.
+  template <typename T>
+  Error queue_message(int peer_id, const T &message, float priority) {
+    return queue_packet(peer_id, net_encode(message), T::k_class, priority);
+  }
+  Error queue_packet(int peer_id, const PackedByteArray &packet,
+                     NetMessageClass message_class, float priority);
+  int64_t get_peer_queued_bytes(int peer_id) const;
+  NetDispatcher &get_dispatcher() { return _dispatcher; }
+
+  // ENet channel a message class uses towards `peer_id` (0 until the
+  // handshake delivered the layout).
+  int get_peer_channel(int peer_id, NetMessageClass message_class) const;
+  const NetChannelLayout &get_channel_layout() const;
+
+  // Server-side layout; takes effect for the next start_host().
+  int get_session_channel() const;
+  void set_session_channel(int p_channel);
+  int get_state_channel() const;
+  void set_state_channel(int p_channel);
+  int get_event_channel() const;
+  void set_event_channel(int p_channel);
+  int get_terrain_channel() const;
+  void set_terrain_channel(int p_channel);
+  bool get_terrain_dictionary_enabled() const;
+  void set_terrain_dictionary_enabled(bool p_enabled);
+  // Server: the codec agreed with `peer_id`. Client: the one the server
+  // announced (peer_id is ignored).
+  TerrainCodec get_peer_terrain_codec(int peer_id) const;
+  // Terrain radii (voxels) agreed with `peer_id` on the server, granted to
+  // us on clients; 0 before the handshake set them.
+  // Server: the persistent identity `peer_id` sent in its hello, 0 if none.
+  uint64_t get_peer_identity(int peer_id) const;
+  int get_peer_view_distance(int peer_id) const;
+  int get_peer_collision_distance(int peer_id) const;
+  int get_max_peer_view_distance() const;
+  void set_max_peer_view_distance(int p_distance);
+  int get_max_peer_collision_distance() const;
+  void set_max_peer_collision_distance(int p_distance);
+  int get_requested_view_distance() const;
+  void set_requested_view_distance(int p_distance);
+  int get_requested_collision_distance() const;
+  void set_requested_collision_distance(int p_distance);
+  int get_peer_send_budget() const;
+  void set_peer_send_budget(int p_bytes_per_sec);
+  int get_max_concurrent_joins() const;
+  void set_max_concurrent_joins(int p_count);
+  int get_join_queue_position() const { return _client_join_queue_position; }
+  // Server: JoinAdmission's numbers plus resumptions and time to ready.
+  Dictionary get_join_stats() const;
+  // Client: called when our own player node arrives (PlayerSpawner).
+  void notify_local_player_spawned();
+  // Client: how long each step of the last join took, in milliseconds.
+  Dictionary get_join_timing() const;
+
+  Dictionary get_player_list() const;
   Array get_ready_player_ids() const;
+
+  // Link statistics; the bulk call returns one dictionary per known peer.
+  Dictionary get_peer_stats(int peer_id) const;
+  Array get_all_peer_stats() const;
+  // Scheduler totals across peers, including the fairness index.
+  Dictionary get_send_scheduler_stats() const;
+  const PeerTable &get_peer_table() const { return _peers; }
+  // Application-level traffic accounting for the per-peer byte rates.
+  void record_traffic_in(int peer_id, int bytes);
+  void record_traffic_out(int peer_id, int bytes);
   int get_protocol_version() const { return k_protocol_version; }
+  // World seed of the running session: ours on the server, the one from
+  // the hello ack on clients (0 before it arrived).
+  int get_session_seed() const;
+  uint64_t get_session_world_id_hash() const;
+
+  // Shared timeline. Authoritative on the server; on clients an estimate
+  // that reads 0 until the first pong arrived.
+  uint32_t get_server_tick() const;
+  uint64_t get_server_time_usec() const;
+  bool is_clock_synced() const;
+  const ClockSync &get_clock_sync() const { return _clock; }
+  Dictionary get_clock_stats() const;
 };
 
 } // namespace morphic
@@ -0,0 +1,74 @@
+#include "core/peer_table.h"
+
+namespace morphic {
+
+Dictionary PeerRecord::to_stats_dictionary() const {
+  Dictionary stats;
+  stats["peer_id"] = peer_id;
+  stats["ready"] = ready;
+  stats["terrain_codec"] = static_cast<int>(terrain_codec);
+  stats["view_distance"] = view_distance;
+  stats["collision_distance"] = collision_distance;
+  stats["rtt_ms"] = link.rtt_ms;
+  stats["rtt_variance_ms"] = link.rtt_variance_ms;
+  stats["packet_loss"] = link.packet_loss;
+  stats["packet_throttle"] = link.packet_throttle;
+  stats["bytes_in_per_sec"] = link.bytes_in_per_sec;
+  stats["bytes_out_per_sec"] = link.bytes_out_per_sec;
+  stats["packets_in_per_sec"] = link.packets_in_per_sec;
+  stats["packets_out_per_sec"] = link.packets_out_per_sec;
+  stats["send_queue_depth"] = link.send_queue_depth;
+  stats["send_queued_bytes"] = link.send_queued_bytes;
+  stats["send_budget_bytes_per_sec"] = link.send_budget_bytes_per_sec;
+  stats["send_oldest_wait_ms"] = link.send_oldest_wait_ms;
+  stats["send_starved"] = static_cast<int64_t>(link.send_starved);
+  stats["bytes_in"] = static_cast<int64_t>(link.bytes_in);
+  stats["bytes_out"] = static_cast<int64_t>(link.bytes_out);
+  stats["packets_in"] = static_cast<int64_t>(link.packets_in);
+  stats["packets_out"] = static_cast<int64_t>(link.packets_out);
+  return stats;
+}
+
+PeerRecord *PeerTable::find(int peer_id) {
+  auto it = _index.find(peer_id);
+  return it != _index.end() ? &_records[it->second] : nullptr;
+}
+
+const PeerRecord *PeerTable::find(int peer_id) const {
+  auto it = _index.find(peer_id);
+  return it != _index.end() ? &_records[it->second] : nullptr;
+}
+
+PeerRecord &PeerTable::add(int peer_id) {
+  PeerRecord *existing = find(peer_id);
+  if (existing) {
+    return *existing;
+  }
+  _index[peer_id] = static_cast<uint32_t>(_records.size());
+  _records.emplace_back();
+  _records.back().peer_id = peer_id;
+  return _records.back();
+}
+
+void PeerTable::remove(int peer_id) {
+  auto it = _index.find(peer_id);
+  if (it == _index.end()) {
+    return;
+  }
+  const uint32_t slot = it->second;
+  _index.erase(it);
+
+  const uint32_t last = static_cast<uint32_t>(_records.size() - 1);
+  if (slot != last) {
+    _records[slot] = std::move(_records[last]);
+    _index[_records[slot].peer_id] = slot;
+  }
+  _records.pop_back();
+}
+
+void PeerTable::clear() {
+  _records.clear();
+  _index.clear();
+}
+
+} // namespace morphic
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "net/net_messages.h"
+#include "net/peer_send_queue.h"
+
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using namespace godot;
+
+namespace morphic {
+
+// Server-side handshake progress of one peer (see NetworkManager).
+struct PeerHandshakeState {
+  float timeout_s = 0.0f;
+  // Waiting for a join slot (JoinAdmission); the hello is answered once
+  // admitted, and the timeout does not run meanwhile.
+  bool queued = false;
+  ClientHelloMessage queued_hello;
+};
+
+// Link quality of one peer. RTT, loss and throttle come from ENet's peer
+// statistics; byte/packet rates are counted by NetworkManager for the
+// traffic routed through it and averaged over the sampling window.
+struct PeerLinkStats {
+  float rtt_ms = 0.0f;
+  float rtt_variance_ms = 0.0f;
+  // 0..1, ENet's smoothed packet loss estimate.
+  float packet_loss = 0.0f;
+  // 0..1, ENet's unreliable packet throttle; drops under congestion.
+  float packet_throttle = 1.0f;
+  float bytes_in_per_sec = 0.0f;
+  float bytes_out_per_sec = 0.0f;
+  float packets_in_per_sec = 0.0f;
+  float packets_out_per_sec = 0.0f;
+  // Messages waiting in our own outgoing queues for this peer. ENet does
+  // not expose its per-peer queue, so this covers what we buffer above it.
+  int send_queue_depth = 0;
+  int64_t send_queued_bytes = 0;
+  // Current (adapted) send budget and how long the oldest message waits.
+  float send_budget_bytes_per_sec = 0.0f;
+  float send_oldest_wait_ms = 0.0f;
+  // Messages that waited longer than PeerSendQueue::k_starvation_usec.
+  uint64_t send_starved = 0;
+
+  uint64_t bytes_in = 0;
+  uint64_t bytes_out = 0;
+  uint64_t packets_in = 0;
+  uint64_t packets_out = 0;
+};
+
+struct PeerRecord {
+  int peer_id = 0;
+  String name;
+  bool ready = false;
+  bool handshake_pending = false;
+  // Set once the server announced its channel layout to this peer; until
+  // then everything goes out on the default channel.
+  bool channels_ready = false;
+  // Agreed in the hello; how this peer's terrain blocks are encoded.
+  TerrainCodec terrain_codec = TerrainCodec::VOXEL;
+  // Agreed in the hello; terrain radii (voxels) loaded for this peer.
+  int view_distance = 0;
+  int collision_distance = 0;
+  // From the hello; stays the same when the client reconnects.
+  uint64_t client_identity = 0;
+  // Server: transport connect, for the time it took to become ready.
+  uint64_t connected_usec = 0;
+  PeerHandshakeState handshake;
+  PeerLinkStats link;
+  // Server: paced bulk traffic to this peer.
+  PeerSendQueue send_queue;
+
+  // Counters of the current sampling window.
+  uint32_t window_bytes_in = 0;
+  uint32_t window_bytes_out = 0;
+  uint32_t window_packets_in = 0;
+  uint32_t window_packets_out = 0;
+
+  Dictionary to_stats_dictionary() const;
+};
+
+// Dense table of connected peers: records live contiguously and are
+// removed by swapping with the last one, with a peer id -> slot index on
+// the side. Pointers returned by find()/add() stay valid until the next
+// add() or remove().
+class PeerTable {
+public:
+  PeerRecord *find(int peer_id);
+  const PeerRecord *find(int peer_id) const;
+  // Returns the existing record when the peer is already known.
+  PeerRecord &add(int peer_id);
+  void remove(int peer_id);
+  void clear();
+
+  int size() const { return static_cast<int>(_records.size()); }
+  std::vector<PeerRecord> &records() { return _records; }
+  const std::vector<PeerRecord> &records() const { return _records; }
+
+private:
+  std::vector<PeerRecord> _records;
+  std::unordered_map<int, uint32_t> _index;
+};
+
+} // namespace morphic
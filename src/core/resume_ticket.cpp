@@ -0,0 +1,72 @@
+#include "core/resume_ticket.h"
+
+#include <godot_cpp/classes/hashing_context.hpp>
+
+namespace morphic {
+
+namespace {
+constexpr int k_key_size = 32;
+} // namespace
+
+void ResumeTicketIssuer::reset_key() {
+  if (_crypto.is_null()) {
+    _crypto.instantiate();
+  }
+  _key = _crypto->generate_random_bytes(k_key_size);
+}
+
+PackedByteArray ResumeTicketIssuer::sign(const PackedByteArray &body) const {
+  PackedByteArray mac =
+      _crypto->hmac_digest(HashingContext::HASH_SHA256, _key, body);
+  mac.resize(k_mac_size);
+  return mac;
+}
+
+PackedByteArray ResumeTicketIssuer::issue(uint64_t client_identity,
+                                          uint64_t world_id_hash,
+                                          uint64_t now_unix) const {
+  ERR_FAIL_COND_V_MSG(!has_key(), PackedByteArray(),
+                      "ResumeTicketIssuer: no key");
+
+  PackedByteArray ticket;
+  ticket.resize(k_body_size);
+  NetWriter writer(ticket.ptrw(), k_body_size);
+  writer.write_le(client_identity);
+  writer.write_le(world_id_hash);
+  writer.write_le(now_unix + static_cast<uint64_t>(k_lifetime_s));
+
+  ticket.append_array(sign(ticket));
+  return ticket;
+}
+
+ResumeTicketIssuer::Result
+ResumeTicketIssuer::verify(const PackedByteArray &bytes, uint64_t now_unix,
+                           ResumeTicket &r_ticket) const {
+  if (!has_key() || bytes.size() != k_resume_ticket_size) {
+    return Result::MALFORMED;
+  }
+
+  const PackedByteArray body = bytes.slice(0, k_body_size);
+  const PackedByteArray mac = sign(body);
+  // Constant time, so the comparison does not leak how much matched.
+  uint8_t diff = 0;
+  for (int i = 0; i < k_mac_size; i++) {
+    diff |= mac[i] ^ bytes[k_body_size + i];
+  }
+  if (diff != 0) {
+    return Result::BAD_SIGNATURE;
+  }
+
+  NetReader reader(body.ptr(), k_body_size);
+  ResumeTicket ticket;
+  reader.read_le(ticket.client_identity);
+  reader.read_le(ticket.world_id_hash);
+  reader.read_le(ticket.expires_unix);
+  if (ticket.expires_unix <= now_unix) {
+    return Result::EXPIRED;
+  }
+  r_ticket = ticket;
+  return Result::VALID;
+}
+
+} // namespace morphic
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "net/net_messages.h"
+
+#include <godot_cpp/classes/crypto.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+
+#include <cstdint>
+
+using namespace godot;
+
+namespace morphic {
+
+// What a resumption ticket vouches for.
+struct ResumeTicket {
+  uint64_t client_identity = 0;
+  uint64_t world_id_hash = 0;
+  // Unix seconds.
+  uint64_t expires_unix = 0;
+};
+
+// Server-side issuer of resumption tickets. Every accepted hello gets a
+// fresh ticket in its ack; the client presents it in its next hello. A
+// valid ticket proves the client joined this server before, so the join
+// skips the admission queue, and the identity in the ticket replaces the
+// one the hello claims.
+//
+// A ticket is the body followed by a truncated HMAC-SHA256 of it. The key
+// is generated per server run: a restart invalidates every ticket and
+// clients fall back to a plain join.
+class ResumeTicketIssuer {
+public:
+  static constexpr int k_body_size = 24;
+  static constexpr int k_mac_size = 16;
+  static constexpr int64_t k_lifetime_s = 60 * 60;
+  static_assert(k_body_size + k_mac_size == k_resume_ticket_size,
+                "ticket size is part of the hello schema");
+
+  enum class Result { VALID, MALFORMED, BAD_SIGNATURE, EXPIRED };
+
+  // Generates a new key; tickets issued before stop verifying.
+  void reset_key();
+  bool has_key() const { return !_key.is_empty(); }
+
+  PackedByteArray issue(uint64_t client_identity, uint64_t world_id_hash,
+                        uint64_t now_unix) const;
+  Result verify(const PackedByteArray &bytes, uint64_t now_unix,
+                ResumeTicket &r_ticket) const;
+
+private:
+  Ref<Crypto> _crypto;
+  PackedByteArray _key;
+
+  PackedByteArray sign(const PackedByteArray &body) const;
+};
+
+} // namespace morphic
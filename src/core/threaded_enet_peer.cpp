@@ -0,0 +1,563 @@
+#include "core/threaded_enet_peer.h"
+
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+
+#include <cstring>
+#include <utility>
+
+using namespace godot;
+
+namespace morphic {
+
+namespace {
+template <typename T>
+void raise_high_water(std::atomic<uint32_t> &high_water, const T &ring) {
+  const uint32_t depth = ring.size();
+  if (depth > high_water.load(std::memory_order_relaxed)) {
+    high_water.store(depth, std::memory_order_relaxed);
+  }
+}
+} // namespace
+
+ThreadedENetPeer::ThreadedENetPeer()
+    : _inbound(k_default_ring_capacity), _outbound(k_default_ring_capacity) {}
+
+ThreadedENetPeer::~ThreadedENetPeer() { stop_io_thread(); }
+
+Error ThreadedENetPeer::create_server(int p_port, int p_max_clients,
+                                      int p_channel_count) {
+  ERR_FAIL_COND_V_MSG(_status != CONNECTION_DISCONNECTED, ERR_ALREADY_IN_USE,
+                      "ThreadedENetPeer: already active");
+  // A session the remote side ended still has its thread and queues.
+  _close();
+  _connection.instantiate();
+  const Error err = _connection->create_host_bound(
+      "*", p_port, p_max_clients, p_channel_count + SYSCH_MAX);
+  if (err != OK) {
+    _connection.unref();
+    return err;
+  }
+
+  _server = true;
+  _unique_id = 1;
+  _status = CONNECTION_CONNECTED;
+  start_io_thread();
+  return OK;
+}
+
+Error ThreadedENetPeer::create_client(const String &p_address, int p_port,
+                                      int p_channel_count) {
+  ERR_FAIL_COND_V_MSG(_status != CONNECTION_DISCONNECTED, ERR_ALREADY_IN_USE,
+                      "ThreadedENetPeer: already active");
+  // A session the remote side ended still has its thread and queues.
+  _close();
+  _connection.instantiate();
+  Error err = _connection->create_host(1, p_channel_count + SYSCH_MAX);
+  if (err != OK) {
+    _connection.unref();
+    return err;
+  }
+
+  // As ENetMultiplayerPeer: the client picks its id and sends it as the
+  // connect data.
+  _unique_id = static_cast<int32_t>(generate_unique_id());
+  _server_peer = _connection->connect_to_host(
+      p_address, p_port, p_channel_count + SYSCH_MAX, _unique_id);
+  if (_server_peer.is_null()) {
+    _connection->destroy();
+    _connection.unref();
+    _unique_id = 0;
+    return ERR_CANT_CREATE;
+  }
+  _io_peers[1] = _server_peer;
+  _io_peer_ids[_server_peer->get_instance_id()] = 1;
+
+  _server = false;
+  _status = CONNECTION_CONNECTING;
+  start_io_thread();
+  return OK;
+}
+
+void ThreadedENetPeer::set_transfer_channel_unreliable(int p_channel,
+                                                       bool p_unreliable) {
+  ERR_FAIL_COND(p_channel < 1 || p_channel + SYSCH_MAX - 1 >= 32);
+  const uint32_t bit = 1u << (p_channel + SYSCH_MAX - 1);
+  if (p_unreliable) {
+    _unreliable_channels.fetch_or(bit, std::memory_order_relaxed);
+  } else {
+    _unreliable_channels.fetch_and(~bit, std::memory_order_relaxed);
+  }
+}
+
+bool ThreadedENetPeer::is_enet_channel_unreliable(int p_channel) const {
+  if (p_channel == SYSCH_UNRELIABLE) {
+    return true;
+  }
+  return p_channel >= SYSCH_MAX && p_channel < 32 &&
+         (_unreliable_channels.load(std::memory_order_relaxed) &
+          (1u << p_channel)) != 0;
+}
+
+Dictionary ThreadedENetPeer::get_io_stats() const {
+  Dictionary stats;
+  stats["ring_capacity"] = static_cast<int64_t>(_inbound.capacity());
+  stats["inbound_depth"] = static_cast<int64_t>(_inbound.size());
+  stats["inbound_high_water"] =
+      static_cast<int64_t>(_inbound_stats.high_water.load());
+  stats["inbound_dropped"] = static_cast<int64_t>(_inbound_stats.dropped);
+  stats["inbound_deferred"] = static_cast<int64_t>(_inbound_stats.deferred);
+  stats["outbound_depth"] = static_cast<int64_t>(_outbound.size());
+  stats["outbound_high_water"] =
+      static_cast<int64_t>(_outbound_stats.high_water.load());
+  stats["outbound_dropped"] = static_cast<int64_t>(_outbound_stats.dropped);
+  stats["outbound_deferred"] = static_cast<int64_t>(_outbound_stats.deferred);
+  stats["outbound_backlog"] = static_cast<int64_t>(_outbound_backlog.size());
+  stats["pending_packets"] = static_cast<int64_t>(_incoming.size());
+  return stats;
+}
+
+bool ThreadedENetPeer::get_link_sample(int p_peer_id,
+                                       LinkSample &r_sample) const {
+  std::lock_guard<std::mutex> lock(_link_mutex);
+  auto it = _links.find(p_peer_id);
+  if (it == _links.end()) {
+    return false;
+  }
+  r_sample = it->second;
+  return true;
+}
+
+//////// GAME THREAD ////////////////
+
+void ThreadedENetPeer::start_io_thread() {
+  _next_link_sample_usec = 0;
+  _running.store(true, std::memory_order_release);
+  _thread = std::thread(&ThreadedENetPeer::io_loop, this);
+}
+
+void ThreadedENetPeer::stop_io_thread() {
+  if (!_thread.joinable()) {
+    return;
+  }
+  _running.store(false, std::memory_order_release);
+  _thread.join();
+}
+
+void ThreadedENetPeer::push_command(Command &&command) {
+  // Keep order: once something waits in the backlog, everything queues
+  // behind it.
+  if (_outbound_backlog.empty() && _outbound.try_push(std::move(command))) {
+    raise_high_water(_outbound_stats.high_water, _outbound);
+    return;
+  }
+  if (command.type == Command::SEND &&
+      (command.flags & ENetPacketPeer::FLAG_RELIABLE) == 0) {
+    _outbound_stats.dropped++;
+    return;
+  }
+  _outbound_backlog.push_back(std::move(command));
+  _outbound_stats.deferred++;
+}
+
+void ThreadedENetPeer::_poll() {
+  while (!_outbound_backlog.empty() &&
+         _outbound.try_push(std::move(_outbound_backlog.front()))) {
+    _outbound_backlog.pop_front();
+  }
+
+  Event event;
+  while (_inbound.try_pop(event)) {
+    switch (event.type) {
+    case Event::CONNECTED:
+      if (!_server) {
+        _status = CONNECTION_CONNECTED;
+      }
+      _connected[event.peer_id] = true;
+      emit_signal("peer_connected", event.peer_id);
+      break;
+    case Event::DISCONNECTED:
+      if (!_server) {
+        // Never connected: SceneMultiplayer reports a failed connection.
+        const bool was_connected = _status == CONNECTION_CONNECTED;
+        _status = CONNECTION_DISCONNECTED;
+        _connected.clear();
+        if (was_connected) {
+          emit_signal("peer_disconnected", 1);
+        }
+      } else if (_connected.erase(event.peer_id) > 0) {
+        emit_signal("peer_disconnected", event.peer_id);
+      }
+      break;
+    case Event::PACKET:
+      // Packets still in flight from a peer we force-disconnected.
+      if (_connected.count(event.peer_id) > 0) {
+        _incoming.push_back(std::move(event));
+      }
+      break;
+    }
+  }
+}
+
+Error ThreadedENetPeer::_get_packet(const uint8_t **r_buffer,
+                                    int32_t *r_buffer_size) {
+  ERR_FAIL_COND_V_MSG(_incoming.empty(), ERR_UNAVAILABLE,
+                      "ThreadedENetPeer: no incoming packets available");
+  // Held until the next call, as the caller reads through the pointer.
+  _current = std::move(_incoming.front());
+  _incoming.pop_front();
+  *r_buffer = _current.data.ptr();
+  *r_buffer_size = static_cast<int32_t>(_current.data.size());
+  return OK;
+}
+
+Error ThreadedENetPeer::_put_packet(const uint8_t *p_buffer,
+                                    int32_t p_buffer_size) {
+  ERR_FAIL_COND_V_MSG(_status != CONNECTION_CONNECTED, ERR_UNCONFIGURED,
+                      "ThreadedENetPeer: not connected");
+  ERR_FAIL_COND_V(p_buffer_size < 0 || p_buffer_size > k_max_packet_size,
+                  ERR_INVALID_PARAMETER);
+  if (_server && _target_peer > 0) {
+    ERR_FAIL_COND_V_MSG(_connected.count(_target_peer) == 0,
+                        ERR_INVALID_PARAMETER,
+                        "ThreadedENetPeer: invalid target peer");
+  }
+
+  // ENetMultiplayerPeer's mapping of transfer modes to flags and channels.
+  Command command;
+  command.type = Command::SEND;
+  command.target = _target_peer;
+  switch (_transfer_mode) {
+  case TRANSFER_MODE_UNRELIABLE:
+    command.flags = ENetPacketPeer::FLAG_UNSEQUENCED |
+                    ENetPacketPeer::FLAG_UNRELIABLE_FRAGMENT;
+    command.channel = SYSCH_UNRELIABLE;
+    break;
+  case TRANSFER_MODE_UNRELIABLE_ORDERED:
+    command.flags = ENetPacketPeer::FLAG_UNRELIABLE_FRAGMENT;
+    command.channel = SYSCH_UNRELIABLE;
+    break;
+  case TRANSFER_MODE_RELIABLE:
+    command.flags = ENetPacketPeer::FLAG_RELIABLE;
+    command.channel = SYSCH_RELIABLE;
+    break;
+  }
+  if (_transfer_channel > 0) {
+    command.channel = SYSCH_MAX + _transfer_channel - 1;
+  }
+  command.data.resize(p_buffer_size);
+  if (p_buffer_size > 0) {
+    memcpy(command.data.ptrw(), p_buffer, p_buffer_size);
+  }
+  push_command(std::move(command));
+  return OK;
+}
+
+int32_t ThreadedENetPeer::_get_available_packet_count() const {
+  return static_cast<int32_t>(_incoming.size());
+}
+
+int32_t ThreadedENetPeer::_get_max_packet_size() const {
+  return k_max_packet_size;
+}
+
+// The packet accessors describe the next packet _get_packet() returns.
+int32_t ThreadedENetPeer::_get_packet_channel() const {
+  ERR_FAIL_COND_V(_incoming.empty(), 0);
+  const int32_t channel = _incoming.front().channel;
+  return channel < SYSCH_MAX ? 0 : channel - SYSCH_MAX + 1;
+}
+
+MultiplayerPeer::TransferMode ThreadedENetPeer::_get_packet_mode() const {
+  ERR_FAIL_COND_V(_incoming.empty(), TRANSFER_MODE_RELIABLE);
+  // ENet's packet flags are not exposed; the channel tells the mode.
+  const int32_t channel = _incoming.front().channel;
+  if (channel == SYSCH_UNRELIABLE) {
+    return TRANSFER_MODE_UNRELIABLE;
+  }
+  return is_enet_channel_unreliable(channel) ? TRANSFER_MODE_UNRELIABLE_ORDERED
+                                             : TRANSFER_MODE_RELIABLE;
+}
+
+int32_t ThreadedENetPeer::_get_packet_peer() const {
+  ERR_FAIL_COND_V(_incoming.empty(), 0);
+  return _incoming.front().peer_id;
+}
+
+void ThreadedENetPeer::_set_transfer_channel(int32_t p_channel) {
+  _transfer_channel = p_channel;
+}
+int32_t ThreadedENetPeer::_get_transfer_channel() const {
+  return _transfer_channel;
+}
+
+void ThreadedENetPeer::_set_transfer_mode(
+    MultiplayerPeer::TransferMode p_mode) {
+  _transfer_mode = p_mode;
+}
+MultiplayerPeer::TransferMode ThreadedENetPeer::_get_transfer_mode() const {
+  return _transfer_mode;
+}
+
+void ThreadedENetPeer::_set_target_peer(int32_t p_peer) {
+  _target_peer = p_peer;
+}
+
+bool ThreadedENetPeer::_is_server() const { return _server; }
+
+void ThreadedENetPeer::_close() {
+  stop_io_thread();
+
+  Event event;
+  while (_inbound.try_pop(event)) {
+  }
+  Command command;
+  while (_outbound.try_pop(command)) {
+  }
+  _outbound_backlog.clear();
+  _incoming.clear();
+  _current = Event();
+  _connected.clear();
+  _server = false;
+  _unique_id = 0;
+  _target_peer = 0;
+  _status = CONNECTION_DISCONNECTED;
+}
+
+void ThreadedENetPeer::_disconnect_peer(int32_t p_peer, bool p_force) {
+  ERR_FAIL_COND_MSG(_connected.count(p_peer) == 0,
+                    "ThreadedENetPeer: unknown peer");
+  Command command;
+  command.type = p_force ? Command::DISCONNECT_NOW : Command::DISCONNECT;
+  command.target = p_peer;
+  push_command(std::move(command));
+
+  if (p_force) {
+    // As ENetMultiplayerPeer: a forced disconnect is reported right away,
+    // and the I/O thread stays silent about it.
+    _connected.erase(p_peer);
+    if (!_server) {
+      _status = CONNECTION_DISCONNECTED;
+    }
+    emit_signal("peer_disconnected", p_peer);
+  }
+}
+
+int32_t ThreadedENetPeer::_get_unique_id() const { return _unique_id; }
+
+void ThreadedENetPeer::_set_refuse_new_connections(bool p_enable) {
+  _refusing.store(p_enable, std::memory_order_relaxed);
+}
+bool ThreadedENetPeer::_is_refusing_new_connections() const {
+  return _refusing.load(std::memory_order_relaxed);
+}
+
+bool ThreadedENetPeer::_is_server_relay_supported() const {
+  return _status != CONNECTION_DISCONNECTED;
+}
+
+MultiplayerPeer::ConnectionStatus
+ThreadedENetPeer::_get_connection_status() const {
+  return _status;
+}
+
+//////// I/O THREAD ////////////////
+
+void ThreadedENetPeer::io_loop() {
+  Time *time = Time::get_singleton();
+  while (_running.load(std::memory_order_acquire)) {
+    Command command;
+    while (_outbound.try_pop(command)) {
+      io_send(command);
+    }
+    io_flush_backlog();
+
+    // Blocks for at most k_service_timeout_ms when idle; drains whatever
+    // else is ready without waiting.
+    Array event = _connection->service(k_service_timeout_ms);
+    while (event.size() >= 4 &&
+           static_cast<int>(event[0]) != ENetConnection::EVENT_NONE) {
+      if (static_cast<int>(event[0]) == ENetConnection::EVENT_ERROR) {
+        break;
+      }
+      io_handle_event(event);
+      event = _connection->service(0);
+    }
+
+    const uint64_t now = time->get_ticks_usec();
+    if (now >= _next_link_sample_usec) {
+      _next_link_sample_usec = now + k_link_sample_interval_usec;
+      io_publish_links();
+    }
+  }
+  io_shutdown();
+}
+
+void ThreadedENetPeer::io_send(const Command &command) {
+  switch (command.type) {
+  case Command::SEND:
+    if (command.target > 0) {
+      auto it = _io_peers.find(command.target);
+      if (it != _io_peers.end()) {
+        it->second->send(command.channel, command.data, command.flags);
+      }
+      return;
+    }
+    for (auto &entry : _io_peers) {
+      if (entry.first != -command.target) {
+        entry.second->send(command.channel, command.data, command.flags);
+      }
+    }
+    return;
+  case Command::DISCONNECT:
+  case Command::DISCONNECT_NOW: {
+    auto it = _io_peers.find(command.target);
+    if (it == _io_peers.end()) {
+      return;
+    }
+    if (command.type == Command::DISCONNECT) {
+      // Reported through the disconnect event once ENet confirms.
+      it->second->peer_disconnect_later();
+      return;
+    }
+    it->second->peer_disconnect_now();
+    _io_peer_ids.erase(it->second->get_instance_id());
+    _io_peers.erase(it);
+    return;
+  }
+  }
+}
+
+void ThreadedENetPeer::io_handle_event(const Array &event) {
+  const int type = event[0];
+  Ref<ENetPacketPeer> peer = event[1];
+  if (peer.is_null()) {
+    return;
+  }
+
+  switch (type) {
+  case ENetConnection::EVENT_CONNECT: {
+    if (!_server) {
+      Event connected;
+      connected.type = Event::CONNECTED;
+      connected.peer_id = 1;
+      io_push_event(std::move(connected), false);
+      return;
+    }
+    const int32_t peer_id = event[2];
+    if (_refusing.load(std::memory_order_relaxed) || peer_id < 2 ||
+        _io_peers.count(peer_id) > 0) {
+      peer->reset();
+      return;
+    }
+    _io_peers[peer_id] = peer;
+    _io_peer_ids[peer->get_instance_id()] = peer_id;
+    Event connected;
+    connected.type = Event::CONNECTED;
+    connected.peer_id = peer_id;
+    io_push_event(std::move(connected), false);
+    return;
+  }
+  case ENetConnection::EVENT_DISCONNECT: {
+    auto it = _io_peer_ids.find(peer->get_instance_id());
+    if (it == _io_peer_ids.end()) {
+      return;
+    }
+    Event disconnected;
+    disconnected.type = Event::DISCONNECTED;
+    disconnected.peer_id = it->second;
+    _io_peers.erase(it->second);
+    _io_peer_ids.erase(it);
+    io_push_event(std::move(disconnected), false);
+    return;
+  }
+  case ENetConnection::EVENT_RECEIVE: {
+    Event packet;
+    packet.type = Event::PACKET;
+    packet.channel = event[3];
+    packet.data = peer->get_packet();
+    auto it = _io_peer_ids.find(peer->get_instance_id());
+    if (it == _io_peer_ids.end()) {
+      return;
+    }
+    packet.peer_id = it->second;
+    const bool droppable = is_enet_channel_unreliable(packet.channel);
+    io_push_event(std::move(packet), droppable);
+    return;
+  }
+  default:
+    return;
+  }
+}
+
+void ThreadedENetPeer::io_push_event(Event &&event, bool p_droppable) {
+  if (_inbound_backlog.empty() && _inbound.try_push(std::move(event))) {
+    raise_high_water(_inbound_stats.high_water, _inbound);
+    return;
+  }
+  if (p_droppable) {
+    _inbound_stats.dropped++;
+    return;
+  }
+  // ENet already acked it; hold it rather than lose it.
+  _inbound_backlog.push_back(std::move(event));
+  _inbound_stats.deferred++;
+}
+
+void ThreadedENetPeer::io_flush_backlog() {
+  while (!_inbound_backlog.empty() &&
+         _inbound.try_push(std::move(_inbound_backlog.front()))) {
+    _inbound_backlog.pop_front();
+  }
+}
+
+void ThreadedENetPeer::io_publish_links() {
+  std::lock_guard<std::mutex> lock(_link_mutex);
+  _links.clear();
+  for (const auto &entry : _io_peers) {
+    const Ref<ENetPacketPeer> &peer = entry.second;
+    LinkSample sample;
+    sample.rtt_ms = static_cast<float>(
+        peer->get_statistic(ENetPacketPeer::PEER_ROUND_TRIP_TIME));
+    sample.rtt_variance_ms = static_cast<float>(
+        peer->get_statistic(ENetPacketPeer::PEER_ROUND_TRIP_TIME_VARIANCE));
+    sample.packet_loss = static_cast<float>(
+        peer->get_statistic(ENetPacketPeer::PEER_PACKET_LOSS) /
+        ENetPacketPeer::PACKET_LOSS_SCALE);
+    sample.packet_throttle = static_cast<float>(
+        peer->get_statistic(ENetPacketPeer::PEER_PACKET_THROTTLE) /
+        ENetPacketPeer::PACKET_THROTTLE_SCALE);
+    _links[entry.first] = sample;
+  }
+}
+
+void ThreadedENetPeer::io_shutdown() {
+  for (auto &entry : _io_peers) {
+    entry.second->peer_disconnect_now();
+  }
+  _io_peers.clear();
+  _io_peer_ids.clear();
+  _inbound_backlog.clear();
+  _server_peer.unref();
+  if (_connection.is_valid()) {
+    _connection->flush();
+    _connection->destroy();
+    _connection.unref();
+  }
+  std::lock_guard<std::mutex> lock(_link_mutex);
+  _links.clear();
+}
+
+void ThreadedENetPeer::_bind_methods() {
+  ClassDB::bind_method(
+      D_METHOD("create_server", "port", "max_clients", "channel_count"),
+      &ThreadedENetPeer::create_server);
+  ClassDB::bind_method(
+      D_METHOD("create_client", "address", "port", "channel_count"),
+      &ThreadedENetPeer::create_client);
+  ClassDB::bind_method(D_METHOD("get_io_stats"),
+                       &ThreadedENetPeer::get_io_stats);
+}
+
+} // namespace morphic
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "net/spsc_ring.h"
+
+#include <godot_cpp/classes/e_net_connection.hpp>
+#include <godot_cpp/classes/e_net_packet_peer.hpp>
+#include <godot_cpp/classes/multiplayer_peer_extension.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+using namespace godot;
+
+namespace morphic {
+
+// MultiplayerPeer whose ENet host is serviced on a dedicated I/O thread,
+// so ENet acks, retransmits and keepalives keep their timing through
+// game-thread hitches (terrain saves, spawns). The game thread only
+// exchanges events and packets with it through two bounded SpscRings and
+// sees an ordinary MultiplayerPeer, so SceneMultiplayer and NetworkManager
+// work on top of it unchanged.
+//
+// Wire compatible with ENetMultiplayerPeer (client id in the connect data,
+// two system channels before the transfer channels, same packet flags), so
+// either side may use it against a plain ENet peer.
+//
+// A full ring drops unreliable packets (counted); reliable packets and
+// connection events are held in a backlog on the producing side instead,
+// since ENet has already acknowledged them.
+class ThreadedENetPeer : public MultiplayerPeerExtension {
+  GDCLASS(ThreadedENetPeer, MultiplayerPeerExtension)
+
+protected:
+  static void _bind_methods();
+
+public:
+  static constexpr int k_default_ring_capacity = 4096;
+
+  ThreadedENetPeer();
+  ~ThreadedENetPeer();
+
+  Error create_server(int p_port, int p_max_clients, int p_channel_count);
+  Error create_client(const String &p_address, int p_port,
+                      int p_channel_count);
+
+  // Queue depths (now and high-water), drops and backlog per direction.
+  Dictionary get_io_stats() const;
+
+  struct LinkSample {
+    float rtt_ms = 0.0f;
+    float rtt_variance_ms = 0.0f;
+    float packet_loss = 0.0f;
+    float packet_throttle = 1.0f;
+  };
+  // ENet statistics the I/O thread last published for `peer_id`.
+  bool get_link_sample(int p_peer_id, LinkSample &r_sample) const;
+
+  // Marks a transfer channel as carrying unreliable traffic. ENet does not
+  // report packet flags on receive, so this is what lets the I/O thread
+  // drop such packets on a full ring and report their transfer mode.
+  void set_transfer_channel_unreliable(int p_channel, bool p_unreliable);
+
+  Error _get_packet(const uint8_t **r_buffer, int32_t *r_buffer_size) override;
+  Error _put_packet(const uint8_t *p_buffer, int32_t p_buffer_size) override;
+  int32_t _get_available_packet_count() const override;
+  int32_t _get_max_packet_size() const override;
+  int32_t _get_packet_channel() const override;
+  MultiplayerPeer::TransferMode _get_packet_mode() const override;
+  void _set_transfer_channel(int32_t p_channel) override;
+  int32_t _get_transfer_channel() const override;
+  void _set_transfer_mode(MultiplayerPeer::TransferMode p_mode) override;
+  MultiplayerPeer::TransferMode _get_transfer_mode() const override;
+  void _set_target_peer(int32_t p_peer) override;
+  int32_t _get_packet_peer() const override;
+  bool _is_server() const override;
+  void _poll() override;
+  void _close() override;
+  void _disconnect_peer(int32_t p_peer, bool p_force) override;
+  int32_t _get_unique_id() const override;
+  void _set_refuse_new_connections(bool p_enable) override;
+  bool _is_refusing_new_connections() const override;
+  bool _is_server_relay_supported() const override;
+  MultiplayerPeer::ConnectionStatus _get_connection_status() const override;
+
+private:
+  // ENetMultiplayerPeer's layout: two system channels, then the transfer
+  // channels 1..N.
+  enum {
+    SYSCH_RELIABLE = 0,
+    SYSCH_UNRELIABLE = 1,
+    SYSCH_MAX = 2,
+  };
+  static constexpr int k_max_packet_size = 1 << 24;
+  // Longest the I/O thread sleeps in ENet before looking at the outbound
+  // ring again; bounds the latency it adds to sends.
+  static constexpr int k_service_timeout_ms = 1;
+  static constexpr uint64_t k_link_sample_interval_usec = 100000;
+
+  // I/O thread -> game thread.
+  struct Event {
+    enum Type : uint8_t { PACKET, CONNECTED, DISCONNECTED };
+    Type type = PACKET;
+    int32_t peer_id = 0;
+    int32_t channel = 0;
+    PackedByteArray data;
+  };
+  // Game thread -> I/O thread.
+  struct Command {
+    enum Type : uint8_t { SEND, DISCONNECT, DISCONNECT_NOW };
+    Type type = SEND;
+    // SEND: 0 = everyone, < 0 = everyone but -target.
+    int32_t target = 0;
+    int32_t channel = 0;
+    int32_t flags = 0;
+    PackedByteArray data;
+  };
+
+  struct DirectionStats {
+    std::atomic<uint32_t> high_water{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> deferred{0};
+  };
+
+  bool _server = false;
+  int32_t _unique_id = 0;
+  std::atomic<bool> _refusing{false};
+  MultiplayerPeer::ConnectionStatus _status = CONNECTION_DISCONNECTED;
+
+  // Owned by the I/O thread while it runs.
+  Ref<ENetConnection> _connection;
+  Ref<ENetPacketPeer> _server_peer;
+  std::unordered_map<int32_t, Ref<ENetPacketPeer>> _io_peers;
+  std::unordered_map<uint64_t, int32_t> _io_peer_ids;
+  std::deque<Event> _inbound_backlog;
+  uint64_t _next_link_sample_usec = 0;
+
+  SpscRing<Event> _inbound;
+  SpscRing<Command> _outbound;
+  DirectionStats _inbound_stats;
+  DirectionStats _outbound_stats;
+  std::thread _thread;
+  std::atomic<bool> _running{false};
+  // Bit per ENet channel set by set_transfer_channel_unreliable().
+  std::atomic<uint32_t> _unreliable_channels{0};
+
+  mutable std::mutex _link_mutex;
+  std::unordered_map<int32_t, LinkSample> _links;
+
+  // Game thread.
+  std::deque<Command> _outbound_backlog;
+  std::deque<Event> _incoming;
+  Event _current;
+  std::unordered_map<int32_t, bool> _connected;
+  int32_t _target_peer = 0;
+  int32_t _transfer_channel = 0;
+  MultiplayerPeer::TransferMode _transfer_mode = TRANSFER_MODE_RELIABLE;
+
+  void start_io_thread();
+  void stop_io_thread();
+  void push_command(Command &&command);
+  bool is_enet_channel_unreliable(int p_channel) const;
+
+  void io_loop();
+  void io_send(const Command &command);
+  void io_handle_event(const Array &event);
+  void io_push_event(Event &&event, bool p_droppable);
+  void io_flush_backlog();
+  void io_publish_links();
+  void io_shutdown();
+};
+
+} // namespace morphic
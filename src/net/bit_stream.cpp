@@ -0,0 +1,89 @@
+#include "bit_stream.h"
+
+#include <godot_cpp/core/error_macros.hpp>
+
+#include <cstring>
+
+namespace morphic {
+
+void BitWriter::write_bits(uint32_t value, int bits) {
+  ERR_FAIL_COND(bits < 0 || bits > 32);
+  for (int i = 0; i < bits; i++) {
+    const uint64_t byte_index = _bit_count >> 3;
+    if (byte_index >= _bytes.size()) {
+      _bytes.push_back(0);
+    }
+    if ((value >> i) & 1u) {
+      _bytes[byte_index] |= static_cast<uint8_t>(1u << (_bit_count & 7));
+    }
+    _bit_count++;
+  }
+}
+
+void BitWriter::write_signed(int32_t value, int bits) {
+  const uint32_t mask = bits >= 32 ? 0xFFFFFFFFu : ((1u << bits) - 1u);
+  write_bits(static_cast<uint32_t>(value) & mask, bits);
+}
+
+void BitWriter::write_bool(bool value) { write_bits(value ? 1u : 0u, 1); }
+
+PackedByteArray BitWriter::to_packed() const {
+  PackedByteArray out;
+  out.resize(static_cast<int64_t>(_bytes.size()));
+  if (!_bytes.empty()) {
+    memcpy(out.ptrw(), _bytes.data(), _bytes.size());
+  }
+  return out;
+}
+
+void BitWriter::clear() {
+  _bytes.clear();
+  _bit_count = 0;
+}
+
+BitReader::BitReader(const uint8_t *data, int size)
+    : _data(data), _size_bits(static_cast<uint64_t>(size) * 8) {}
+
+BitReader::BitReader(const PackedByteArray &bytes)
+    : _data(bytes.ptr()), _size_bits(static_cast<uint64_t>(bytes.size()) * 8) {
+}
+
+uint32_t BitReader::read_bits(int bits) {
+  if (bits < 0 || bits > 32 || _bit_pos + bits > _size_bits) {
+    _overflow = true;
+    return 0;
+  }
+  uint32_t value = 0;
+  for (int i = 0; i < bits; i++) {
+    const uint8_t byte = _data[_bit_pos >> 3];
+    if ((byte >> (_bit_pos & 7)) & 1u) {
+      value |= (1u << i);
+    }
+    _bit_pos++;
+  }
+  return value;
+}
+
+int32_t BitReader::read_signed(int bits) {
+  uint32_t value = read_bits(bits);
+  if (bits > 0 && bits < 32 && (value & (1u << (bits - 1)))) {
+    value |= ~((1u << bits) - 1u);
+  }
+  return static_cast<int32_t>(value);
+}
+
+bool BitReader::read_bool() { return read_bits(1) != 0; }
+
+int BitReader::get_remaining_bits() const {
+  return static_cast<int>(_size_bits - _bit_pos);
+}
+
+int bits_for_count(uint32_t count) {
+  int bits = 0;
+  while (count > 1 && (1u << bits) < count) {
+    bits++;
+  }
+  return bits;
+}
+
+} // namespace morphic
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <godot_cpp/variant/packed_byte_array.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace godot;
+
+namespace morphic {
+
+// Little-endian, LSB-first bit packer used by the wire formats in net/.
+class BitWriter {
+public:
+  void write_bits(uint32_t value, int bits);
+  void write_signed(int32_t value, int bits);
+  void write_bool(bool value);
+
+  int get_bit_count() const { return static_cast<int>(_bit_count); }
+  int get_byte_count() const { return static_cast<int>(_bytes.size()); }
+  const std::vector<uint8_t> &get_bytes() const { return _bytes; }
+
+  PackedByteArray to_packed() const;
+  void clear();
+
+private:
+  std::vector<uint8_t> _bytes;
+  uint64_t _bit_count = 0;
+};
+
+class BitReader {
+public:
+  BitReader(const uint8_t *data, int size);
+  explicit BitReader(const PackedByteArray &bytes);
+
+  uint32_t read_bits(int bits);
+  int32_t read_signed(int bits);
+  bool read_bool();
+
+  // True once a read ran past the end of the buffer; values read after
+  // that point are zero and the whole message should be dropped.
+  bool has_overflowed() const { return _overflow; }
+  int get_remaining_bits() const;
+
+private:
+  const uint8_t *_data = nullptr;
+  uint64_t _size_bits = 0;
+  uint64_t _bit_pos = 0;
+  bool _overflow = false;
+};
+
+// Number of bits needed to store any value in [0, count).
+int bits_for_count(uint32_t count);
+
+} // namespace morphic
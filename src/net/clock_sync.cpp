@@ -0,0 +1,106 @@
+#include "clock_sync.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace morphic {
+
+namespace {
+// Share of each error folded into the offset and the drift.
+constexpr double k_offset_gain = 0.1;
+constexpr double k_drift_gain = 0.01;
+// Samples slower than the window minimum by more than this are queueing.
+constexpr double k_rtt_tolerance = 1.5;
+constexpr uint64_t k_rtt_slack_usec = 2000;
+} // namespace
+
+void ClockSync::reset() { *this = ClockSync(); }
+
+uint64_t ClockSync::get_min_rtt_usec() const {
+  if (_rtt_count == 0) {
+    return 0;
+  }
+  return *std::min_element(_rtts.begin(), _rtts.begin() + _rtt_count);
+}
+
+bool ClockSync::add_sample(const Pong &pong) {
+  if (pong.client_receive_usec < pong.client_send_usec) {
+    _rejected++;
+    return false;
+  }
+
+  const uint64_t rtt = pong.client_receive_usec - pong.client_send_usec;
+  _last_rtt = rtt;
+  _rtts[_rtt_head] = rtt;
+  _rtt_head = (_rtt_head + 1) % k_window;
+  _rtt_count = std::min(_rtt_count + 1, k_window);
+
+  const uint64_t min_rtt = get_min_rtt_usec();
+  if (_synced && static_cast<double>(rtt) >
+                     min_rtt * k_rtt_tolerance + k_rtt_slack_usec) {
+    _rejected++;
+    return false;
+  }
+
+  const uint64_t midpoint = pong.client_send_usec + rtt / 2;
+  const double sample = static_cast<double>(pong.server_time_usec) -
+                        static_cast<double>(midpoint);
+
+  if (!_synced) {
+    _offset = sample;
+    _drift = 0.0;
+    _synced = true;
+  } else {
+    const double elapsed =
+        static_cast<double>(midpoint) - static_cast<double>(_reference_usec);
+    const double predicted = _offset + _drift * elapsed;
+    const double error = sample - predicted;
+
+    if (std::abs(error) > k_step_threshold_usec) {
+      _offset = sample;
+      _drift = 0.0;
+      _steps++;
+    } else {
+      _offset = predicted + k_offset_gain * error;
+      if (elapsed > 0.0) {
+        _drift = std::clamp(_drift + k_drift_gain * error / elapsed,
+                            -k_max_drift, k_max_drift);
+      }
+    }
+  }
+  _reference_usec = midpoint;
+
+  if (pong.tick_rate > 0) {
+    _tick_anchor = pong.server_tick;
+    _tick_anchor_usec = pong.server_tick_usec;
+    _tick_usec = 1000000 / pong.tick_rate;
+  }
+
+  _accepted++;
+  return true;
+}
+
+uint64_t ClockSync::get_server_time_usec(uint64_t local_usec) const {
+  if (!_synced) {
+    return 0;
+  }
+  const double elapsed =
+      static_cast<double>(local_usec) - static_cast<double>(_reference_usec);
+  const double server =
+      static_cast<double>(local_usec) + _offset + _drift * elapsed;
+  return server > 0.0 ? static_cast<uint64_t>(server) : 0;
+}
+
+uint32_t ClockSync::get_server_tick(uint64_t local_usec) const {
+  if (!_synced || _tick_usec == 0) {
+    return 0;
+  }
+  const uint64_t server_usec = get_server_time_usec(local_usec);
+  if (server_usec <= _tick_anchor_usec) {
+    return _tick_anchor;
+  }
+  return _tick_anchor +
+         static_cast<uint32_t>((server_usec - _tick_anchor_usec) / _tick_usec);
+}
+
+} // namespace morphic
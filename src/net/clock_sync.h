@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace morphic {
+
+// Client-side estimate of the server timeline built from ping/pong
+// exchanges. Each pong yields an offset sample: server time minus the
+// local midpoint of the exchange. Queueing delay skews that midpoint, so
+// only samples whose round trip is close to the recent minimum are used.
+// Accepted samples feed an alpha-beta filter for offset and drift, which
+// makes the estimate slew rather than jump; an error above
+// k_step_threshold_usec (server restart, long stall) steps it instead.
+//
+// All local times are Time::get_ticks_usec() values.
+class ClockSync {
+public:
+  static constexpr int k_window = 16;
+  static constexpr int64_t k_step_threshold_usec = 100000;
+  static constexpr double k_max_drift = 0.001; // 1000 ppm
+
+  struct Pong {
+    uint64_t client_send_usec = 0;
+    uint64_t client_receive_usec = 0;
+    uint64_t server_time_usec = 0;
+    // Last server tick and the server time it started at.
+    uint32_t server_tick = 0;
+    uint64_t server_tick_usec = 0;
+    uint16_t tick_rate = 0;
+  };
+
+  void reset();
+  // False when the sample was rejected as a queueing outlier.
+  bool add_sample(const Pong &pong);
+
+  bool is_synced() const { return _synced; }
+  uint64_t get_server_time_usec(uint64_t local_usec) const;
+  uint32_t get_server_tick(uint64_t local_usec) const;
+
+  int64_t get_offset_usec() const { return static_cast<int64_t>(_offset); }
+  double get_drift_ppm() const { return _drift * 1000000.0; }
+  uint64_t get_last_rtt_usec() const { return _last_rtt; }
+  uint64_t get_min_rtt_usec() const;
+  uint64_t get_accepted_count() const { return _accepted; }
+  uint64_t get_rejected_count() const { return _rejected; }
+  uint64_t get_step_count() const { return _steps; }
+
+private:
+  std::array<uint64_t, k_window> _rtts = {};
+  int _rtt_count = 0;
+  int _rtt_head = 0;
+  uint64_t _last_rtt = 0;
+
+  bool _synced = false;
+  // server_time = local + _offset + _drift * (local - _reference_usec)
+  double _offset = 0.0;
+  double _drift = 0.0;
+  uint64_t _reference_usec = 0;
+
+  uint32_t _tick_anchor = 0;
+  uint64_t _tick_anchor_usec = 0;
+  uint64_t _tick_usec = 0;
+
+  uint64_t _accepted = 0;
+  uint64_t _rejected = 0;
+  uint64_t _steps = 0;
+};
+
+} // namespace morphic
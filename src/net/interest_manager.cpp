@@ -0,0 +1,144 @@
+#include "interest_manager.h"
+
+#include <godot_cpp/core/math.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+namespace morphic {
+
+void InterestManager::set_radii(float enter_radius, float leave_radius) {
+  _enter_radius = enter_radius > 0.0f ? enter_radius : 0.0f;
+  _leave_radius = leave_radius > _enter_radius ? leave_radius : _enter_radius;
+}
+
+int64_t InterestManager::cell_key(int x, int y, int z) const {
+  // 21 bits per axis is plenty for cell coordinates of a cave world.
+  const int64_t mask = (int64_t(1) << 21) - 1;
+  return ((int64_t(x) & mask) << 42) | ((int64_t(y) & mask) << 21) |
+         (int64_t(z) & mask);
+}
+
+void InterestManager::cell_coords(const Vector3 &position, int &r_x, int &r_y,
+                                  int &r_z) const {
+  const float cell = _leave_radius > 0.001f ? _leave_radius : 1.0f;
+  r_x = static_cast<int>(Math::floor(position.x / cell));
+  r_y = static_cast<int>(Math::floor(position.y / cell));
+  r_z = static_cast<int>(Math::floor(position.z / cell));
+}
+
+void InterestManager::rebuild(const std::vector<Entity> &entities) {
+  _entities = entities;
+  // Drop cells nobody stood in last round, keep the buffers of the rest.
+  for (auto it = _cells.begin(); it != _cells.end();) {
+    if (it->second.empty()) {
+      it = _cells.erase(it);
+    } else {
+      it->second.clear();
+      ++it;
+    }
+  }
+
+  for (int i = 0; i < static_cast<int>(_entities.size()); i++) {
+    int x, y, z;
+    cell_coords(_entities[i].position, x, y, z);
+    _cells[cell_key(x, y, z)].push_back(i);
+  }
+}
+
+void InterestManager::update_viewer(int32_t viewer_id, const Vector3 &position,
+                                    std::vector<int32_t> &r_entered,
+                                    std::vector<int32_t> &r_left) {
+  add_viewer(viewer_id);
+  update_viewer(viewer_id, position, _scratch, r_entered, r_left);
+}
+
+void InterestManager::add_viewer(int32_t viewer_id) {
+  _relevant.try_emplace(viewer_id);
+}
+
+void InterestManager::update_viewer(int32_t viewer_id, const Vector3 &position,
+                                    std::vector<int32_t> &r_scratch,
+                                    std::vector<int32_t> &r_entered,
+                                    std::vector<int32_t> &r_left) {
+  auto it = _relevant.find(viewer_id);
+  if (it == _relevant.end()) {
+    return;
+  }
+  std::vector<int32_t> &previous = it->second;
+
+  r_scratch.clear();
+  if (!_enabled) {
+    for (const Entity &entity : _entities) {
+      r_scratch.push_back(entity.id);
+    }
+  } else {
+    collect_nearby(viewer_id, position, previous, r_scratch);
+  }
+  std::sort(r_scratch.begin(), r_scratch.end());
+
+  std::set_difference(r_scratch.begin(), r_scratch.end(), previous.begin(),
+                      previous.end(), std::back_inserter(r_entered));
+  std::set_difference(previous.begin(), previous.end(), r_scratch.begin(),
+                      r_scratch.end(), std::back_inserter(r_left));
+  previous.swap(r_scratch);
+}
+
+void InterestManager::collect_nearby(
+    int32_t viewer_id, const Vector3 &position,
+    const std::vector<int32_t> &previous,
+    std::vector<int32_t> &r_relevant) const {
+  const float enter_sq = _enter_radius * _enter_radius;
+  const float leave_sq = _leave_radius * _leave_radius;
+
+  int cx, cy, cz;
+  cell_coords(position, cx, cy, cz);
+  for (int dx = -1; dx <= 1; dx++) {
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dz = -1; dz <= 1; dz++) {
+        auto it = _cells.find(cell_key(cx + dx, cy + dy, cz + dz));
+        if (it == _cells.end()) {
+          continue;
+        }
+        for (int index : it->second) {
+          const Entity &entity = _entities[index];
+          const float dist_sq = position.distance_squared_to(entity.position);
+          bool relevant = entity.id == viewer_id || dist_sq <= enter_sq;
+          if (!relevant && dist_sq <= leave_sq) {
+            relevant = std::binary_search(previous.begin(), previous.end(),
+                                          entity.id);
+          }
+          if (relevant) {
+            r_relevant.push_back(entity.id);
+          }
+        }
+      }
+    }
+  }
+}
+
+const std::vector<int32_t> *
+InterestManager::get_relevant(int32_t viewer_id) const {
+  auto it = _relevant.find(viewer_id);
+  return it != _relevant.end() ? &it->second : nullptr;
+}
+
+void InterestManager::remove_viewer(int32_t viewer_id) {
+  _relevant.erase(viewer_id);
+}
+
+void InterestManager::clear() {
+  _entities.clear();
+  _cells.clear();
+  _relevant.clear();
+}
+
+int InterestManager::get_relevant_pair_count() const {
+  size_t count = 0;
+  for (const auto &entry : _relevant) {
+    count += entry.second.size();
+  }
+  return static_cast<int>(count);
+}
+
+} // namespace morphic
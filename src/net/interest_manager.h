@@ -0,0 +1,79 @@
+#pragma once
+
+#include <godot_cpp/variant/vector3.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using namespace godot;
+
+namespace morphic {
+
+// Server-side area-of-interest tracking. Entities are bucketed into a uniform
+// grid (cell = leave radius) every update, so a viewer query only touches
+// the 27 cells around it. An entity becomes relevant inside `enter_radius`
+// and stays relevant until it is further than `leave_radius`; the gap
+// between the two keeps pairs at the boundary from flickering.
+class InterestManager {
+public:
+  struct Entity {
+    int32_t id = 0;
+    Vector3 position;
+  };
+
+  // Disabled: every entity is relevant to every viewer (no culling), but
+  // entered/left are still reported so callers keep one code path.
+  void set_enabled(bool enabled) { _enabled = enabled; }
+  bool is_enabled() const { return _enabled; }
+
+  void set_radii(float enter_radius, float leave_radius);
+  float get_enter_radius() const { return _enter_radius; }
+  float get_leave_radius() const { return _leave_radius; }
+
+  // Replaces the entity set used by the following update_viewer() calls.
+  void rebuild(const std::vector<Entity> &entities);
+
+  // Recomputes what `viewer_id` (standing at `position`) is interested in.
+  // A viewer always keeps its own entity. Ids that changed state since the
+  // previous update are appended to r_entered / r_left.
+  void update_viewer(int32_t viewer_id, const Vector3 &position,
+                     std::vector<int32_t> &r_entered,
+                     std::vector<int32_t> &r_left);
+
+  // Concurrent form of update_viewer(): several threads may update
+  // different viewers at once, as long as each viewer was added with
+  // add_viewer() beforehand and nothing else touches the manager meanwhile.
+  // r_scratch is the caller's (per-thread) working buffer.
+  void add_viewer(int32_t viewer_id);
+  void update_viewer(int32_t viewer_id, const Vector3 &position,
+                     std::vector<int32_t> &r_scratch,
+                     std::vector<int32_t> &r_entered,
+                     std::vector<int32_t> &r_left);
+
+  // Sorted ids relevant to the viewer, or nullptr for unknown viewers.
+  const std::vector<int32_t> *get_relevant(int32_t viewer_id) const;
+  void remove_viewer(int32_t viewer_id);
+  void clear();
+
+  int get_relevant_pair_count() const;
+
+private:
+  bool _enabled = true;
+  float _enter_radius = 48.0f;
+  float _leave_radius = 56.0f;
+
+  std::vector<Entity> _entities;
+  std::unordered_map<int64_t, std::vector<int>> _cells;
+  std::unordered_map<int32_t, std::vector<int32_t>> _relevant;
+  std::vector<int32_t> _scratch;
+
+  int64_t cell_key(int x, int y, int z) const;
+  void cell_coords(const Vector3 &position, int &r_x, int &r_y,
+                   int &r_z) const;
+  void collect_nearby(int32_t viewer_id, const Vector3 &position,
+                      const std::vector<int32_t> &previous,
+                      std::vector<int32_t> &r_relevant) const;
+};
+
+} // namespace morphic
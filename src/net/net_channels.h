@@ -0,0 +1,68 @@
+#pragma once
+
+#include <godot_cpp/classes/multiplayer_peer.hpp>
+
+#include <cstdint>
+
+using namespace godot;
+
+namespace morphic {
+
+// Traffic classes. Each class has a fixed transfer mode and its own ENet
+// channel, so a large reliable transfer on one class cannot head-of-line
+// block another (ENet orders and retransmits per channel).
+enum class NetMessageClass : uint8_t {
+  SESSION = 0, // handshake, session control: reliable
+  STATE,       // input, snapshots, acks: unreliable sequenced
+  EVENTS,      // equipment/item events: reliable
+  TERRAIN,     // terrain block streaming: reliable
+  COUNT
+};
+
+inline MultiplayerPeer::TransferMode
+net_transfer_mode(NetMessageClass message_class) {
+  switch (message_class) {
+  case NetMessageClass::STATE:
+    return MultiplayerPeer::TRANSFER_MODE_UNRELIABLE_ORDERED;
+  case NetMessageClass::SESSION:
+  case NetMessageClass::EVENTS:
+  case NetMessageClass::TERRAIN:
+  case NetMessageClass::COUNT:
+    break;
+  }
+  return MultiplayerPeer::TRANSFER_MODE_RELIABLE;
+}
+
+// Class -> ENet transfer channel. Channel 0 is the multiplayer peer's
+// default (shared with SceneMultiplayer's own RPC/sync traffic); 1..N are
+// the extra channels the peer is created with. The server's layout is sent
+// in the handshake and used by both sides from then on.
+struct NetChannelLayout {
+  static constexpr int k_class_count = static_cast<int>(NetMessageClass::COUNT);
+  // Channels a client opens; a server layout may not use more.
+  static constexpr int k_max_channels = 8;
+
+  uint8_t channels[k_class_count] = {1, 2, 3, 4};
+
+  int get_channel(NetMessageClass message_class) const {
+    return channels[static_cast<int>(message_class)];
+  }
+  void set_channel(NetMessageClass message_class, int channel) {
+    channels[static_cast<int>(message_class)] = static_cast<uint8_t>(channel);
+  }
+
+  // Extra channels the multiplayer peer needs for this layout.
+  int get_channel_count() const {
+    int count = 0;
+    for (uint8_t channel : channels) {
+      count = channel > count ? channel : count;
+    }
+    return count;
+  }
+
+  bool fits(int channel_capacity) const {
+    return get_channel_count() <= channel_capacity;
+  }
+};
+
+} // namespace morphic
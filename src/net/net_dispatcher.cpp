@@ -0,0 +1,39 @@
+#include "net_dispatcher.h"
+
+namespace morphic {
+
+bool NetDispatcher::dispatch(int sender_id, const PackedByteArray &packet,
+                             bool is_server) {
+  if (packet.is_empty()) {
+    _dropped++;
+    return false;
+  }
+
+  const int opcode = packet[0];
+  if (opcode <= 0 || opcode >= static_cast<int>(NetOpcode::COUNT) ||
+      !_handlers[opcode]) {
+    _dropped++;
+    return false;
+  }
+
+  const NetDirection expected =
+      is_server ? NetDirection::TO_SERVER : NetDirection::TO_CLIENT;
+  if (_directions[opcode] != expected || (!is_server && sender_id != 1)) {
+    _dropped++;
+    return false;
+  }
+  if (is_server && _classes[opcode] != NetMessageClass::SESSION &&
+      _is_admitted && !_is_admitted(sender_id)) {
+    _dropped++;
+    return false;
+  }
+
+  if (!_handlers[opcode](sender_id, packet.ptr() + 1,
+                         static_cast<int>(packet.size()) - 1)) {
+    _dropped++;
+    return false;
+  }
+  return true;
+}
+
+} // namespace morphic
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "net/net_channels.h"
+#include "net/net_message.h"
+
+#include <array>
+#include <functional>
+#include <utility>
+
+namespace morphic {
+
+// Opcode -> handler table for incoming raw packets. Handlers receive the
+// decoded message and the sender's peer id; packets with unknown opcodes,
+// the wrong direction for this side, or malformed payloads are dropped
+// and counted. On the server, everything but the SESSION class is also
+// dropped until the sender passes the admission check.
+class NetDispatcher {
+public:
+  template <typename T, typename F> void bind(F &&handler) {
+    const int opcode = static_cast<int>(T::k_opcode);
+    _directions[opcode] = T::k_direction;
+    _classes[opcode] = T::k_class;
+    _handlers[opcode] = [handler = std::forward<F>(handler)](
+                            int sender_id, const uint8_t *data, int size) {
+      T message;
+      if (!net_decode(data, size, message)) {
+        return false;
+      }
+      handler(sender_id, message);
+      return true;
+    };
+  }
+
+  template <typename T> void unbind() {
+    _handlers[static_cast<int>(T::k_opcode)] = nullptr;
+  }
+
+  // Server: whether `sender_id` completed the handshake and may send
+  // gameplay traffic. Unset admits everyone.
+  void set_admission_check(std::function<bool(int)> is_admitted) {
+    _is_admitted = std::move(is_admitted);
+  }
+
+  // `is_server` decides which direction is accepted: servers take
+  // TO_SERVER messages from anyone, clients TO_CLIENT ones from peer 1.
+  bool dispatch(int sender_id, const PackedByteArray &packet, bool is_server);
+
+  uint64_t get_dropped_count() const { return _dropped; }
+
+private:
+  using Handler = std::function<bool(int, const uint8_t *, int)>;
+
+  std::array<Handler, static_cast<int>(NetOpcode::COUNT)> _handlers;
+  std::array<NetDirection, static_cast<int>(NetOpcode::COUNT)> _directions =
+      {};
+  std::array<NetMessageClass, static_cast<int>(NetOpcode::COUNT)> _classes =
+      {};
+  std::function<bool(int)> _is_admitted;
+  uint64_t _dropped = 0;
+};
+
+} // namespace morphic
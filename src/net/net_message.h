@@ -0,0 +1,338 @@
+#pragma once
+
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+
+using namespace godot;
+
+namespace morphic {
+
+// Typed binary messages sent as raw bytes over the multiplayer peer.
+//
+// A message is a plain struct with an opcode, a traffic class (which picks
+// transfer mode and channel, see net_channels.h) and a constexpr schema
+// listing its fields in wire order:
+//
+//   struct PingMessage {
+//     static constexpr NetOpcode k_opcode = NetOpcode::PING;
+//     static constexpr NetDirection k_direction = NetDirection::TO_SERVER;
+//     static constexpr NetMessageClass k_class = NetMessageClass::SESSION;
+//     uint32_t sequence = 0;
+//     static constexpr auto schema() {
+//       return std::make_tuple(net_field(&PingMessage::sequence));
+//     }
+//   };
+//
+// Encoders and decoders are instantiated from the schema at compile time;
+// nothing goes through Variant. Every field type has a fixed wire size
+// (NetBlob has a fixed maximum), so each message's size is known up front.
+// All integers are little-endian.
+
+enum class NetOpcode : uint8_t {
+  NONE = 0,
+  CLIENT_HELLO,
+  SERVER_HELLO_ACK,
+  PLAYER_INPUT,
+  PLAYER_SNAPSHOT,
+  SNAPSHOT_ACK,
+  CLOCK_PING,
+  CLOCK_PONG,
+  TERRAIN_BLOCK,
+  TERRAIN_MANIFEST,
+  TERRAIN_MANIFEST_ACK,
+  JOIN_QUEUED,
+  COUNT
+};
+
+// Who may send a message; the dispatcher drops the other direction.
+enum class NetDirection : uint8_t { TO_SERVER, TO_CLIENT };
+
+class NetWriter {
+public:
+  NetWriter(uint8_t *data, int capacity) : _data(data), _capacity(capacity) {}
+
+  void write_raw(const void *src, int size) {
+    if (_pos + size > _capacity) {
+      _overflow = true;
+      return;
+    }
+    memcpy(_data + _pos, src, static_cast<size_t>(size));
+    _pos += size;
+  }
+
+  template <typename U> void write_le(U value) {
+    uint8_t bytes[sizeof(U)];
+    for (size_t i = 0; i < sizeof(U); i++) {
+      bytes[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i));
+    }
+    write_raw(bytes, sizeof(U));
+  }
+
+  int get_position() const { return _pos; }
+  bool has_overflowed() const { return _overflow; }
+
+private:
+  uint8_t *_data = nullptr;
+  int _capacity = 0;
+  int _pos = 0;
+  bool _overflow = false;
+};
+
+class NetReader {
+public:
+  NetReader(const uint8_t *data, int size) : _data(data), _size(size) {}
+
+  bool read_raw(void *dst, int size) {
+    if (_pos + size > _size) {
+      _overflow = true;
+      return false;
+    }
+    memcpy(dst, _data + _pos, static_cast<size_t>(size));
+    _pos += size;
+    return true;
+  }
+
+  template <typename U> bool read_le(U &r_value) {
+    uint8_t bytes[sizeof(U)];
+    if (!read_raw(bytes, sizeof(U))) {
+      return false;
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(U); i++) {
+      value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    }
+    r_value = static_cast<U>(value);
+    return true;
+  }
+
+  int get_remaining() const { return _size - _pos; }
+  bool has_overflowed() const { return _overflow; }
+
+private:
+  const uint8_t *_data = nullptr;
+  int _size = 0;
+  int _pos = 0;
+  bool _overflow = false;
+};
+
+// Fixed-size, zero-padded UTF-8 string; longer input is truncated.
+template <int N> struct NetFixedString {
+  char data[N] = {};
+
+  void set(const String &value) {
+    const CharString utf8 = value.utf8();
+    const int len = utf8.length() < N ? utf8.length() : N;
+    memset(data, 0, N);
+    memcpy(data, utf8.get_data(), static_cast<size_t>(len));
+  }
+
+  String get() const {
+    int len = 0;
+    while (len < N && data[len] != 0) {
+      len++;
+    }
+    return String::utf8(data, len);
+  }
+};
+
+// Opaque payload (already encoded by its own codec), up to Max bytes.
+template <int Max> struct NetBlob {
+  static constexpr int k_max_size = Max;
+  PackedByteArray bytes;
+};
+
+// Schema entry: one data member of T.
+template <typename T, typename M> struct NetField {
+  using Type = M;
+  M T::*member;
+};
+
+template <typename T, typename M>
+constexpr NetField<T, M> net_field(M T::*member) {
+  return NetField<T, M>{member};
+}
+
+// Wire codec of one field type.
+template <typename M, typename Enable = void> struct NetWire;
+
+template <typename M>
+struct NetWire<M, std::enable_if_t<std::is_integral<M>::value &&
+                                   !std::is_same<M, bool>::value>> {
+  static constexpr int k_size = sizeof(M);
+  static void write(NetWriter &w, const M &v) { w.write_le(v); }
+  static bool read(NetReader &r, M &v) { return r.read_le(v); }
+};
+
+template <> struct NetWire<bool> {
+  static constexpr int k_size = 1;
+  static void write(NetWriter &w, const bool &v) {
+    w.write_le<uint8_t>(v ? 1 : 0);
+  }
+  static bool read(NetReader &r, bool &v) {
+    uint8_t byte = 0;
+    if (!r.read_le(byte) || byte > 1) {
+      return false;
+    }
+    v = byte != 0;
+    return true;
+  }
+};
+
+template <> struct NetWire<float> {
+  static constexpr int k_size = 4;
+  static void write(NetWriter &w, const float &v) {
+    uint32_t bits = 0;
+    memcpy(&bits, &v, sizeof(bits));
+    w.write_le(bits);
+  }
+  static bool read(NetReader &r, float &v) {
+    uint32_t bits = 0;
+    if (!r.read_le(bits)) {
+      return false;
+    }
+    memcpy(&v, &bits, sizeof(v));
+    return true;
+  }
+};
+
+// Enums on the wire end in COUNT; anything from there up fails the decode
+// so no out-of-range value reaches a switch.
+template <typename E>
+struct NetWire<E, std::enable_if_t<std::is_enum<E>::value>> {
+  using Underlying = std::underlying_type_t<E>;
+  static constexpr int k_size = sizeof(Underlying);
+  static void write(NetWriter &w, const E &v) {
+    w.write_le(static_cast<Underlying>(v));
+  }
+  static bool read(NetReader &r, E &v) {
+    Underlying raw = 0;
+    if (!r.read_le(raw) || raw >= static_cast<Underlying>(E::COUNT)) {
+      return false;
+    }
+    v = static_cast<E>(raw);
+    return true;
+  }
+};
+
+template <typename E, size_t N> struct NetWire<E[N]> {
+  static constexpr int k_size = static_cast<int>(N) * NetWire<E>::k_size;
+  static void write(NetWriter &w, const E (&v)[N]) {
+    for (size_t i = 0; i < N; i++) {
+      NetWire<E>::write(w, v[i]);
+    }
+  }
+  static bool read(NetReader &r, E (&v)[N]) {
+    for (size_t i = 0; i < N; i++) {
+      if (!NetWire<E>::read(r, v[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+template <int N> struct NetWire<NetFixedString<N>> {
+  static constexpr int k_size = N;
+  static void write(NetWriter &w, const NetFixedString<N> &v) {
+    w.write_raw(v.data, N);
+  }
+  static bool read(NetReader &r, NetFixedString<N> &v) {
+    return r.read_raw(v.data, N);
+  }
+};
+
+template <int Max> struct NetWire<NetBlob<Max>> {
+  static_assert(Max <= 0xFFFF, "NetBlob length is a 16 bit prefix");
+  static constexpr int k_size = 2 + Max;
+  static void write(NetWriter &w, const NetBlob<Max> &v) {
+    const int size = static_cast<int>(v.bytes.size());
+    if (size > Max) {
+      // Caller bug; poison the writer so the message is not sent.
+      w.write_raw(nullptr, k_size + 1);
+      return;
+    }
+    w.write_le(static_cast<uint16_t>(size));
+    w.write_raw(v.bytes.ptr(), size);
+  }
+  static bool read(NetReader &r, NetBlob<Max> &v) {
+    uint16_t size = 0;
+    if (!r.read_le(size) || size > Max || size > r.get_remaining()) {
+      return false;
+    }
+    v.bytes.resize(size);
+    return r.read_raw(v.bytes.ptrw(), size);
+  }
+};
+
+// Compile-time facts about a message type.
+template <typename T> struct NetMessageTraits {
+  // Opcode byte plus every field at its (maximum) wire size.
+  static constexpr int k_max_size = std::apply(
+      [](auto... fields) {
+        return 1 + (0 + ... +
+                    NetWire<typename decltype(fields)::Type>::k_size);
+      },
+      T::schema());
+};
+
+template <typename T> bool net_write_fields(NetWriter &w, const T &message) {
+  std::apply(
+      [&](auto... fields) {
+        (NetWire<typename decltype(fields)::Type>::write(
+             w, message.*(fields.member)),
+         ...);
+      },
+      T::schema());
+  return !w.has_overflowed();
+}
+
+template <typename T> bool net_read_fields(NetReader &r, T &r_message) {
+  return std::apply(
+      [&](auto... fields) {
+        return (NetWire<typename decltype(fields)::Type>::read(
+                    r, r_message.*(fields.member)) &&
+                ...);
+      },
+      T::schema());
+}
+
+// Opcode byte followed by the fields. Empty on failure.
+template <typename T> PackedByteArray net_encode(const T &message) {
+  PackedByteArray out;
+  out.resize(NetMessageTraits<T>::k_max_size);
+  NetWriter writer(out.ptrw(), static_cast<int>(out.size()));
+  writer.write_le(static_cast<uint8_t>(T::k_opcode));
+  if (!net_write_fields(writer, message)) {
+    return PackedByteArray();
+  }
+  out.resize(writer.get_position());
+  return out;
+}
+
+// `data` points past the opcode byte. Trailing bytes are rejected.
+template <typename T>
+bool net_decode(const uint8_t *data, int size, T &r_message) {
+  NetReader reader(data, size);
+  return net_read_fields(reader, r_message) && reader.get_remaining() == 0;
+}
+
+// 64-bit FNV-1a of a string's UTF-8 bytes, for ids compared across peers.
+inline uint64_t net_hash_string(const String &value) {
+  if (value.is_empty()) {
+    return 0;
+  }
+  const CharString utf8 = value.utf8();
+  uint64_t hash = 14695981039346656037ull;
+  for (int i = 0; i < utf8.length(); i++) {
+    hash ^= static_cast<uint8_t>(utf8.get_data()[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+} // namespace morphic
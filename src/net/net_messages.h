@@ -0,0 +1,295 @@
+#pragma once
+
+#include "net/net_channels.h"
+#include "net/net_message.h"
+#include "net/player_input_packet.h"
+#include "net/player_snapshot.h"
+
+namespace morphic {
+
+// Every message the game sends through NetworkManager::send_message().
+
+//////// HANDSHAKE ////////////////
+
+enum class HandshakeReject : uint8_t {
+  NONE = 0,
+  PROTOCOL_MISMATCH,
+  NO_WORLD_CONTEXT,
+  WORLD_MISMATCH,
+  CHANNEL_LAYOUT,
+  COUNT
+};
+
+inline const char *handshake_reject_to_string(HandshakeReject reason) {
+  switch (reason) {
+  case HandshakeReject::NONE:
+    return "None";
+  case HandshakeReject::PROTOCOL_MISMATCH:
+    return "Protocol version mismatch";
+  case HandshakeReject::NO_WORLD_CONTEXT:
+    return "Server world context not set";
+  case HandshakeReject::WORLD_MISMATCH:
+    return "Requested world id mismatch";
+  case HandshakeReject::CHANNEL_LAYOUT:
+    return "Client has too few channels for the server's layout";
+  case HandshakeReject::COUNT:
+    break;
+  }
+  return "Unknown";
+}
+
+// How TerrainBlockMessage payloads are encoded (see TerrainBlockCodec).
+enum class TerrainCodec : uint8_t {
+  // VoxelBlockSerializer's own compression; every client understands it.
+  VOXEL = 0,
+  // The block XORed with what the seeded generator produces for it, then
+  // zstd. The generator output acts as the compression dictionary.
+  GENERATOR_DELTA = 1,
+  COUNT
+};
+
+// Identifies the "dictionary" GENERATOR_DELTA is taken against. Bump it
+// whenever the terrain generator graph changes what it produces, so mixed
+// builds fall back to TerrainCodec::VOXEL instead of decoding garbage.
+constexpr uint16_t k_terrain_dictionary_version = 1;
+
+// Size of a resumption ticket (see ResumeTicketIssuer).
+constexpr int k_resume_ticket_size = 40;
+
+struct ClientHelloMessage {
+  static constexpr NetOpcode k_opcode = NetOpcode::CLIENT_HELLO;
+  static constexpr NetDirection k_direction = NetDirection::TO_SERVER;
+  static constexpr NetMessageClass k_class = NetMessageClass::SESSION;
+
+  uint16_t protocol_version = 0;
+  NetFixedString<16> build_hash;
+  // net_hash_string() of the requested world id, 0 = any.
+  uint64_t world_id_hash = 0;
+  uint64_t client_nonce = 0;
+  // Random id kept across sessions, so the server can recognise a
+  // returning client (see PlayerSpawner's viewer linger). Not a secret.
+  uint64_t client_identity = 0;
+  // The ticket from our last accepted join, empty if we have none.
+  NetBlob<k_resume_ticket_size> resume_ticket;
+  // Extra ENet channels the client's connection was opened with.
+  uint8_t channel_capacity = 0;
+  // k_terrain_dictionary_version of the client, 0 = plain blocks only.
+  uint16_t terrain_dictionary = 0;
+  // Terrain radii (voxels) the client can afford; the server clamps them.
+  uint16_t view_distance = 0;
+  uint16_t collision_distance = 0;
+
+  static constexpr auto schema() {
+    return std::make_tuple(net_field(&ClientHelloMessage::protocol_version),
+                           net_field(&ClientHelloMessage::build_hash),
+                           net_field(&ClientHelloMessage::world_id_hash),
+                           net_field(&ClientHelloMessage::client_nonce),
+                           net_field(&ClientHelloMessage::client_identity),
+                           net_field(&ClientHelloMessage::resume_ticket),
+                           net_field(&ClientHelloMessage::channel_capacity),
+                           net_field(&ClientHelloMessage::terrain_dictionary),
+                           net_field(&ClientHelloMessage::view_distance),
+                           net_field(&ClientHelloMessage::collision_distance));
+  }
+};
+
+// Accepting the hello also completes the join: the server marks the peer
+// ready (and spawns it) right after sending this, so joining takes one
+// round trip after the transport connected.
+struct ServerHelloAckMessage {
+  static constexpr NetOpcode k_opcode = NetOpcode::SERVER_HELLO_ACK;
+  static constexpr NetDirection k_direction = NetDirection::TO_CLIENT;
+  static constexpr NetMessageClass k_class = NetMessageClass::SESSION;
+
+  HandshakeReject reject = HandshakeReject::NONE;
+  uint16_t protocol_version = 0;
+  uint64_t world_id_hash = 0;
+  int32_t seed = 0;
+  uint64_t client_nonce = 0;
+  // Server's NetChannelLayout, one channel per NetMessageClass.
+  uint8_t channels[NetChannelLayout::k_class_count] = {};
+  // Codec the server will use for this client's terrain blocks.
+  TerrainCodec terrain_codec = TerrainCodec::VOXEL;
+  // The granted terrain radii.
+  uint16_t view_distance = 0;
+  uint16_t collision_distance = 0;
+  // The hello's ticket was valid: the join skipped the admission queue.
+  bool resumed = false;
+  // Ticket for the next join; empty on reject.
+  NetBlob<k_resume_ticket_size> resume_ticket;
+
+  static constexpr auto schema() {
+    return std::make_tuple(
+        net_field(&ServerHelloAckMessage::reject),
+        net_field(&ServerHelloAckMessage::protocol_version),
+        net_field(&ServerHelloAckMessage::world_id_hash),
+        net_field(&ServerHelloAckMessage::seed),
+        net_field(&ServerHelloAckMessage::client_nonce),
+        net_field(&ServerHelloAckMessage::channels),
+        net_field(&ServerHelloAckMessage::terrain_codec),
+        net_field(&ServerHelloAckMessage::view_distance),
+        net_field(&ServerHelloAckMessage::collision_distance),
+        net_field(&ServerHelloAckMessage::resumed),
+        net_field(&ServerHelloAckMessage::resume_ticket));
+  }
+};
+
+// Instead of the hello ack while the server admits other joins; resent
+// whenever the position changes. The ack follows once admitted.
+struct JoinQueuedMessage {
+  static constexpr NetOpcode k_opcode = NetOpcode::JOIN_QUEUED;
+  static constexpr NetDirection k_direction = NetDirection::TO_CLIENT;
+  static constexpr NetMessageClass k_class = NetMessageClass::SESSION;
+
+  // 1 = next in line.
+  uint16_t position = 0;
+  uint16_t queue_length = 0;
+
+  static constexpr auto schema() {
+    return std::make_tuple(net_field(&JoinQueuedMessage::position),
+                           net_field(&JoinQueuedMessage::queue_length));
+  }
+};
+
+//////// CLOCK ////////////////
+
+// Unreliable on purpose: a retransmitted ping would report the resend
+// delay as round trip time.
+struct ClockPingMessage {
+  static constexpr NetOpcode k_opcode = NetOpcode::CLOCK_PING;
+  static constexpr NetDirection k_direction = NetDirection::TO_SERVER;
+  static constexpr NetMessageClass k_class = NetMessageClass::STATE;
+
+  uint64_t client_time_usec = 0;
+
+  static constexpr auto schema() {
+    return std::make_tuple(net_field(&ClockPingMessage::client_time_usec));
+  }
+};
+
+struct ClockPongMessage {
+  static constexpr NetOpcode k_opcode = NetOpcode::CLOCK_PONG;
+  static constexpr NetDirection k_direction = NetDirection::TO_CLIENT;
+  static constexpr NetMessageClass k_class = NetMessageClass::STATE;
+
+  uint64_t client_time_usec = 0;
+  uint64_t server_time_usec = 0;
+  uint32_t server_tick = 0;
+  uint64_t server_tick_usec = 0;
+  uint16_t tick_rate = 0;
+
+  static constexpr auto schema() {
+    return std::make_tuple(net_field(&ClockPongMessage::client_time_usec),
+                           net_field(&ClockPongMessage::server_time_usec),
+                           net_field(&ClockPongMessage::server_tick),
+                           net_field(&ClockPongMessage::server_tick_usec),
+                           net_field(&ClockPongMessage::tick_rate));
+  }
+};
+
+//////// PLAYER ////////////////
+
+// Redundant input packet, see PlayerInputCodec.
+struct PlayerInputMessage {
+  static constexpr NetOpcode k_opcode = NetOpcode::PLAYER_INPUT;
+  static constexpr NetDirection k_direction = NetDirection::TO_SERVER;
+  // Sequenced delivery loses nothing here: a newer packet repeats every
+  // input the server has not acked.
+  static constexpr NetMessageClass k_class = NetMessageClass::STATE;
+
+  NetBlob<PlayerInputCodec::k_max_packet_bytes> inputs;
+
+  static constexpr auto schema() {
+    return std::make_tuple(net_field(&PlayerInputMessage::inputs));
+  }
+};
+
+// Delta-compressed snapshot, see PlayerSnapshotCodec.
+struct PlayerSnapshotMessage {
+  static constexpr NetOpcode k_opcode = NetOpcode::PLAYER_SNAPSHOT;
+  static constexpr NetDirection k_direction = NetDirection::TO_CLIENT;
+  static constexpr NetMessageClass k_class = NetMessageClass::STATE;
+
+  NetBlob<PlayerSnapshotCodec::k_max_encoded_bytes> snapshot;
+
+  static constexpr auto schema() {
+    return std::make_tuple(net_field(&PlayerSnapshotMessage::snapshot));
+  }
+};
+
+struct SnapshotAckMessage {
+  static constexpr NetOpcode k_opcode = NetOpcode::SNAPSHOT_ACK;
+  static constexpr NetDirection k_direction = NetDirection::TO_SERVER;
+  static constexpr NetMessageClass k_class = NetMessageClass::STATE;
+
+  uint32_t sequence = 0;
+
+  static constexpr auto schema() {
+    return std::make_tuple(net_field(&SnapshotAckMessage::sequence));
+  }
+};
+
+//////// TERRAIN ////////////////
+
+// One data block that differs from the seeded generator output, encoded
+// with `codec`. Clients generate every other block.
+struct TerrainBlockMessage {
+  static constexpr NetOpcode k_opcode = NetOpcode::TERRAIN_BLOCK;
+  static constexpr NetDirection k_direction = NetDirection::TO_CLIENT;
+  static constexpr NetMessageClass k_class = NetMessageClass::TERRAIN;
+
+  int32_t x = 0;
+  int32_t y = 0;
+  int32_t z = 0;
+  uint32_t version = 0;
+  TerrainCodec codec = TerrainCodec::VOXEL;
+  NetBlob<60000> voxels;
+
+  static constexpr auto schema() {
+    return std::make_tuple(net_field(&TerrainBlockMessage::x),
+                           net_field(&TerrainBlockMessage::y),
+                           net_field(&TerrainBlockMessage::z),
+                           net_field(&TerrainBlockMessage::version),
+                           net_field(&TerrainBlockMessage::codec),
+                           net_field(&TerrainBlockMessage::voxels));
+  }
+};
+
+// Blocks a client already holds from its cache, as (int64 block key,
+// uint32 version) pairs, little-endian, k_entry_size bytes each. Large
+// caches go out in several messages; the server answers the `last` one.
+struct TerrainManifestMessage {
+  static constexpr NetOpcode k_opcode = NetOpcode::TERRAIN_MANIFEST;
+  static constexpr NetDirection k_direction = NetDirection::TO_SERVER;
+  static constexpr NetMessageClass k_class = NetMessageClass::TERRAIN;
+  static constexpr int k_entry_size = 12;
+  static constexpr int k_max_entries = 4096;
+
+  uint64_t log_id = 0;
+  bool last = false;
+  NetBlob<k_entry_size * k_max_entries> entries;
+
+  static constexpr auto schema() {
+    return std::make_tuple(net_field(&TerrainManifestMessage::log_id),
+                           net_field(&TerrainManifestMessage::last),
+                           net_field(&TerrainManifestMessage::entries));
+  }
+};
+
+// The server's edit log id. The client's cache is valid if it matches;
+// `matched` blocks will not be sent again.
+struct TerrainManifestAckMessage {
+  static constexpr NetOpcode k_opcode = NetOpcode::TERRAIN_MANIFEST_ACK;
+  static constexpr NetDirection k_direction = NetDirection::TO_CLIENT;
+  static constexpr NetMessageClass k_class = NetMessageClass::TERRAIN;
+
+  uint64_t log_id = 0;
+  uint32_t matched = 0;
+
+  static constexpr auto schema() {
+    return std::make_tuple(net_field(&TerrainManifestAckMessage::log_id),
+                           net_field(&TerrainManifestAckMessage::matched));
+  }
+};
+
+} // namespace morphic
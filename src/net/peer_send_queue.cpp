@@ -0,0 +1,113 @@
+#include "peer_send_queue.h"
+
+#include <algorithm>
+
+namespace morphic {
+
+namespace {
+// Bucket capacity, in seconds of budget.
+constexpr float k_burst_s = 0.1f;
+// Loss (0..1) and RTT inflation that count as congestion.
+constexpr float k_loss_threshold = 0.02f;
+constexpr float k_rtt_inflation = 2.0f;
+constexpr float k_rtt_slack_ms = 20.0f;
+// AIMD steps: cut on congestion, grow by a share of the configured budget.
+constexpr float k_decrease_factor = 0.7f;
+constexpr float k_increase_share = 0.1f;
+// Never below this share of the configured budget.
+constexpr float k_min_budget_share = 0.1f;
+} // namespace
+
+void PeerSendQueue::push(const PackedByteArray &bytes,
+                         NetMessageClass message_class, float priority,
+                         uint64_t now_usec) {
+  Packet packet;
+  packet.bytes = bytes;
+  packet.message_class = message_class;
+  packet.priority = priority;
+  packet.queued_usec = now_usec;
+  _queued_bytes += bytes.size();
+  _packets.push_back(packet);
+}
+
+void PeerSendQueue::charge(int bytes) {
+  // Unpaced traffic builds no debt to pay off once a budget is set.
+  if (_configured_budget > 0.0f) {
+    _tokens -= static_cast<float>(bytes);
+  }
+}
+
+void PeerSendQueue::pop_ready(float delta, uint64_t now_usec,
+                              std::vector<Packet> &r_packets) {
+  _tokens = std::min(_tokens + _budget * delta, _budget * k_burst_s);
+  for (Packet &packet : _packets) {
+    packet.accumulated += packet.priority * delta;
+  }
+
+  // A zero budget means unpaced.
+  const bool unpaced = _configured_budget <= 0.0f;
+  while ((unpaced || _tokens > 0.0f) && !_packets.empty()) {
+    auto best = std::max_element(_packets.begin(), _packets.end(),
+                                 [](const Packet &a, const Packet &b) {
+                                   return a.accumulated < b.accumulated;
+                                 });
+    const uint64_t wait = now_usec - best->queued_usec;
+    _longest_wait_usec = std::max(_longest_wait_usec, wait);
+    if (wait > k_starvation_usec) {
+      _starved++;
+    }
+    if (!unpaced) {
+      _tokens -= static_cast<float>(best->bytes.size());
+    }
+    _queued_bytes -= best->bytes.size();
+    r_packets.push_back(std::move(*best));
+    if (best != _packets.end() - 1) {
+      *best = std::move(_packets.back());
+    }
+    _packets.pop_back();
+  }
+}
+
+void PeerSendQueue::adapt(float rtt_ms, float packet_loss) {
+  if (rtt_ms > 0.0f && (_min_rtt_ms <= 0.0f || rtt_ms < _min_rtt_ms)) {
+    _min_rtt_ms = rtt_ms;
+  }
+  const bool congested =
+      packet_loss > k_loss_threshold ||
+      (_min_rtt_ms > 0.0f &&
+       rtt_ms > _min_rtt_ms * k_rtt_inflation + k_rtt_slack_ms);
+  if (congested) {
+    _budget = std::max(_budget * k_decrease_factor,
+                       _configured_budget * k_min_budget_share);
+  } else {
+    _budget = std::min(_budget + _configured_budget * k_increase_share,
+                       _configured_budget);
+  }
+}
+
+void PeerSendQueue::set_configured_budget(float bytes_per_sec) {
+  const bool was_unpaced = _configured_budget <= 0.0f;
+  _configured_budget = std::max(bytes_per_sec, 0.0f);
+  if (was_unpaced) {
+    _tokens = 0.0f;
+  }
+  if (_budget <= 0.0f || _budget > _configured_budget) {
+    _budget = _configured_budget;
+  }
+}
+
+void PeerSendQueue::clear() {
+  _packets.clear();
+  _queued_bytes = 0;
+  _tokens = 0.0f;
+}
+
+float PeerSendQueue::get_oldest_wait_ms(uint64_t now_usec) const {
+  uint64_t oldest = now_usec;
+  for (const Packet &packet : _packets) {
+    oldest = std::min(oldest, packet.queued_usec);
+  }
+  return static_cast<float>(now_usec - oldest) / 1000.0f;
+}
+
+} // namespace morphic
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "net/net_channels.h"
+
+#include <godot_cpp/variant/packed_byte_array.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace godot;
+
+namespace morphic {
+
+// Server-side pacing of the bulk traffic to one peer. A token bucket
+// refills at the peer's budget; latency-critical messages go out at once
+// but are charged to it, so bulk traffic only uses what they leave.
+//
+// Queued packets carry a priority that accumulates while they wait; the
+// highest accumulated value goes first. Near terrain outranks far terrain,
+// but anything waiting long enough eventually outranks fresh arrivals, so
+// nothing starves.
+//
+// The budget adapts to the link: loss or RTT well above the lowest seen
+// cut it multiplicatively, a clean link grows it back additively up to
+// the configured value.
+class PeerSendQueue {
+public:
+  // Waiting longer than this counts as starved.
+  static constexpr uint64_t k_starvation_usec = 1000000;
+
+  struct Packet {
+    PackedByteArray bytes;
+    NetMessageClass message_class = NetMessageClass::TERRAIN;
+    float priority = 1.0f;
+    float accumulated = 0.0f;
+    uint64_t queued_usec = 0;
+  };
+
+  void push(const PackedByteArray &bytes, NetMessageClass message_class,
+            float priority, uint64_t now_usec);
+  // Bytes sent around the queue.
+  void charge(int bytes);
+  // Refills the bucket for `delta` seconds and moves what it allows to
+  // `r_packets`, in send order. Everything goes with a zero budget.
+  void pop_ready(float delta, uint64_t now_usec,
+                 std::vector<Packet> &r_packets);
+  // Called with ENet's link statistics every sampling window.
+  void adapt(float rtt_ms, float packet_loss);
+  void set_configured_budget(float bytes_per_sec);
+  void clear();
+
+  int get_depth() const { return static_cast<int>(_packets.size()); }
+  int64_t get_queued_bytes() const { return _queued_bytes; }
+  float get_budget() const { return _budget; }
+  float get_min_rtt_ms() const { return _min_rtt_ms; }
+  float get_oldest_wait_ms(uint64_t now_usec) const;
+  uint64_t get_starved_count() const { return _starved; }
+  uint64_t get_longest_wait_usec() const { return _longest_wait_usec; }
+
+private:
+  std::vector<Packet> _packets;
+  int64_t _queued_bytes = 0;
+  float _configured_budget = 0.0f;
+  float _budget = 0.0f;
+  // May go negative: a large packet or an immediate send borrows ahead.
+  float _tokens = 0.0f;
+  float _min_rtt_ms = 0.0f;
+
+  uint64_t _starved = 0;
+  uint64_t _longest_wait_usec = 0;
+};
+
+} // namespace morphic
@@ -0,0 +1,76 @@
+#include "player_input_buffer.h"
+
+namespace morphic {
+
+void PlayerInputBuffer::reset_to(uint32_t tick) {
+  _present.fill(false);
+  _count = 0;
+  _next_tick = tick;
+  _newest_tick = tick;
+}
+
+bool PlayerInputBuffer::push(const PlayerInputState &input) {
+  if (input.tick == 0) {
+    return false;
+  }
+  if (_next_tick == 0) {
+    reset_to(input.tick);
+  }
+
+  if (input.tick < _next_tick) {
+    _late++;
+    return false;
+  }
+  if (input.tick - _next_tick >= k_capacity) {
+    // The client ran far ahead (stall, long loss burst); whatever is still
+    // queued is too old to matter. Restart from this tick.
+    _skipped += static_cast<uint64_t>(input.tick - _next_tick);
+    reset_to(input.tick);
+  }
+
+  const uint32_t slot = input.tick % k_capacity;
+  if (_present[slot]) {
+    _duplicates++;
+    return false;
+  }
+
+  _slots[slot] = input;
+  _present[slot] = true;
+  _count++;
+  if (input.tick > _newest_tick) {
+    _newest_tick = input.tick;
+  }
+  return true;
+}
+
+bool PlayerInputBuffer::pop(PlayerInputState &r_input) {
+  if (_count == 0) {
+    if (_next_tick != 0) {
+      _starved++;
+    }
+    return false;
+  }
+
+  // Something newer is queued, so a missing _next_tick is lost for good.
+  while (!_present[_next_tick % k_capacity]) {
+    _next_tick++;
+    _skipped++;
+  }
+
+  const uint32_t slot = _next_tick % k_capacity;
+  r_input = _slots[slot];
+  _present[slot] = false;
+  _count--;
+  _next_tick++;
+  return true;
+}
+
+void PlayerInputBuffer::clear() {
+  reset_to(0);
+  _duplicates = 0;
+  _late = 0;
+  _skipped = 0;
+  _starved = 0;
+}
+
+} // namespace morphic
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "player/player_input.h"
+
+#include <array>
+#include <cstdint>
+
+namespace morphic {
+
+// Server-side per-peer input queue indexed by input tick. Redundant packets
+// deliver most ticks several times and out of order; duplicates and ticks
+// that were already consumed are dropped, and a gap that redundancy could
+// not fill is skipped once newer input is waiting.
+class PlayerInputBuffer {
+public:
+  static constexpr uint32_t k_capacity = 64;
+
+  // False when the input was a duplicate or arrived after its tick ran.
+  // Push the inputs of one packet oldest first.
+  bool push(const PlayerInputState &input);
+  // Next input in tick order; false when starved.
+  bool pop(PlayerInputState &r_input);
+  void clear();
+
+  // Inputs received and not yet consumed. This is what the client is told,
+  // so it can tell how far ahead of the server its input stream runs.
+  int get_fill() const { return _count; }
+  uint32_t get_newest_tick() const { return _newest_tick; }
+
+  uint64_t get_duplicate_count() const { return _duplicates; }
+  uint64_t get_late_count() const { return _late; }
+  uint64_t get_skipped_count() const { return _skipped; }
+  uint64_t get_starved_count() const { return _starved; }
+
+private:
+  std::array<PlayerInputState, k_capacity> _slots;
+  std::array<bool, k_capacity> _present = {};
+  // Next tick to consume; 0 until the first input arrives.
+  uint32_t _next_tick = 0;
+  uint32_t _newest_tick = 0;
+  int _count = 0;
+
+  uint64_t _duplicates = 0;
+  uint64_t _late = 0;
+  uint64_t _skipped = 0;
+  uint64_t _starved = 0;
+
+  void reset_to(uint32_t tick);
+};
+
+} // namespace morphic
@@ -0,0 +1,111 @@
+#include "player_input_packet.h"
+
+#include "bit_stream.h"
+
+#include <godot_cpp/core/math.hpp>
+
+#include <algorithm>
+
+namespace morphic {
+
+namespace {
+
+constexpr int k_tick_bits = 32;
+constexpr int k_count_bits = 3; // count - 1
+constexpr int k_move_bits = 8;
+constexpr float k_move_scale = 127.0f;
+constexpr int k_look_bits = 16;
+constexpr float k_look_scale = 8.0f;
+constexpr int k_button_bits = 6;
+constexpr int k_view_tick_bits = 16;
+
+int32_t quantize_move(float value) {
+  return static_cast<int32_t>(
+      Math::clamp(Math::round(value * k_move_scale), -k_move_scale,
+                  k_move_scale));
+}
+
+int32_t quantize_look(float value) {
+  const float limit = static_cast<float>((1 << (k_look_bits - 1)) - 1);
+  return static_cast<int32_t>(
+      Math::clamp(Math::round(value * k_look_scale), -limit, limit));
+}
+
+} // namespace
+
+void PlayerInputCodec::quantize(PlayerInputState &r_input) {
+  r_input.move.x = quantize_move(r_input.move.x) / k_move_scale;
+  r_input.move.y = quantize_move(r_input.move.y) / k_move_scale;
+  r_input.look.x = quantize_look(r_input.look.x) / k_look_scale;
+  r_input.look.y = quantize_look(r_input.look.y) / k_look_scale;
+}
+
+PackedByteArray
+PlayerInputCodec::encode(const std::vector<PlayerInputState> &inputs) {
+  const int count = std::min(static_cast<int>(inputs.size()), k_max_inputs);
+  if (count == 0) {
+    return PackedByteArray();
+  }
+
+  BitWriter writer;
+  writer.write_bits(inputs[0].tick, k_tick_bits);
+  writer.write_bits(static_cast<uint32_t>(count - 1), k_count_bits);
+  for (int i = 0; i < count; i++) {
+    const PlayerInputState &input = inputs[i];
+    writer.write_signed(quantize_move(input.move.x), k_move_bits);
+    writer.write_signed(quantize_move(input.move.y), k_move_bits);
+    const int32_t look_x = quantize_look(input.look.x);
+    const int32_t look_y = quantize_look(input.look.y);
+    const bool has_look = look_x != 0 || look_y != 0;
+    writer.write_bool(has_look);
+    if (has_look) {
+      writer.write_signed(look_x, k_look_bits);
+      writer.write_signed(look_y, k_look_bits);
+    }
+    writer.write_bits(pack_input_buttons(input), k_button_bits);
+    if (input.primary_action) {
+      writer.write_bits(input.view_tick, k_view_tick_bits);
+    }
+  }
+  return writer.to_packed();
+}
+
+bool PlayerInputCodec::decode(const PackedByteArray &bytes,
+                              std::vector<PlayerInputState> &r_inputs) {
+  r_inputs.clear();
+  if (bytes.is_empty() || bytes.size() > k_max_packet_bytes) {
+    return false;
+  }
+
+  BitReader reader(bytes);
+  const uint32_t newest_tick = reader.read_bits(k_tick_bits);
+  const int count = static_cast<int>(reader.read_bits(k_count_bits)) + 1;
+  if (newest_tick < static_cast<uint32_t>(count)) {
+    return false;
+  }
+
+  for (int i = 0; i < count; i++) {
+    PlayerInputState input;
+    input.tick = newest_tick - static_cast<uint32_t>(i);
+    input.move.x = reader.read_signed(k_move_bits) / k_move_scale;
+    input.move.y = reader.read_signed(k_move_bits) / k_move_scale;
+    if (reader.read_bool()) {
+      input.look.x = reader.read_signed(k_look_bits) / k_look_scale;
+      input.look.y = reader.read_signed(k_look_bits) / k_look_scale;
+    }
+    unpack_input_buttons(static_cast<uint8_t>(reader.read_bits(k_button_bits)),
+                         input);
+    if (input.primary_action) {
+      input.view_tick = reader.read_bits(k_view_tick_bits);
+    }
+    r_inputs.push_back(input);
+  }
+
+  if (reader.has_overflowed()) {
+    r_inputs.clear();
+    return false;
+  }
+  return true;
+}
+
+} // namespace morphic
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "player/player_input.h"
+
+#include <godot_cpp/variant/packed_byte_array.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace godot;
+
+namespace morphic {
+
+// Wire format of the client -> server input stream. Every packet carries the
+// newest input plus up to k_max_inputs - 1 older ones (consecutive ticks,
+// newest first), so a single lost datagram never costs the server a tick.
+//   move:    8 bit signed per axis, 1/127
+//   look:    16 bit signed per axis, 1/8 px (+-4096 px per tick), skipped
+//            with one bit when the mouse did not move
+//   buttons: PlayerInputButton bitfield, 6 bit
+//   view:    low 16 bit of view_tick, only when primary_action is set; the
+//            server unwraps it against its own tick
+namespace PlayerInputCodec {
+static constexpr int k_max_inputs = 8;
+static constexpr int k_max_packet_bytes = 80;
+
+// Rounds the input to what survives the wire. The client simulates the
+// quantized input so its prediction matches the server bit for bit.
+void quantize(PlayerInputState &r_input);
+
+// `inputs` is newest first; only the first k_max_inputs are written.
+PackedByteArray encode(const std::vector<PlayerInputState> &inputs);
+bool decode(const PackedByteArray &bytes,
+            std::vector<PlayerInputState> &r_inputs);
+} // namespace PlayerInputCodec
+
+} // namespace morphic
@@ -0,0 +1,296 @@
+#include "player_snapshot.h"
+
+#include "bit_stream.h"
+
+#include <godot_cpp/core/math.hpp>
+
+#include <algorithm>
+
+namespace morphic {
+
+namespace {
+
+constexpr int k_position_bits = 24;
+constexpr int k_position_delta_bits = 10;
+constexpr float k_position_scale = 256.0f;
+
+constexpr int k_angle_bits = 16;
+constexpr int k_angle_delta_bits = 8;
+
+constexpr int k_velocity_bits = 16;
+constexpr int k_velocity_delta_bits = 8;
+constexpr float k_velocity_scale = 64.0f;
+
+// Changed flag, full flag and the full value per component.
+static_assert(PlayerSnapshotCodec::k_max_player_bits ==
+                  1 + 32 + 1 + 3 * (2 + k_position_bits) +
+                      2 * (2 + k_angle_bits) + 3 * (2 + k_velocity_bits),
+              "k_max_player_bits out of date");
+static_assert(PlayerSnapshotCodec::k_header_bits == 32 + 32 + 32 + 8 + 8 + 8,
+              "k_header_bits out of date");
+
+int32_t clamp_signed(double value, int bits) {
+  const double max_value = static_cast<double>((int64_t(1) << (bits - 1)) - 1);
+  const double min_value = -static_cast<double>(int64_t(1) << (bits - 1));
+  return static_cast<int32_t>(
+      Math::clamp(Math::round(value), min_value, max_value));
+}
+
+bool fits_signed(int64_t value, int bits) {
+  const int64_t limit = int64_t(1) << (bits - 1);
+  return value >= -limit && value < limit;
+}
+
+void write_component(BitWriter &writer, int32_t value, int32_t base,
+                     int full_bits, int delta_bits) {
+  if (value == base) {
+    writer.write_bool(false);
+    return;
+  }
+  writer.write_bool(true);
+  const int64_t delta = int64_t(value) - int64_t(base);
+  if (fits_signed(delta, delta_bits)) {
+    writer.write_bool(false);
+    writer.write_signed(static_cast<int32_t>(delta), delta_bits);
+  } else {
+    writer.write_bool(true);
+    writer.write_signed(value, full_bits);
+  }
+}
+
+int32_t read_component(BitReader &reader, int32_t base, int full_bits,
+                       int delta_bits) {
+  if (!reader.read_bool()) {
+    return base;
+  }
+  if (!reader.read_bool()) {
+    return base + reader.read_signed(delta_bits);
+  }
+  return reader.read_signed(full_bits);
+}
+
+void write_state(BitWriter &writer, const QuantizedPlayerState &state,
+                 const QuantizedPlayerState &base) {
+  for (int i = 0; i < 3; i++) {
+    write_component(writer, state.position[i], base.position[i],
+                    k_position_bits, k_position_delta_bits);
+  }
+  write_component(writer, state.yaw, base.yaw, k_angle_bits,
+                  k_angle_delta_bits);
+  write_component(writer, state.pitch, base.pitch, k_angle_bits,
+                  k_angle_delta_bits);
+  for (int i = 0; i < 3; i++) {
+    write_component(writer, state.velocity[i], base.velocity[i],
+                    k_velocity_bits, k_velocity_delta_bits);
+  }
+}
+
+void read_state(BitReader &reader, const QuantizedPlayerState &base,
+                QuantizedPlayerState &r_state) {
+  for (int i = 0; i < 3; i++) {
+    r_state.position[i] = read_component(reader, base.position[i],
+                                         k_position_bits,
+                                         k_position_delta_bits);
+  }
+  r_state.yaw =
+      read_component(reader, base.yaw, k_angle_bits, k_angle_delta_bits);
+  r_state.pitch =
+      read_component(reader, base.pitch, k_angle_bits, k_angle_delta_bits);
+  for (int i = 0; i < 3; i++) {
+    r_state.velocity[i] = read_component(reader, base.velocity[i],
+                                         k_velocity_bits,
+                                         k_velocity_delta_bits);
+  }
+}
+
+} // namespace
+
+QuantizedPlayerState
+QuantizedPlayerState::quantize(int32_t peer_id, const PlayerNetState &state) {
+  QuantizedPlayerState q;
+  q.peer_id = peer_id;
+  for (int i = 0; i < 3; i++) {
+    q.position[i] =
+        clamp_signed(state.position[i] * k_position_scale, k_position_bits);
+    q.velocity[i] =
+        clamp_signed(state.velocity[i] * k_velocity_scale, k_velocity_bits);
+  }
+  const double yaw = Math::wrapf(state.yaw, -Math_PI, Math_PI);
+  q.yaw = clamp_signed(yaw / Math_PI * 32768.0, k_angle_bits);
+  q.pitch = clamp_signed(state.pitch / (Math_PI * 0.5) * 32767.0, k_angle_bits);
+  return q;
+}
+
+PlayerNetState QuantizedPlayerState::dequantize() const {
+  PlayerNetState state;
+  for (int i = 0; i < 3; i++) {
+    state.position[i] = position[i] / k_position_scale;
+    state.velocity[i] = velocity[i] / k_velocity_scale;
+  }
+  state.yaw = static_cast<float>(yaw / 32768.0 * Math_PI);
+  state.pitch = static_cast<float>(pitch / 32767.0 * Math_PI * 0.5);
+  return state;
+}
+
+bool QuantizedPlayerState::operator==(const QuantizedPlayerState &o) const {
+  return peer_id == o.peer_id && position[0] == o.position[0] &&
+         position[1] == o.position[1] && position[2] == o.position[2] &&
+         yaw == o.yaw && pitch == o.pitch && velocity[0] == o.velocity[0] &&
+         velocity[1] == o.velocity[1] && velocity[2] == o.velocity[2];
+}
+
+const QuantizedPlayerState *PlayerSnapshot::find(int32_t peer_id) const {
+  auto it = std::lower_bound(
+      players.begin(), players.end(), peer_id,
+      [](const QuantizedPlayerState &state, int32_t id) {
+        return state.peer_id < id;
+      });
+  if (it == players.end() || it->peer_id != peer_id) {
+    return nullptr;
+  }
+  return &(*it);
+}
+
+namespace PlayerSnapshotCodec {
+
+PackedByteArray encode(const PlayerSnapshot &snapshot,
+                       const PlayerSnapshot *baseline) {
+  uint32_t baseline_age = 0;
+  if (baseline && snapshot.sequence > baseline->sequence &&
+      snapshot.sequence - baseline->sequence <= k_max_baseline_age) {
+    baseline_age = snapshot.sequence - baseline->sequence;
+  } else {
+    baseline = nullptr;
+  }
+
+  const int count =
+      std::min(static_cast<int>(snapshot.players.size()), k_max_players);
+  const int index_bits =
+      baseline ? bits_for_count(static_cast<uint32_t>(baseline->players.size()))
+               : 0;
+
+  BitWriter writer;
+  writer.write_bits(snapshot.sequence, 32);
+  writer.write_bits(snapshot.server_tick, 32);
+  writer.write_bits(snapshot.ack_tick, 32);
+  writer.write_bits(snapshot.input_fill, 8);
+  writer.write_bits(baseline_age, 8);
+  writer.write_bits(static_cast<uint32_t>(count), 8);
+
+  const QuantizedPlayerState zero;
+  for (int i = 0; i < count; i++) {
+    const QuantizedPlayerState &state = snapshot.players[i];
+    const QuantizedPlayerState *base =
+        baseline ? baseline->find(state.peer_id) : nullptr;
+
+    writer.write_bool(base != nullptr);
+    if (base) {
+      writer.write_bits(static_cast<uint32_t>(base - baseline->players.data()),
+                        index_bits);
+    } else {
+      writer.write_bits(static_cast<uint32_t>(state.peer_id), 32);
+      base = &zero;
+    }
+
+    const bool changed = !(state == *base) || base == &zero;
+    writer.write_bool(changed);
+    if (changed) {
+      write_state(writer, state, *base);
+    }
+  }
+
+  return writer.to_packed();
+}
+
+bool peek_baseline(const PackedByteArray &bytes, uint32_t &r_sequence,
+                   uint32_t &r_baseline_sequence) {
+  BitReader reader(bytes);
+  r_sequence = reader.read_bits(32);
+  reader.read_bits(32); // server_tick
+  reader.read_bits(32); // ack_tick
+  reader.read_bits(8);  // input_fill
+  const uint32_t age = reader.read_bits(8);
+  r_baseline_sequence = age == 0 ? 0 : r_sequence - age;
+  return !reader.has_overflowed();
+}
+
+bool decode(const PackedByteArray &bytes, const PlayerSnapshot *baseline,
+            PlayerSnapshot &r_snapshot) {
+  BitReader reader(bytes);
+  r_snapshot.sequence = reader.read_bits(32);
+  r_snapshot.server_tick = reader.read_bits(32);
+  r_snapshot.ack_tick = reader.read_bits(32);
+  r_snapshot.input_fill = static_cast<uint8_t>(reader.read_bits(8));
+  const uint32_t baseline_age = reader.read_bits(8);
+  const int count = static_cast<int>(reader.read_bits(8));
+
+  if (baseline_age != 0) {
+    if (!baseline ||
+        baseline->sequence != r_snapshot.sequence - baseline_age) {
+      return false;
+    }
+  } else {
+    baseline = nullptr;
+  }
+
+  const int index_bits =
+      baseline ? bits_for_count(static_cast<uint32_t>(baseline->players.size()))
+               : 0;
+
+  r_snapshot.players.clear();
+  r_snapshot.players.reserve(count);
+
+  const QuantizedPlayerState zero;
+  for (int i = 0; i < count; i++) {
+    QuantizedPlayerState state;
+    const QuantizedPlayerState *base = &zero;
+
+    if (reader.read_bool()) {
+      const uint32_t index = reader.read_bits(index_bits);
+      if (!baseline || index >= baseline->players.size()) {
+        return false;
+      }
+      base = &baseline->players[index];
+      state.peer_id = base->peer_id;
+    } else {
+      state.peer_id = static_cast<int32_t>(reader.read_bits(32));
+    }
+
+    if (reader.read_bool()) {
+      read_state(reader, *base, state);
+    } else {
+      state = *base;
+    }
+
+    if (reader.has_overflowed()) {
+      return false;
+    }
+    r_snapshot.players.push_back(state);
+  }
+
+  std::sort(r_snapshot.players.begin(), r_snapshot.players.end(),
+            [](const QuantizedPlayerState &a, const QuantizedPlayerState &b) {
+              return a.peer_id < b.peer_id;
+            });
+  return !reader.has_overflowed();
+}
+
+} // namespace PlayerSnapshotCodec
+
+void PlayerSnapshotHistory::store(const PlayerSnapshot &snapshot) {
+  const uint32_t slot = snapshot.sequence % k_capacity;
+  _slots[slot] = snapshot;
+  _used[slot] = true;
+}
+
+const PlayerSnapshot *PlayerSnapshotHistory::find(uint32_t sequence) const {
+  const uint32_t slot = sequence % k_capacity;
+  if (!_used[slot] || _slots[slot].sequence != sequence) {
+    return nullptr;
+  }
+  return &_slots[slot];
+}
+
+void PlayerSnapshotHistory::clear() { _used.fill(false); }
+
+} // namespace morphic
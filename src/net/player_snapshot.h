@@ -0,0 +1,85 @@
+#pragma once
+
+#include "player/player_net_state.h"
+
+#include <godot_cpp/variant/packed_byte_array.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+using namespace godot;
+
+namespace morphic {
+
+// Fixed-point player state as it goes over the wire.
+//   position: 1/256 m (~4 mm), 24 bit signed  -> +-32 km
+//   yaw:      full turn in 16 bit
+//   pitch:    +-90 deg in 16 bit signed
+//   velocity: 1/64 m/s, 16 bit signed         -> +-512 m/s
+struct QuantizedPlayerState {
+  int32_t peer_id = 0;
+  int32_t position[3] = {0, 0, 0};
+  int32_t yaw = 0;
+  int32_t pitch = 0;
+  int32_t velocity[3] = {0, 0, 0};
+
+  static QuantizedPlayerState quantize(int32_t peer_id,
+                                       const PlayerNetState &state);
+  PlayerNetState dequantize() const;
+  bool operator==(const QuantizedPlayerState &other) const;
+};
+
+struct PlayerSnapshot {
+  uint32_t sequence = 0;
+  uint32_t server_tick = 0;
+  // Last input tick the server simulated for the receiving peer's player.
+  uint32_t ack_tick = 0;
+  // Inputs the server holds queued for that player (PlayerInputBuffer fill).
+  uint8_t input_fill = 0;
+  // Sorted by peer_id.
+  std::vector<QuantizedPlayerState> players;
+
+  const QuantizedPlayerState *find(int32_t peer_id) const;
+};
+
+// Bit-packed encoding of a snapshot against an optional baseline the
+// receiver already has. Unchanged players cost one bit plus their baseline
+// index; changed components are sent as small deltas when they fit.
+namespace PlayerSnapshotCodec {
+static constexpr uint32_t k_max_baseline_age = 255;
+static constexpr int k_max_players = 255;
+// Largest encoding: the header plus k_max_players entries sent in full
+// (peer id and every component at full width).
+static constexpr int k_header_bits = 120;
+static constexpr int k_max_player_bits = 202;
+static constexpr int k_max_encoded_bytes =
+    (k_header_bits + k_max_players * k_max_player_bits + 7) / 8;
+
+PackedByteArray encode(const PlayerSnapshot &snapshot,
+                       const PlayerSnapshot *baseline);
+
+// Reads the baseline sequence the packet was encoded against (0 = none)
+// without decoding the rest.
+bool peek_baseline(const PackedByteArray &bytes, uint32_t &r_sequence,
+                   uint32_t &r_baseline_sequence);
+
+bool decode(const PackedByteArray &bytes, const PlayerSnapshot *baseline,
+            PlayerSnapshot &r_snapshot);
+} // namespace PlayerSnapshotCodec
+
+// Ring of recently sent/received snapshots, indexed by sequence.
+class PlayerSnapshotHistory {
+public:
+  static constexpr uint32_t k_capacity = 32;
+
+  void store(const PlayerSnapshot &snapshot);
+  const PlayerSnapshot *find(uint32_t sequence) const;
+  void clear();
+
+private:
+  std::array<PlayerSnapshot, k_capacity> _slots;
+  std::array<bool, k_capacity> _used = {};
+};
+
+} // namespace morphic
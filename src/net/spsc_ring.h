@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace morphic {
+
+// Bounded lock-free queue between exactly one producer thread (try_push)
+// and one consumer thread (try_pop). Neither side blocks, and nothing is
+// allocated after construction. A full ring refuses the item; the caller
+// decides whether to drop or hold it.
+template <typename T> class SpscRing {
+public:
+  // Rounded up to a power of two.
+  explicit SpscRing(uint32_t capacity) {
+    uint32_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    _slots.resize(size);
+    _mask = size - 1;
+  }
+
+  // Producer side.
+  bool try_push(T &&item) {
+    const uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _head.load(std::memory_order_acquire) > _mask) {
+      return false;
+    }
+    _slots[tail & _mask] = std::move(item);
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. The slot is cleared so it does not keep its payload
+  // (packet buffers) alive until overwritten.
+  bool try_pop(T &r_item) {
+    const uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    r_item = std::move(_slots[head & _mask]);
+    _slots[head & _mask] = T();
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Either side; a snapshot that may be stale by the time it is read.
+  uint32_t size() const {
+    return _tail.load(std::memory_order_acquire) -
+           _head.load(std::memory_order_acquire);
+  }
+  uint32_t capacity() const { return _mask + 1; }
+
+private:
+  std::vector<T> _slots;
+  uint32_t _mask = 0;
+  // Separate cache lines: each index is written by one thread only.
+  alignas(64) std::atomic<uint32_t> _head{0};
+  alignas(64) std::atomic<uint32_t> _tail{0};
+};
+
+} // namespace morphic
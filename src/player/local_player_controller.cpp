@@ -1,11 +1,21 @@
 #include "local_player_controller.h"
+#include "net/player_input_packet.h"
 #include "player.h"
+#include "utils/network_utils.h"
 
 #include <godot_cpp/classes/engine.hpp>
 
 namespace morphic {
 
-void LocalPlayerController::_bind_methods() {}
+void LocalPlayerController::_bind_methods() {
+  godot::ClassDB::bind_method(
+      godot::D_METHOD("get_pending_input_count"),
+      &LocalPlayerController::get_pending_input_count);
+  godot::ClassDB::bind_method(godot::D_METHOD("get_correction_count"),
+                              &LocalPlayerController::get_correction_count);
+  godot::ClassDB::bind_method(godot::D_METHOD("get_server_input_fill"),
+                              &LocalPlayerController::get_server_input_fill);
+}
 
 void LocalPlayerController::_ready() {
   _player = godot::Object::cast_to<Player>(get_parent());
@@ -51,12 +61,31 @@ void LocalPlayerController::_physics_process(double delta) {
     return;
   }
 
+  if (_has_server_state) {
+    _has_server_state = false;
+    const uint64_t corrections = _prediction.get_correction_count();
+    _prediction.reconcile(*_player, _movement, _server_state, delta);
+    if (_prediction.get_correction_count() != corrections) {
+      // The server moved us (the floor was dug away, say): simulate again.
+      _player->wake_dormant();
+    }
+  }
+
   _input_state.poll_actions();
   PlayerInputState state = _input_state.consume();
+  state.tick = ++_input_tick;
+  if (_player->is_locally_predicted()) {
+    PlayerInputCodec::quantize(state);
+  }
 
   if (state.primary_action) {
+    state.view_tick = _player->get_client_view_tick();
     _player->trigger_right_item_action("primary");
   }
+  if (NetUtils::is_server(_player)) {
+    // The host sees the server's present, so its swings need no rewind.
+    _player->server_apply_primary(state.primary_action, state.view_tick);
+  }
 
   // toggle
   if (state.toggle_torch) {
@@ -67,10 +96,54 @@ void LocalPlayerController::_physics_process(double delta) {
   }
   //
 
-  _movement.tick(*_player, state, delta);
+  // A dormant player's step would leave it where it is; skip it.
+  const bool idle = PlayerDormancy::is_idle_input(state);
+  if (!idle) {
+    _player->wake_dormant();
+  }
+  if (!_player->is_dormant()) {
+    _movement.tick(*_player, state, delta);
+  }
   if (_camera_ready) {
     _camera.tick(state, _player->get_sensitivity());
   }
+  _player->update_dormancy(idle);
+
+  // Server-authoritative mode: keep what we predicted so it can be checked
+  // against (and replayed on top of) the server state, then ship it along
+  // with every input the server has not acked yet.
+  if (_player->is_locally_predicted()) {
+    _prediction.record(state, *_player);
+    _prediction.collect_unacked_inputs(PlayerInputCodec::k_max_inputs,
+                                       _outgoing_inputs);
+    _player->send_input_to_server(PlayerInputCodec::encode(_outgoing_inputs));
+  }
+}
+
+void LocalPlayerController::apply_server_state(const PlayerNetState &state) {
+  // RPCs arrive during the idle frame; reconcile at the start of the next
+  // physics tick so replayed movement steps run with physics state.
+  if (_has_server_state && state.tick < _server_state.tick) {
+    return;
+  }
+  _server_state = state;
+  _has_server_state = true;
+}
+
+void LocalPlayerController::apply_input_feedback(int fill) {
+  _server_input_fill = fill;
+}
+
+int LocalPlayerController::get_server_input_fill() const {
+  return _server_input_fill;
+}
+
+int LocalPlayerController::get_pending_input_count() const {
+  return _prediction.get_pending_count();
+}
+
+int LocalPlayerController::get_correction_count() const {
+  return static_cast<int>(_prediction.get_correction_count());
 }
 
 } // namespace morphic
@@ -3,10 +3,13 @@
 #include "player_camera.h"
 #include "player_input.h"
 #include "player_movement.h"
+#include "player_prediction.h"
 
 #include <godot_cpp/classes/input_event.hpp>
 #include <godot_cpp/classes/node.hpp>
 
+#include <vector>
+
 namespace morphic {
 
 class Player;
@@ -22,13 +25,29 @@ public:
   void _input(const godot::Ref<godot::InputEvent> &event) override;
   void _physics_process(double delta) override;
 
+  // Called by Player when the server sent authoritative state for us.
+  void apply_server_state(const PlayerNetState &state);
+  // Server's input buffer fill for us, as of the latest snapshot.
+  void apply_input_feedback(int fill);
+
+  int get_server_input_fill() const;
+
+  int get_pending_input_count() const;
+  int get_correction_count() const;
+
 private:
   Player *_player = nullptr;
   bool _camera_ready = false;
+  uint32_t _input_tick = 0;
+  PlayerNetState _server_state;
+  bool _has_server_state = false;
+  int _server_input_fill = 0;
+  std::vector<PlayerInputState> _outgoing_inputs;
 
   PlayerInput _input_state;
   PlayerMovement _movement;
   PlayerCamera _camera;
+  PlayerPrediction _prediction;
 };
 
 } // namespace morphic
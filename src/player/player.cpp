@@ -1,11 +1,18 @@
 #include "player.h"
 #include "local_player_controller.h"
+#include "net/player_input_packet.h"
 #include "player_equipment.h"
 #include "utils/bind_methods.h"
 #include "utils/debug_utils.h"
+#include "utils/network_utils.h"
 
 #include <godot_cpp/classes/camera3d.hpp>
 #include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/multiplayer_peer.hpp>
+#include <godot_cpp/classes/scene_replication_config.hpp>
+#include <godot_cpp/classes/time.hpp>
+
+#include <algorithm>
 
 using namespace godot;
 
@@ -21,6 +28,300 @@ Node3D *Player::get_head_node() const { return _head_node; }
 double Player::get_gravity() const { return _gravity; }
 double Player::get_jump_velocity() const { return _jump_velocity; }
 
+bool Player::get_server_authoritative() const {
+  return _server_authoritative;
+}
+void Player::set_server_authoritative(bool p_enabled) {
+  _server_authoritative = p_enabled;
+}
+
+bool Player::is_server_simulated() const {
+  return _server_authoritative && NetUtils::is_server(this) &&
+         !is_multiplayer_authority();
+}
+
+bool Player::is_locally_predicted() const {
+  return _server_authoritative && is_multiplayer_authority() &&
+         !NetUtils::is_server(this);
+}
+
+void Player::server_simulate(double delta) {
+  PlayerInputState inputs[k_max_inputs_per_tick];
+  const int count = server_take_inputs(inputs);
+  for (int i = 0; i < count; i++) {
+    const bool idle = PlayerDormancy::is_idle_input(inputs[i]);
+    if (!idle) {
+      wake_dormant();
+    }
+    if (!is_dormant()) {
+      _server_movement.tick(*this, inputs[i], delta);
+      PlayerMovement::apply_yaw(*this, inputs[i]);
+      PlayerMovement::apply_pitch(*this, inputs[i]);
+    }
+    update_dormancy(idle);
+  }
+}
+
+int Player::server_take_inputs(
+    PlayerInputState (&r_inputs)[k_max_inputs_per_tick]) {
+  // Starved (input late or lost): hold the last state until input arrives.
+  if (!_server_inputs.pop(r_inputs[0])) {
+    return 0;
+  }
+  server_apply_input_actions(r_inputs[0]);
+
+  if (_server_inputs.get_fill() > k_input_catch_up_fill &&
+      _server_inputs.pop(r_inputs[1])) {
+    server_apply_input_actions(r_inputs[1]);
+    return 2;
+  }
+  return 1;
+}
+
+void Player::server_apply_input_actions(const PlayerInputState &input) {
+  // Equipment is replicated from the server in this mode, so the toggles
+  // the owner predicted locally are applied here as well.
+  if (input.toggle_torch) {
+    toggle_torch();
+  }
+  if (input.toggle_picaxe) {
+    toggle_picaxe();
+  }
+  server_apply_primary(input.primary_action, input.view_tick);
+  _last_processed_input_tick = input.tick;
+}
+
+void Player::wake_dormant() {
+  if (_dormancy.wake()) {
+    on_dormancy_changed(false);
+  }
+}
+
+void Player::update_dormancy(bool idle_input) {
+  const bool idle =
+      idle_input && _grounded && get_velocity().is_zero_approx();
+  if (_dormancy.observe(idle)) {
+    on_dormancy_changed(true);
+  }
+}
+
+void Player::on_dormancy_changed(bool p_dormant) {
+  // Equipment is the only thing the synchronizer still streams, and any
+  // change to it wakes the player; while dormant it only resends rarely.
+  if (_synchronizer && NetUtils::is_server(this)) {
+    _synchronizer->set_replication_interval(
+        p_dormant ? k_dormant_sync_interval_s : _sync_interval);
+  }
+}
+
+int Player::get_dormancy_ticks() const {
+  return _dormancy.get_threshold_ticks();
+}
+void Player::set_dormancy_ticks(int p_ticks) {
+  if (_dormancy.set_threshold_ticks(p_ticks)) {
+    on_dormancy_changed(false);
+  }
+}
+
+int64_t Player::get_dormancy_wake_count() const {
+  return static_cast<int64_t>(_dormancy.get_wake_count());
+}
+
+PlayerNetState Player::get_net_state() const {
+  PlayerNetState state;
+  state.tick = _last_processed_input_tick;
+  state.position = get_position();
+  state.velocity = get_velocity();
+  state.yaw = get_rotation().y;
+  state.pitch = _head_node ? _head_node->get_rotation().x : 0.0f;
+  return state;
+}
+
+int Player::get_pending_input_count() const {
+  return _server_inputs.get_fill();
+}
+
+int Player::get_last_processed_input_tick() const {
+  return static_cast<int>(_last_processed_input_tick);
+}
+
+int64_t Player::get_skipped_input_count() const {
+  return static_cast<int64_t>(_server_inputs.get_skipped_count());
+}
+
+int64_t Player::get_starved_tick_count() const {
+  return static_cast<int64_t>(_server_inputs.get_starved_count());
+}
+
+void Player::set_replicated_to_peer(int p_peer_id, bool p_visible) {
+  if (!_synchronizer || p_peer_id == _peer_id) {
+    return;
+  }
+  _synchronizer->set_visibility_for(p_peer_id, p_visible);
+}
+
+void Player::send_input_to_server(const PackedByteArray &packet) {
+  if (packet.is_empty()) {
+    return;
+  }
+  NetworkManager *net_manager = NetUtils::get_net_manager(this);
+  if (!net_manager) {
+    return;
+  }
+  PlayerInputMessage message;
+  message.inputs.bytes = packet;
+  net_manager->send_message(1, message);
+}
+
+void Player::server_receive_input(const PackedByteArray &packet) {
+  if (!is_server_simulated()) {
+    return;
+  }
+
+  if (!PlayerInputCodec::decode(packet, _received_inputs)) {
+    return;
+  }
+
+  // The wire carries the low 16 bits of the view tick; it can only lie in
+  // the past, so unwrap it backwards from our current tick.
+  NetworkManager *net_manager = NetUtils::get_net_manager(this);
+  const uint32_t now = net_manager ? net_manager->get_server_tick() : 0;
+
+  // Packets are newest first; the buffer wants ticks in order.
+  for (auto it = _received_inputs.rbegin(); it != _received_inputs.rend();
+       ++it) {
+    it->move = it->move.limit_length(1.0);
+    if (it->primary_action) {
+      it->view_tick = now - ((now - it->view_tick) & 0xFFFFu);
+    }
+    _server_inputs.push(*it);
+  }
+}
+
+void Player::record_transform_history(uint32_t tick) {
+  _transform_history.record(tick, get_global_transform());
+}
+
+void Player::server_apply_primary(bool pressed, uint32_t view_tick) {
+  // A swing starts on the press; holding the button does not repeat it.
+  if (pressed && !_server_primary_held && _equipment) {
+    Ref<ItemDefinition> item = _equipment->get_right_item_def();
+    const bool has_primary =
+        item.is_valid() && (!item->get_hand_action("primary").is_empty() ||
+                            !item->get_full_body_action("primary").is_empty());
+    if (has_primary) {
+      _swing_pending = true;
+      _swing_view_tick = view_tick;
+    }
+  }
+  _server_primary_held = pressed;
+}
+
+bool Player::consume_pending_swing(uint32_t &r_view_tick) {
+  if (!_swing_pending) {
+    return false;
+  }
+  _swing_pending = false;
+  r_view_tick = _swing_view_tick;
+  return true;
+}
+
+void Player::apply_input_feedback(int fill) {
+  if (_local_controller) {
+    _local_controller->apply_input_feedback(fill);
+  }
+}
+
+void Player::apply_net_state(const PlayerNetState &state) {
+  if (is_multiplayer_authority()) {
+    if (_local_controller) {
+      _local_controller->apply_server_state(state);
+    }
+    return;
+  }
+  apply_presented_state(state);
+}
+
+void Player::push_remote_state(uint32_t server_tick,
+                               const PlayerNetState &state) {
+  if (is_multiplayer_authority()) {
+    return;
+  }
+  const double tick_rate =
+      Engine::get_singleton()->get_physics_ticks_per_second();
+  const double now = Time::get_singleton()->get_ticks_usec() / 1000000.0;
+  _interpolation.push(server_tick / tick_rate, now, state);
+}
+
+uint32_t Player::get_presented_tick() const {
+  const double tick_rate =
+      Engine::get_singleton()->get_physics_ticks_per_second();
+  const double render_time = _interpolation.get_render_time();
+  return render_time > 0.0
+             ? static_cast<uint32_t>(render_time * tick_rate + 0.5)
+             : 0;
+}
+
+uint32_t Player::get_client_view_tick() const {
+  // All remote players share one presentation delay give or take jitter,
+  // so the newest of them stands for what we see.
+  uint32_t view_tick = 0;
+  Node *parent = get_parent();
+  for (int i = 0; parent && i < parent->get_child_count(); i++) {
+    const Player *other = Object::cast_to<Player>(parent->get_child(i));
+    if (other && other != this && !other->is_multiplayer_authority()) {
+      view_tick = std::max(view_tick, other->get_presented_tick());
+    }
+  }
+  if (view_tick > 0) {
+    return view_tick;
+  }
+  NetworkManager *net_manager = NetUtils::get_net_manager(this);
+  return net_manager ? net_manager->get_server_tick() : 0;
+}
+
+void Player::apply_presented_state(const PlayerNetState &state) {
+  Vector3 rotation = get_rotation();
+  rotation.y = state.yaw;
+  set_rotation(rotation);
+  set_position(state.position);
+  set_velocity(state.velocity);
+
+  if (_head_node) {
+    Vector3 head_rotation = _head_node->get_rotation();
+    head_rotation.x = state.pitch;
+    _head_node->set_rotation(head_rotation);
+  }
+}
+
+void Player::update_interpolation(double delta) {
+  const double now = Time::get_singleton()->get_ticks_usec() / 1000000.0;
+  PlayerNetState state;
+  if (_interpolation.sample(now, delta, state)) {
+    apply_presented_state(state);
+  }
+}
+
+int Player::get_interpolation_buffer_depth() const {
+  return _interpolation.get_buffer_depth();
+}
+
+float Player::get_interpolation_delay() const {
+  return static_cast<float>(_interpolation.get_delay());
+}
+
+float Player::get_interpolation_jitter() const {
+  return static_cast<float>(_interpolation.get_jitter());
+}
+
+float Player::get_extrapolation_time() const {
+  return static_cast<float>(_interpolation.get_extrapolation_time());
+}
+
+int64_t Player::get_interpolation_snap_count() const {
+  return static_cast<int64_t>(_interpolation.get_snap_count());
+}
+
 void Player::notify_jump() {
   if (!_player_animator) {
     return;
@@ -106,6 +407,9 @@ void Player::_enter_tree() {
   if (Engine::get_singleton()->is_editor_hint()) {
     return;
   }
+  if (_server_authoritative) {
+    configure_replication();
+  }
   _terrain_viewer.setup_viewer(this);
 }
 
@@ -129,11 +433,16 @@ void Player::_ready() {
     ensure_local_controller();
   }
 
-  Node *player_animator_node = get_node_or_null(_player_animator_path);
-  ERR_FAIL_COND_MSG(!player_animator_node,
-                    "Cant find PlayerAnimator node. Check if path is correct");
-  _player_animator = cast_to<PlayerAnimator>(player_animator_node);
-  ERR_FAIL_COND_MSG(!_player_animator, "Cast to PlayerAnimator failed.");
+  // The dedicated server's player scene has no animator and no hand
+  // sockets; it leaves their paths empty.
+  if (!_player_animator_path.is_empty()) {
+    Node *player_animator_node = get_node_or_null(_player_animator_path);
+    ERR_FAIL_COND_MSG(
+        !player_animator_node,
+        "Cant find PlayerAnimator node. Check if path is correct");
+    _player_animator = cast_to<PlayerAnimator>(player_animator_node);
+    ERR_FAIL_COND_MSG(!_player_animator, "Cast to PlayerAnimator failed.");
+  }
 
   Node *equipment_node = get_node_or_null(_equipment_path);
   if (!equipment_node) {
@@ -154,33 +463,53 @@ void Player::_ready() {
     }
   }
 
-  Node *left_hand_socket_node = get_node_or_null(_left_hand_socket_path);
-  ERR_FAIL_COND_MSG(
-      !left_hand_socket_node,
-      "Cant find left hand socket node. Check if path is correct");
-  _left_hand_socket = cast_to<Marker3D>(left_hand_socket_node);
-  ERR_FAIL_COND_MSG(!_left_hand_socket, "Failed casting to Left Hand Socked");
+  if (!_left_hand_socket_path.is_empty()) {
+    Node *left_hand_socket_node = get_node_or_null(_left_hand_socket_path);
+    ERR_FAIL_COND_MSG(
+        !left_hand_socket_node,
+        "Cant find left hand socket node. Check if path is correct");
+    _left_hand_socket = cast_to<Marker3D>(left_hand_socket_node);
+    ERR_FAIL_COND_MSG(!_left_hand_socket,
+                      "Failed casting to Left Hand Socked");
+  }
 
-  Node *right_hand_socket_node = get_node_or_null(_right_hand_socket_path);
-  ERR_FAIL_COND_MSG(
-      !right_hand_socket_node,
-      "Cant find right hand socket node. Check if path is correct");
-  _right_hand_socket = cast_to<Marker3D>(right_hand_socket_node);
-  ERR_FAIL_COND_MSG(!_right_hand_socket, "Failed casting to Right Hand Socked");
+  if (!_right_hand_socket_path.is_empty()) {
+    Node *right_hand_socket_node = get_node_or_null(_right_hand_socket_path);
+    ERR_FAIL_COND_MSG(
+        !right_hand_socket_node,
+        "Cant find right hand socket node. Check if path is correct");
+    _right_hand_socket = cast_to<Marker3D>(right_hand_socket_node);
+    ERR_FAIL_COND_MSG(!_right_hand_socket,
+                      "Failed casting to Right Hand Socked");
+  }
 
   // for late join player to sync items in hands
   apply_current_equipment();
 }
 
-void Player::_physics_process(double) {
+void Player::_physics_process(double delta) {
   if (Engine::get_singleton()->is_editor_hint()) {
     return;
   }
 
+  // Dormant players stand still: nothing to stream around or animate.
+  if (is_dormant()) {
+    return;
+  }
+
+  _terrain_viewer.update(this, static_cast<float>(delta));
+
+  // Remote players on clients: present the interpolated server state, so
+  // the animator below sees smooth velocity instead of packet jitter.
+  if (_server_authoritative && !is_multiplayer_authority() &&
+      !NetUtils::is_server(this)) {
+    update_interpolation(delta);
+  }
+
   if (!_player_animator)
     return;
 
-  const bool anim_on_floor = is_multiplayer_authority() ? is_on_floor() : true;
+  const bool anim_on_floor = is_multiplayer_authority() ? _grounded : true;
   const float blend_max_speed = _sprint_speed;
   const float time_scale_ref_speed =
       (_movement_ref_speed > 0.001f) ? _movement_ref_speed : blend_max_speed;
@@ -191,12 +520,15 @@ void Player::_physics_process(double) {
 // private
 
 void Player::on_right_hand_equipped(Ref<ItemDefinition> item) {
+  wake_dormant();
   if (_right_hand_item) {
     _right_hand_item->queue_free();
     _right_hand_item = nullptr;
   }
   if (!item.is_valid()) {
-    _player_animator->set_right_hand_item_state("", false);
+    if (_player_animator) {
+      _player_animator->set_right_hand_item_state("", false);
+    }
     return;
   }
 
@@ -210,17 +542,22 @@ void Player::on_right_hand_equipped(Ref<ItemDefinition> item) {
       inst->queue_free();
     }
   }
-  _player_animator->set_right_hand_item_state(item->get_equip_state(), true);
+  if (_player_animator) {
+    _player_animator->set_right_hand_item_state(item->get_equip_state(), true);
+  }
 }
 
 void Player::on_left_hand_equipped(Ref<ItemDefinition> item) {
+  wake_dormant();
   if (_left_hand_item) {
     _left_hand_item->queue_free();
     _left_hand_item = nullptr;
   }
 
   if (!item.is_valid()) {
-    _player_animator->set_left_hand_item_state("", false);
+    if (_player_animator) {
+      _player_animator->set_left_hand_item_state("", false);
+    }
     return;
   }
 
@@ -235,7 +572,9 @@ void Player::on_left_hand_equipped(Ref<ItemDefinition> item) {
     }
   }
 
-  _player_animator->set_left_hand_item_state(item->get_equip_state(), true);
+  if (_player_animator) {
+    _player_animator->set_left_hand_item_state(item->get_equip_state(), true);
+  }
 }
 
 void Player::apply_current_equipment() {
@@ -266,6 +605,47 @@ void Player::ensure_local_controller() {
   LocalPlayerController *controller = memnew(LocalPlayerController);
   controller->set_name("LocalPlayerController");
   add_child(controller);
+  _local_controller = controller;
+}
+
+void Player::configure_replication() {
+  // Runs before the synchronizer enters the tree, on every peer.
+  _synchronizer = Object::cast_to<MultiplayerSynchronizer>(
+      get_node_or_null("MultiplayerSynchronizer"));
+  if (!_synchronizer) {
+    return;
+  }
+
+  // The server owns what the synchronizer replicates (equipment, spawn
+  // state). Only server-authored synchronizers gate spawning per peer, which
+  // is what lets interest culling despawn far players on clients.
+  _synchronizer->set_multiplayer_authority(1);
+
+  Ref<SceneReplicationConfig> shared = _synchronizer->get_replication_config();
+  if (shared.is_valid()) {
+    // Transform stays in the spawn state (initial placement) but is no
+    // longer streamed; PlayerReplicator snapshots carry it instead. The
+    // config is a shared sub-resource of player.tscn, so edit a copy.
+    Ref<SceneReplicationConfig> config = shared->duplicate();
+    const NodePath transform_props[] = {NodePath(".:position"),
+                                        NodePath(".:rotation"),
+                                        NodePath(".:velocity")};
+    for (const NodePath &prop : transform_props) {
+      if (config->has_property(prop)) {
+        config->property_set_replication_mode(
+            prop, SceneReplicationConfig::REPLICATION_MODE_NEVER);
+      }
+    }
+    _synchronizer->set_replication_config(config);
+  }
+  _sync_interval = _synchronizer->get_replication_interval();
+
+  if (NetUtils::is_server(this)) {
+    // Hidden from everyone but the owner until PlayerReplicator's interest
+    // pass says otherwise.
+    _synchronizer->set_public_visibility(false);
+    _synchronizer->set_visibility_for(_peer_id, true);
+  }
 }
 
 NodePath Player::get_player_animator_path() const {
@@ -294,6 +674,17 @@ void Player::set_right_hand_socket_path(NodePath p_path) {
 float Player::get_sprint_speed() const { return _sprint_speed; }
 void Player::set_sprint_speed(float p_speed) { _sprint_speed = p_speed; }
 
+float Player::get_terrain_lookahead_time() const {
+  return _terrain_viewer.get_lookahead_time();
+}
+void Player::set_terrain_lookahead_time(float p_seconds) {
+  _terrain_viewer.set_lookahead_time(p_seconds);
+}
+
+Dictionary Player::get_terrain_prefetch_stats() const {
+  return _terrain_viewer.get_stats();
+}
+
 float Player::get_speed() const { return _speed; }
 void Player::set_speed(float p_speed) { _speed = p_speed; }
 
@@ -317,6 +708,30 @@ void Player::_bind_methods() {
                        &Player::trigger_left_item_action);
   ClassDB::bind_method(D_METHOD("trigger_right_item_action", "action"),
                        &Player::trigger_right_item_action);
+  ClassDB::bind_method(D_METHOD("get_pending_input_count"),
+                       &Player::get_pending_input_count);
+  ClassDB::bind_method(D_METHOD("get_last_processed_input_tick"),
+                       &Player::get_last_processed_input_tick);
+  ClassDB::bind_method(D_METHOD("get_interpolation_buffer_depth"),
+                       &Player::get_interpolation_buffer_depth);
+  ClassDB::bind_method(D_METHOD("get_interpolation_delay"),
+                       &Player::get_interpolation_delay);
+  ClassDB::bind_method(D_METHOD("get_interpolation_jitter"),
+                       &Player::get_interpolation_jitter);
+  ClassDB::bind_method(D_METHOD("get_extrapolation_time"),
+                       &Player::get_extrapolation_time);
+  ClassDB::bind_method(D_METHOD("get_interpolation_snap_count"),
+                       &Player::get_interpolation_snap_count);
+  ClassDB::bind_method(D_METHOD("get_skipped_input_count"),
+                       &Player::get_skipped_input_count);
+  ClassDB::bind_method(D_METHOD("get_starved_tick_count"),
+                       &Player::get_starved_tick_count);
+  ClassDB::bind_method(D_METHOD("get_terrain_prefetch_stats"),
+                       &Player::get_terrain_prefetch_stats);
+  ClassDB::bind_method(D_METHOD("is_dormant"), &Player::is_dormant);
+  ClassDB::bind_method(D_METHOD("wake_dormant"), &Player::wake_dormant);
+  ClassDB::bind_method(D_METHOD("get_dormancy_wake_count"),
+                       &Player::get_dormancy_wake_count);
 
   BIND_PROPERTY(Player, Variant::NODE_PATH, "player_animator_path",
                 player_animator_path);
@@ -327,8 +742,13 @@ void Player::_bind_methods() {
                 right_hand_socket_path);
   BIND_PROPERTY(Player, Variant::FLOAT, "sensitivity", sensitivity);
   BIND_PROPERTY(Player, Variant::FLOAT, "sprint_speed", sprint_speed);
+  BIND_PROPERTY(Player, Variant::FLOAT, "terrain_lookahead_time",
+                terrain_lookahead_time);
   BIND_PROPERTY(Player, Variant::FLOAT, "speed", speed);
   BIND_PROPERTY(Player, Variant::FLOAT, "friction", friction);
+  BIND_PROPERTY(Player, Variant::BOOL, "server_authoritative",
+                server_authoritative);
+  BIND_PROPERTY(Player, Variant::INT, "dormancy_ticks", dormancy_ticks);
 }
 
 } // namespace morphic
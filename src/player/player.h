@@ -1,17 +1,29 @@
 #pragma once
 
+#include "net/player_input_buffer.h"
 #include "player_animator.h"
+#include "player_dormancy.h"
 #include "player_equipment.h"
+#include "player_input.h"
+#include "player_interpolation.h"
+#include "player_movement.h"
+#include "player_net_state.h"
 #include "player_terrain_viewer.h"
+#include "player_transform_history.h"
 
 #include <godot_cpp/classes/character_body3d.hpp>
 #include <godot_cpp/classes/marker3d.hpp>
+#include <godot_cpp/classes/multiplayer_synchronizer.hpp>
 #include <godot_cpp/classes/node3d.hpp>
 
+#include <vector>
+
 using namespace godot;
 
 namespace morphic {
 
+class LocalPlayerController;
+
 class Player : public CharacterBody3D {
   GDCLASS(Player, CharacterBody3D)
 
@@ -48,6 +60,75 @@ public:
   void set_sensitivity(float p_sens);
   float get_movement_ref_speed() const;
   void set_movement_ref_speed(float p_speed);
+  float get_terrain_lookahead_time() const;
+  void set_terrain_lookahead_time(float p_seconds);
+  Dictionary get_terrain_prefetch_stats() const;
+  // Floor contact from the last kinematic step (PlayerKinematics).
+  bool is_grounded() const { return _grounded; }
+  void set_grounded(bool p_grounded) { _grounded = p_grounded; }
+
+  bool get_server_authoritative() const;
+  void set_server_authoritative(bool p_enabled);
+
+  // Dormancy (PlayerDormancy): after `dormancy_ticks` idle simulated ticks
+  // the player stops moving, animating and (on the server) streaming its
+  // synchronizer until woken. Whoever simulates the player drives it:
+  // wake_dormant() before a non-idle input, update_dormancy() after.
+  bool is_dormant() const { return _dormancy.is_dormant(); }
+  void wake_dormant();
+  void update_dormancy(bool idle_input);
+  int get_dormancy_ticks() const;
+  void set_dormancy_ticks(int p_ticks);
+  int64_t get_dormancy_wake_count() const;
+
+  // Server-authoritative movement roles (see `server_authoritative`).
+  bool is_server_simulated() const;
+  bool is_locally_predicted() const;
+
+  // server
+  // At most this many inputs run per tick: one, plus one more while
+  // catching up (see k_input_catch_up_fill).
+  static constexpr int k_max_inputs_per_tick = 2;
+
+  void server_simulate(double delta);
+  // Pops this tick's inputs and applies everything but movement (equipment
+  // toggles, primary action, acked tick); ServerPlayerSim moves the body.
+  // Returns the number written to r_inputs.
+  int server_take_inputs(PlayerInputState (&r_inputs)[k_max_inputs_per_tick]);
+  PlayerNetState get_net_state() const;
+  int get_pending_input_count() const;
+  int get_last_processed_input_tick() const;
+  int64_t get_skipped_input_count() const;
+  int64_t get_starved_tick_count() const;
+  // Spawn/sync visibility of this player for one peer (interest culling).
+  void set_replicated_to_peer(int p_peer_id, bool p_visible);
+  // Input packet from this player's owner (routed by PlayerReplicator).
+  void server_receive_input(const PackedByteArray &packet);
+  // Lag compensation: body transform per server tick, and the swing the
+  // last primary press started, resolved by PlayerReplicator.
+  void record_transform_history(uint32_t tick);
+  const PlayerTransformHistory &get_transform_history() const {
+    return _transform_history;
+  }
+  void server_apply_primary(bool pressed, uint32_t view_tick);
+  bool consume_pending_swing(uint32_t &r_view_tick);
+
+  // client
+  void send_input_to_server(const PackedByteArray &packet);
+  void apply_net_state(const PlayerNetState &state);
+  void apply_input_feedback(int fill);
+  // Remote players: buffered and presented through PlayerInterpolation.
+  void push_remote_state(uint32_t server_tick, const PlayerNetState &state);
+  // Server tick this remote player is currently shown at.
+  uint32_t get_presented_tick() const;
+  // Server tick of the remote players we see, sent with primary actions.
+  uint32_t get_client_view_tick() const;
+
+  int get_interpolation_buffer_depth() const;
+  float get_interpolation_delay() const;
+  float get_interpolation_jitter() const;
+  float get_extrapolation_time() const;
+  int64_t get_interpolation_snap_count() const;
 
   void notify_jump();
   void toggle_torch();
@@ -56,7 +137,14 @@ public:
   void trigger_right_item_action(String action);
 
 private:
+  // Above this many queued inputs the server runs two per tick until the
+  // backlog (from a burst after a stall) is worked off.
+  static constexpr int k_input_catch_up_fill = 6;
+  // Synchronizer interval while dormant (equipment resend safety net).
+  static constexpr double k_dormant_sync_interval_s = 2.0;
+
   int _peer_id = 1;
+  bool _server_authoritative = true;
 
   Node3D *_head_node = nullptr;
   PlayerTerrainViewer _terrain_viewer;
@@ -80,6 +168,32 @@ private:
   float _gravity = 9.8;
   float _sensitivity = 0.001;
   float _movement_ref_speed = 0.0f;
+  bool _grounded = false;
+
+  PlayerDormancy _dormancy;
+  double _sync_interval = 0.0;
+
+  LocalPlayerController *_local_controller = nullptr;
+  MultiplayerSynchronizer *_synchronizer = nullptr;
+
+  // server-side simulation of a remote client's player
+  PlayerMovement _server_movement;
+  PlayerInputBuffer _server_inputs;
+  std::vector<PlayerInputState> _received_inputs;
+  uint32_t _last_processed_input_tick = 0;
+  PlayerTransformHistory _transform_history;
+  bool _server_primary_held = false;
+  bool _swing_pending = false;
+  uint32_t _swing_view_tick = 0;
+
+  // client-side presentation of a remote player
+  PlayerInterpolation _interpolation;
+
+  void configure_replication();
+  void on_dormancy_changed(bool p_dormant);
+  void apply_presented_state(const PlayerNetState &state);
+  void update_interpolation(double delta);
+  void server_apply_input_actions(const PlayerInputState &input);
 
   void setup_viewer();
   void ensure_local_controller();
@@ -0,0 +1,41 @@
+#include "player_dormancy.h"
+
+namespace morphic {
+
+bool PlayerDormancy::is_idle_input(const PlayerInputState &input) {
+  return input.move.is_zero_approx() && input.look.is_zero_approx() &&
+         !input.jump && !input.primary_action && !input.secondary_action &&
+         !input.toggle_torch && !input.toggle_picaxe;
+}
+
+bool PlayerDormancy::set_threshold_ticks(int ticks) {
+  _threshold_ticks = ticks < 0 ? 0 : ticks;
+  return _threshold_ticks == 0 && wake();
+}
+
+bool PlayerDormancy::observe(bool idle) {
+  if (!idle) {
+    wake();
+    return false;
+  }
+  if (_dormant || _threshold_ticks == 0) {
+    return false;
+  }
+  if (++_idle_ticks < _threshold_ticks) {
+    return false;
+  }
+  _dormant = true;
+  return true;
+}
+
+bool PlayerDormancy::wake() {
+  _idle_ticks = 0;
+  if (!_dormant) {
+    return false;
+  }
+  _dormant = false;
+  _wakes++;
+  return true;
+}
+
+} // namespace morphic
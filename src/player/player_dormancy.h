@@ -0,0 +1,40 @@
+#pragma once
+
+#include "player_input.h"
+
+#include <cstdint>
+
+namespace morphic {
+
+// Idle tracking for one player. A simulated tick counts as idle when its
+// input does nothing and the player rests on the floor; after
+// `threshold_ticks` idle ticks in a row the player goes dormant, and stays
+// dormant until woken: by input, an equipment change, a nearby terrain edit
+// or another player's contact. A threshold of 0 disables dormancy.
+class PlayerDormancy {
+public:
+  static constexpr int k_default_threshold_ticks = 120;
+
+  // Sprint is left out: holding it while standing changes nothing.
+  static bool is_idle_input(const PlayerInputState &input);
+
+  // True when disabling dormancy woke the player.
+  bool set_threshold_ticks(int ticks);
+  int get_threshold_ticks() const { return _threshold_ticks; }
+
+  // One simulated tick. True when this tick made the player dormant.
+  bool observe(bool idle);
+  // Restarts the idle count. True when the player was dormant.
+  bool wake();
+
+  bool is_dormant() const { return _dormant; }
+  uint64_t get_wake_count() const { return _wakes; }
+
+private:
+  int _threshold_ticks = k_default_threshold_ticks;
+  int _idle_ticks = 0;
+  bool _dormant = false;
+  uint64_t _wakes = 0;
+};
+
+} // namespace morphic
@@ -5,6 +5,33 @@
 #include "godot_cpp/classes/input_event_mouse_motion.hpp"
 
 namespace morphic {
+
+uint8_t pack_input_buttons(const PlayerInputState &state) {
+  uint8_t buttons = 0;
+  if (state.primary_action)
+    buttons |= INPUT_BUTTON_PRIMARY;
+  if (state.secondary_action)
+    buttons |= INPUT_BUTTON_SECONDARY;
+  if (state.jump)
+    buttons |= INPUT_BUTTON_JUMP;
+  if (state.is_sprinting)
+    buttons |= INPUT_BUTTON_SPRINT;
+  if (state.toggle_torch)
+    buttons |= INPUT_BUTTON_TOGGLE_TORCH;
+  if (state.toggle_picaxe)
+    buttons |= INPUT_BUTTON_TOGGLE_PICAXE;
+  return buttons;
+}
+
+void unpack_input_buttons(uint8_t buttons, PlayerInputState &state) {
+  state.primary_action = (buttons & INPUT_BUTTON_PRIMARY) != 0;
+  state.secondary_action = (buttons & INPUT_BUTTON_SECONDARY) != 0;
+  state.jump = (buttons & INPUT_BUTTON_JUMP) != 0;
+  state.is_sprinting = (buttons & INPUT_BUTTON_SPRINT) != 0;
+  state.toggle_torch = (buttons & INPUT_BUTTON_TOGGLE_TORCH) != 0;
+  state.toggle_picaxe = (buttons & INPUT_BUTTON_TOGGLE_PICAXE) != 0;
+}
+
 PlayerInputState PlayerInput::consume() {
   auto state = _state;
   _state = PlayerInputState();
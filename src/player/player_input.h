@@ -3,11 +3,14 @@
 #include "godot_cpp/classes/input_event.hpp"
 #include "godot_cpp/variant/vector2.hpp"
 
+#include <cstdint>
+
 using namespace godot;
 
 namespace morphic {
 
 struct PlayerInputState {
+  uint32_t tick = 0;
   Vector2 move;
   Vector2 look;
   bool primary_action = false;
@@ -16,8 +19,25 @@ struct PlayerInputState {
   bool is_sprinting = false;
   bool toggle_torch = false;
   bool toggle_picaxe = false;
+  // Server tick of the world the client was looking at (remote players are
+  // presented in the past). Only sent with primary_action, for the server
+  // to rewind hit checks to; see PlayerRewind.
+  uint32_t view_tick = 0;
+};
+
+// Action booleans packed into one bitfield for the wire.
+enum PlayerInputButton : uint8_t {
+  INPUT_BUTTON_PRIMARY = 1 << 0,
+  INPUT_BUTTON_SECONDARY = 1 << 1,
+  INPUT_BUTTON_JUMP = 1 << 2,
+  INPUT_BUTTON_SPRINT = 1 << 3,
+  INPUT_BUTTON_TOGGLE_TORCH = 1 << 4,
+  INPUT_BUTTON_TOGGLE_PICAXE = 1 << 5,
 };
 
+uint8_t pack_input_buttons(const PlayerInputState &state);
+void unpack_input_buttons(uint8_t buttons, PlayerInputState &state);
+
 class PlayerInput {
 public:
   void handle_input(const Ref<InputEvent> &event);
@@ -0,0 +1,155 @@
+#include "player_interpolation.h"
+
+#include <godot_cpp/core/math.hpp>
+
+#include <algorithm>
+
+namespace morphic {
+
+namespace {
+
+// Cubic Hermite between p0 and p1 with endpoint tangents m0/m1 already
+// scaled to the segment length.
+Vector3 hermite(const Vector3 &p0, const Vector3 &m0, const Vector3 &p1,
+                const Vector3 &m1, float t) {
+  const float t2 = t * t;
+  const float t3 = t2 * t;
+  return p0 * (2.0f * t3 - 3.0f * t2 + 1.0f) + m0 * (t3 - 2.0f * t2 + t) +
+         p1 * (-2.0f * t3 + 3.0f * t2) + m1 * (t3 - t2);
+}
+
+Vector3 hermite_derivative(const Vector3 &p0, const Vector3 &m0,
+                           const Vector3 &p1, const Vector3 &m1, float t) {
+  const float t2 = t * t;
+  return p0 * (6.0f * t2 - 6.0f * t) + m0 * (3.0f * t2 - 4.0f * t + 1.0f) +
+         p1 * (-6.0f * t2 + 6.0f * t) + m1 * (3.0f * t2 - 2.0f * t);
+}
+
+float lerp_angle(float from, float to, float t) {
+  return from + Math::wrapf(to - from, -Math_PI, Math_PI) * t;
+}
+
+} // namespace
+
+const PlayerInterpolation::Sample &PlayerInterpolation::at(int index) const {
+  return _samples[(_head + index) % k_capacity];
+}
+
+double PlayerInterpolation::target_delay() const {
+  return Math::clamp(_interval + k_jitter_margin * _jitter, k_min_delay,
+                     k_max_delay);
+}
+
+void PlayerInterpolation::push(double server_time, double local_time,
+                               const PlayerNetState &state) {
+  if (_count > 0 && server_time <= at(_count - 1).time) {
+    return;
+  }
+
+  // Jitter as in RFC 3550: how much the spacing between arrivals differs
+  // from the spacing between the server times they carry.
+  const double offset = local_time - server_time;
+  if (!_has_clock) {
+    _has_clock = true;
+    _clock_offset = offset;
+  } else {
+    const double server_step = server_time - _last_arrival_server;
+    const double transit_change =
+        (local_time - _last_arrival_local) - server_step;
+    _jitter += (Math::abs(transit_change) - _jitter) / 16.0;
+    _interval = _interval > 0.0
+                    ? _interval + (server_step - _interval) / 16.0
+                    : server_step;
+    // Follow the fastest arrivals quickly, slower ones slowly, so the
+    // offset tracks the network minimum instead of the queueing average.
+    const double blend = offset < _clock_offset ? 0.25 : 0.01;
+    _clock_offset += (offset - _clock_offset) * blend;
+  }
+  _last_arrival_local = local_time;
+  _last_arrival_server = server_time;
+
+  if (_count > 0) {
+    const Sample &newest = at(_count - 1);
+    const Vector3 expected =
+        newest.state.position +
+        newest.state.velocity * static_cast<float>(server_time - newest.time);
+    if (state.position.distance_to(expected) > k_snap_distance) {
+      // Teleport (respawn, long gap): jump there instead of sliding.
+      _head = 0;
+      _count = 0;
+      _snaps++;
+    }
+  }
+
+  if (_count == k_capacity) {
+    _head = (_head + 1) % k_capacity;
+    _count--;
+  }
+  Sample &slot = _samples[(_head + _count) % k_capacity];
+  slot.time = server_time;
+  slot.state = state;
+  _count++;
+}
+
+bool PlayerInterpolation::sample(double local_time, double delta,
+                                 PlayerNetState &r_state) {
+  if (_count == 0) {
+    return false;
+  }
+
+  const double target = target_delay();
+  const double max_step = k_delay_slew * delta;
+  _delay += Math::clamp(target - _delay, -max_step, max_step);
+
+  const double render_time = local_time - _clock_offset - _delay;
+  _render_time = render_time;
+
+  // Drop samples the render time has passed, keeping one to interpolate from.
+  while (_count > 1 && at(1).time <= render_time) {
+    _head = (_head + 1) % k_capacity;
+    _count--;
+  }
+  _buffer_depth = _count - 1;
+
+  const Sample &from = at(0);
+  if (_count == 1 || render_time <= from.time) {
+    r_state = from.state;
+    if (render_time > from.time) {
+      // Packet gap: keep moving along the last velocity for a short while,
+      // then hold rather than run off.
+      const double ahead =
+          std::min(render_time - from.time, k_max_extrapolation);
+      r_state.position =
+          from.state.position + from.state.velocity * static_cast<float>(ahead);
+      _extrapolation_time += delta;
+    }
+  } else {
+    const Sample &to = at(1);
+    const double span = to.time - from.time;
+    const float t = static_cast<float>((render_time - from.time) / span);
+    const Vector3 m0 = from.state.velocity * static_cast<float>(span);
+    const Vector3 m1 = to.state.velocity * static_cast<float>(span);
+    r_state.position =
+        hermite(from.state.position, m0, to.state.position, m1, t);
+    r_state.velocity =
+        hermite_derivative(from.state.position, m0, to.state.position, m1,
+                           t) /
+        static_cast<float>(span);
+    r_state.yaw = lerp_angle(from.state.yaw, to.state.yaw, t);
+    r_state.pitch = Math::lerp(from.state.pitch, to.state.pitch, t);
+    r_state.tick = to.state.tick;
+  }
+  return true;
+}
+
+void PlayerInterpolation::clear() {
+  _head = 0;
+  _count = 0;
+  _has_clock = false;
+  _delay = k_initial_delay;
+  _jitter = 0.0;
+  _interval = 0.0;
+  _buffer_depth = 0;
+}
+
+} // namespace morphic
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "player_net_state.h"
+
+#include <array>
+#include <cstdint>
+
+namespace morphic {
+
+// Snapshot interpolation for a remote player on a client. Server states are
+// buffered by server time and presented `delay` seconds in the past, where
+// the delay follows the measured arrival jitter. Between two samples the
+// position is a cubic Hermite curve through the replicated velocities; past
+// the newest sample it extrapolates for a bounded time, then holds.
+class PlayerInterpolation {
+public:
+  struct Sample {
+    double time = 0.0;
+    PlayerNetState state;
+  };
+
+  // `server_time` is the server tick converted to seconds, `local_time`
+  // the receive time on our clock.
+  void push(double server_time, double local_time,
+            const PlayerNetState &state);
+  // False until the first sample arrived.
+  bool sample(double local_time, double delta, PlayerNetState &r_state);
+  void clear();
+
+  // Samples newer than the presented time.
+  int get_buffer_depth() const { return _buffer_depth; }
+  double get_delay() const { return _delay; }
+  double get_jitter() const { return _jitter; }
+  // Total seconds spent past the newest sample.
+  double get_extrapolation_time() const { return _extrapolation_time; }
+  uint64_t get_snap_count() const { return _snaps; }
+  // Server time (seconds) shown by the latest sample().
+  double get_render_time() const { return _render_time; }
+
+private:
+  static constexpr int k_capacity = 32;
+  static constexpr double k_initial_delay = 0.1;
+  static constexpr double k_min_delay = 0.05;
+  static constexpr double k_max_delay = 0.3;
+  // Jitter multiple kept as headroom on top of one snapshot interval.
+  static constexpr double k_jitter_margin = 4.0;
+  // Fraction of real time the delay may drift per second while adapting.
+  static constexpr double k_delay_slew = 0.1;
+  static constexpr double k_max_extrapolation = 0.2;
+  // A new sample this far off the newest one's extrapolation is a teleport.
+  static constexpr float k_snap_distance = 4.0f;
+
+  std::array<Sample, k_capacity> _samples;
+  int _head = 0;
+  int _count = 0;
+
+  bool _has_clock = false;
+  double _clock_offset = 0.0; // local_time - server_time, smoothed
+  double _last_arrival_local = 0.0;
+  double _last_arrival_server = 0.0;
+  double _interval = 0.0;
+
+  double _delay = k_initial_delay;
+  double _jitter = 0.0;
+  int _buffer_depth = 0;
+  double _extrapolation_time = 0.0;
+  double _render_time = 0.0;
+  uint64_t _snaps = 0;
+
+  const Sample &at(int index) const;
+  double target_delay() const;
+};
+
+} // namespace morphic
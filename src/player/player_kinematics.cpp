@@ -0,0 +1,127 @@
+#include "player_kinematics.h"
+
+#include "player.h"
+
+#include <godot_cpp/classes/physics_server3d.hpp>
+#include <godot_cpp/core/math.hpp>
+
+namespace morphic {
+
+namespace {
+const Vector3 k_up(0, 1, 0);
+// Slide iterations per step; CharacterBody3D's max_slides default is 6,
+// but a capsule on voxel terrain settles in far fewer.
+constexpr int k_max_slides = 4;
+constexpr int k_max_collisions = 4;
+// CharacterBody3D defaults: 45 degree floor angle, 1 mm safe margin.
+constexpr float k_floor_min_dot = 0.70710678f;
+constexpr float k_safe_margin = 0.001f;
+constexpr float k_floor_snap_length = 0.1f;
+} // namespace
+
+PlayerMotionParams PlayerMotionParams::from(const Player &player) {
+  PlayerMotionParams params;
+  params.speed = player.get_speed();
+  params.sprint_speed = player.get_sprint_speed();
+  params.friction = player.get_friction();
+  params.jump_velocity = static_cast<float>(player.get_jump_velocity());
+  params.gravity = static_cast<float>(player.get_gravity());
+  return params;
+}
+
+PlayerKinematics::PlayerKinematics() {
+  _params.instantiate();
+  _result.instantiate();
+  _params->set_margin(k_safe_margin);
+  _params->set_max_collisions(k_max_collisions);
+  // Report the floor we rest on even when the motion itself is unblocked.
+  _params->set_recovery_as_collision_enabled(true);
+}
+
+Vector3 PlayerKinematics::integrate_velocity(const Vector3 &velocity,
+                                             bool on_floor, float yaw,
+                                             const PlayerInputState &input,
+                                             const PlayerMotionParams &params,
+                                             double delta, bool &r_jumped) {
+  Vector3 result = velocity;
+  r_jumped = false;
+
+  if (!on_floor) {
+    result.y -= params.gravity * delta;
+  }
+
+  if (input.jump && on_floor) {
+    result.y = params.jump_velocity;
+    r_jumped = true;
+  }
+
+  const Vector3 direction = Basis(k_up, yaw)
+                                .xform(Vector3(input.move.x, 0, input.move.y))
+                                .normalized();
+  const float speed = input.is_sprinting ? params.sprint_speed : params.speed;
+
+  if (direction != Vector3(0, 0, 0)) {
+    result.x = direction.x * speed;
+    result.z = direction.z * speed;
+  } else {
+    const real_t step = (real_t)(speed * params.friction * delta);
+    result.x = Math::move_toward(result.x, 0, step);
+    result.z = Math::move_toward(result.z, 0, step);
+  }
+  return result;
+}
+
+void PlayerKinematics::slide(const RID &body, Transform3D &r_transform,
+                             Vector3 &r_velocity, bool &r_on_floor,
+                             double delta) {
+  const bool was_on_floor = r_on_floor;
+  r_on_floor = false;
+  _contacts.clear();
+
+  Vector3 motion = r_velocity * delta;
+  for (int i = 0; i < k_max_slides && !motion.is_zero_approx(); i++) {
+    if (!test(body, r_transform, motion)) {
+      r_transform.origin += motion;
+      break;
+    }
+    r_transform.origin += _result->get_travel();
+    if (collect_contacts()) {
+      r_on_floor = true;
+    }
+    const Vector3 normal = _result->get_collision_normal(0);
+    motion = _result->get_remainder().slide(normal);
+    if (r_velocity.dot(normal) < 0.0f) {
+      r_velocity = r_velocity.slide(normal);
+    }
+  }
+
+  // Stay glued to the ground over small steps down instead of launching off
+  // every voxel edge; never while moving up (a jump).
+  if (!r_on_floor && was_on_floor && r_velocity.y <= 0.0f &&
+      test(body, r_transform, Vector3(0, -k_floor_snap_length, 0)) &&
+      collect_contacts()) {
+    r_transform.origin += _result->get_travel();
+    r_on_floor = true;
+  }
+}
+
+bool PlayerKinematics::test(const RID &body, const Transform3D &from,
+                            const Vector3 &motion) {
+  _params->set_from(from);
+  _params->set_motion(motion);
+  return PhysicsServer3D::get_singleton()->body_test_motion(body, _params,
+                                                            _result);
+}
+
+bool PlayerKinematics::collect_contacts() {
+  bool floor = false;
+  for (int i = 0; i < _result->get_collision_count(); i++) {
+    _contacts.push_back(_result->get_collider_id(i));
+    if (_result->get_collision_normal(i).dot(k_up) >= k_floor_min_dot) {
+      floor = true;
+    }
+  }
+  return floor;
+}
+
+} // namespace morphic
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "player_input.h"
+
+#include <godot_cpp/classes/physics_test_motion_parameters3d.hpp>
+#include <godot_cpp/classes/physics_test_motion_result3d.hpp>
+#include <godot_cpp/variant/rid.hpp>
+#include <godot_cpp/variant/transform3d.hpp>
+#include <godot_cpp/variant/vector3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace godot;
+
+namespace morphic {
+
+class Player;
+
+struct PlayerMotionParams {
+  float speed = 0.0f;
+  float sprint_speed = 0.0f;
+  float friction = 0.0f;
+  float jump_velocity = 0.0f;
+  float gravity = 0.0f;
+
+  static PlayerMotionParams from(const Player &player);
+};
+
+// The player's kinematic step, written against PhysicsServer3D instead of
+// CharacterBody3D::move_and_slide() so it can run on plain body RIDs. Both
+// the node path (PlayerMovement: local prediction and replay) and the
+// batched server simulation (ServerPlayerSim) step through here, so the
+// server and client predictions never disagree on the motion model.
+class PlayerKinematics {
+public:
+  PlayerKinematics();
+
+  // Gravity, jump and walk/friction for one input. r_jumped is set when the
+  // input started a jump.
+  static Vector3 integrate_velocity(const Vector3 &velocity, bool on_floor,
+                                    float yaw, const PlayerInputState &input,
+                                    const PlayerMotionParams &params,
+                                    double delta, bool &r_jumped);
+
+  // Moves `body` from r_transform by r_velocity * delta, sliding along what
+  // it hits, then snaps it back onto the floor it was standing on. Only
+  // queries the physics server; the caller commits the new transform.
+  void slide(const RID &body, Transform3D &r_transform, Vector3 &r_velocity,
+             bool &r_on_floor, double delta);
+  // Instance ids of what the last slide() touched, floor included.
+  const std::vector<uint64_t> &get_contacts() const { return _contacts; }
+
+private:
+  Ref<PhysicsTestMotionParameters3D> _params;
+  Ref<PhysicsTestMotionResult3D> _result;
+  std::vector<uint64_t> _contacts;
+
+  bool test(const RID &body, const Transform3D &from, const Vector3 &motion);
+  // Records the result's contacts; true when one of them is floor.
+  bool collect_contacts();
+};
+
+} // namespace morphic
@@ -8,38 +8,53 @@
 namespace morphic {
 
 void PlayerMovement::tick(Player &player, const PlayerInputState &input,
-                          double delta) {
-  Vector3 velocity = player.get_velocity();
+                          double delta, bool p_replay) {
+  const PlayerMotionParams params = PlayerMotionParams::from(player);
+  bool on_floor = player.is_grounded();
+
+  bool jumped = false;
+  Vector3 velocity = PlayerKinematics::integrate_velocity(
+      player.get_velocity(), on_floor, player.get_rotation().y, input, params,
+      delta, jumped);
+  if (jumped && !p_replay) {
+    player.notify_jump();
+  }
+  player.set_movement_ref_speed(input.is_sprinting ? params.sprint_speed
+                                                   : params.speed);
 
-  if (!player.is_on_floor()) {
-    velocity.y -= player.get_gravity() * delta;
+  Transform3D transform = player.get_global_transform();
+  _kinematics.slide(player.get_rid(), transform, velocity, on_floor, delta);
+  player.set_global_transform(transform);
+  player.set_velocity(velocity);
+  player.set_grounded(on_floor);
+
+  // Bumping into a dormant player wakes it.
+  for (uint64_t id : _kinematics.get_contacts()) {
+    Player *other = Object::cast_to<Player>(ObjectDB::get_instance(id));
+    if (other && other->is_dormant()) {
+      other->wake_dormant();
+    }
   }
+}
 
-  if (input.jump && player.is_on_floor()) {
-    velocity.y = player.get_jump_velocity();
-    player.notify_jump();
+void PlayerMovement::apply_yaw(Player &player, const PlayerInputState &input) {
+  if (input.look.x == 0.0f) {
+    return;
   }
+  player.rotate_y(-input.look.x * player.get_sensitivity());
+}
 
-  Vector3 direction = player.get_transform()
-                          .basis.xform(Vector3(input.move.x, 0, input.move.y))
-                          .normalized();
-  const float speed =
-      input.is_sprinting ? player.get_sprint_speed() : player.get_speed();
-  player.set_movement_ref_speed(speed);
-
-  if (direction != Vector3(0, 0, 0)) {
-    velocity.x = direction.x * speed;
-    velocity.z = direction.z * speed;
-  } else {
-    const float friction = player.get_friction();
-    velocity.x =
-        Math::move_toward(velocity.x, 0, (real_t)(speed * friction * delta));
-    velocity.z =
-        Math::move_toward(velocity.z, 0, (real_t)(speed * friction * delta));
+void PlayerMovement::apply_pitch(Player &player,
+                                 const PlayerInputState &input) {
+  Node3D *head = player.get_head_node();
+  if (!head || input.look.y == 0.0f) {
+    return;
   }
+  head->rotate_x(-input.look.y * player.get_sensitivity());
 
-  player.set_velocity(velocity);
-  player.move_and_slide();
+  Vector3 rot = head->get_rotation();
+  rot.x = Math::clamp(rot.x, Math::deg_to_rad(-89.0f), Math::deg_to_rad(89.0f));
+  head->set_rotation(rot);
 }
 
 } // namespace morphic
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "player_kinematics.h"
+
 namespace morphic {
 
 struct PlayerInputState;
@@ -7,7 +9,20 @@ class Player;
 
 class PlayerMovement {
 public:
-  void tick(Player &player, const PlayerInputState &input, double delta);
+  // p_replay is set while re-simulating unacknowledged inputs after a server
+  // correction; one-shot side effects (animations) are skipped then.
+  void tick(Player &player, const PlayerInputState &input, double delta,
+            bool p_replay = false);
+
+  // Body yaw from look input. Same math as PlayerCamera::tick so server and
+  // replayed simulation end on the same heading as the local camera.
+  static void apply_yaw(Player &player, const PlayerInputState &input);
+  // Head pitch on the server, so snapshots and server-side queries see
+  // where the player is looking.
+  static void apply_pitch(Player &player, const PlayerInputState &input);
+
+private:
+  PlayerKinematics _kinematics;
 };
 
 } // namespace morphic
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <godot_cpp/variant/vector3.hpp>
+
+#include <cstdint>
+
+using namespace godot;
+
+namespace morphic {
+
+// Authoritative movement state of one player as produced by the server.
+// `tick` is the last client input tick the server simulated for this player
+// (0 when none has been processed yet).
+struct PlayerNetState {
+  uint32_t tick = 0;
+  Vector3 position;
+  Vector3 velocity;
+  float yaw = 0.0f;
+  // Head pitch; remote presentation only, never reconciled.
+  float pitch = 0.0f;
+};
+
+} // namespace morphic
@@ -0,0 +1,101 @@
+#include "player_prediction.h"
+
+#include "player.h"
+#include "player_movement.h"
+
+#include <godot_cpp/core/math.hpp>
+
+namespace morphic {
+
+void PlayerPrediction::record(const PlayerInputState &input,
+                              const Player &player) {
+  PredictedFrame frame;
+  frame.input = input;
+  frame.position = player.get_position();
+  frame.velocity = player.get_velocity();
+  frame.yaw = player.get_rotation().y;
+  _pending.push_back(frame);
+
+  // Server stopped acking (stall or lost link); keep memory bounded.
+  while (_pending.size() > k_max_pending) {
+    _pending.pop_front();
+  }
+}
+
+void PlayerPrediction::collect_unacked_inputs(
+    int max_count, std::vector<PlayerInputState> &r_inputs) const {
+  r_inputs.clear();
+  for (auto it = _pending.rbegin();
+       it != _pending.rend() && static_cast<int>(r_inputs.size()) < max_count;
+       ++it) {
+    r_inputs.push_back(it->input);
+  }
+}
+
+void PlayerPrediction::reconcile(Player &player, PlayerMovement &movement,
+                                 const PlayerNetState &server_state,
+                                 double delta) {
+  // Repeated or old acks (the server starved of input keeps acking the
+  // same tick) carry nothing new; 0 means nothing was acked yet.
+  if (server_state.tick <= _last_reconciled_tick) {
+    return;
+  }
+  _last_reconciled_tick = server_state.tick;
+
+  bool popped = false;
+  while (!_pending.empty() && _pending.front().input.tick < server_state.tick) {
+    _pending.pop_front();
+    popped = true;
+  }
+
+  const bool has_frame =
+      !_pending.empty() && _pending.front().input.tick == server_state.tick;
+  if (!has_frame && !popped) {
+    // No prediction recorded up to the acked tick; nothing to check.
+    return;
+  }
+  if (has_frame) {
+    const PredictedFrame &frame = _pending.front();
+    const float yaw_error = Math::abs(
+        Math::wrapf(frame.yaw - server_state.yaw, -Math_PI, Math_PI));
+    const bool matches =
+        frame.position.distance_to(server_state.position) <=
+            k_position_tolerance &&
+        yaw_error <= k_yaw_tolerance;
+    _pending.pop_front();
+    if (matches) {
+      return;
+    }
+  }
+
+  ++_corrections;
+
+  Vector3 rotation = player.get_rotation();
+  rotation.y = server_state.yaw;
+  player.set_rotation(rotation);
+  player.set_position(server_state.position);
+  player.set_velocity(server_state.velocity);
+
+  for (PredictedFrame &frame : _pending) {
+    movement.tick(player, frame.input, delta, true);
+    PlayerMovement::apply_yaw(player, frame.input);
+    frame.position = player.get_position();
+    frame.velocity = player.get_velocity();
+    frame.yaw = player.get_rotation().y;
+  }
+}
+
+void PlayerPrediction::clear() {
+  _pending.clear();
+  _last_reconciled_tick = 0;
+}
+
+int PlayerPrediction::get_pending_count() const {
+  return static_cast<int>(_pending.size());
+}
+
+uint64_t PlayerPrediction::get_correction_count() const {
+  return _corrections;
+}
+
+} // namespace morphic
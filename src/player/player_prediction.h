@@ -0,0 +1,50 @@
+#pragma once
+
+#include "player_input.h"
+#include "player_net_state.h"
+
+#include <deque>
+#include <vector>
+
+namespace morphic {
+
+class Player;
+class PlayerMovement;
+
+// Client-side prediction history for the locally controlled player.
+// Every simulated tick is recorded together with the state it produced; when
+// the server acknowledges a tick the prediction is checked against it and,
+// on mismatch, the player is reset and all newer inputs are replayed.
+class PlayerPrediction {
+public:
+  void record(const PlayerInputState &input, const Player &player);
+  void reconcile(Player &player, PlayerMovement &movement,
+                 const PlayerNetState &server_state, double delta);
+  void clear();
+  // Newest first, at most `max_count` of the inputs the server has not
+  // acknowledged yet.
+  void collect_unacked_inputs(int max_count,
+                              std::vector<PlayerInputState> &r_inputs) const;
+
+  int get_pending_count() const;
+  uint64_t get_correction_count() const;
+
+private:
+  struct PredictedFrame {
+    PlayerInputState input;
+    Vector3 position;
+    Vector3 velocity;
+    float yaw = 0.0f;
+  };
+
+  static constexpr size_t k_max_pending = 128;
+  static constexpr float k_position_tolerance = 0.01f;
+  static constexpr float k_yaw_tolerance = 0.001f;
+
+  std::deque<PredictedFrame> _pending;
+  uint64_t _corrections = 0;
+  // Newest server tick reconciled against; 0 = none yet.
+  uint32_t _last_reconciled_tick = 0;
+};
+
+} // namespace morphic
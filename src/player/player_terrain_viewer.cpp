@@ -1,8 +1,11 @@
 #include "player_terrain_viewer.h"
-#include "godot_cpp/classes/voxel_viewer.hpp"
 #include "player.h"
 #include "utils/debug_utils.h"
 #include "utils/network_utils.h"
+#include "world/world.h"
+
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/core/math.hpp>
 
 using namespace godot;
 
@@ -20,10 +23,20 @@ void PlayerTerrainViewer::setup_viewer(Node *p_player_node) {
     return;
   }
 
-  Node *existing = player->get_node_or_null("TerrrainViewer");
-  if (existing) {
-    existing->queue_free();
+  // Detached right away so the new viewers get these exact names (lookups
+  // by name, e.g. PlayerSpawner's linger, would find the dying node).
+  for (const char *name : {"TerrainViewer", "TerrainCollisionViewer"}) {
+    Node *existing = player->get_node_or_null(name);
+    if (existing) {
+      player->remove_child(existing);
+      existing->queue_free();
+    }
+  }
+  if (_lookahead) {
+    _lookahead->queue_free();
+    _lookahead = nullptr;
   }
+  _enabled = false;
 
   Ref<MultiplayerAPI> mp = NetUtils::get_mp(player);
   const bool has_mp = mp.is_valid() && mp->has_multiplayer_peer();
@@ -42,14 +55,159 @@ void PlayerTerrainViewer::setup_viewer(Node *p_player_node) {
   player->add_child(viewer);
 
   if (is_server_inst) {
-    viewer->set_network_peer_id(player->get_peer_id());
-    viewer->set_requires_data_block_notifications(true);
-    viewer->set_requires_visuals(is_local_player); // tylko lokalny gracz
-    viewer->set_requires_collisions(true);
+    // Clients generate their own terrain; the server viewer only keeps the
+    // area loaded for collisions and edits (see World / TerrainEditLog).
+    // A dedicated server renders nothing, whoever the viewer belongs to.
+    NetworkManager *net_manager = NetUtils::get_net_manager(player);
+    const bool dedicated = net_manager && net_manager->is_dedicated();
+    _requires_visuals = is_local_player && !dedicated; // tylko lokalny gracz
+    _requires_collisions = true;
   } else {
     const bool local = player->is_multiplayer_authority();
-    viewer->set_requires_visuals(local);
-    viewer->set_requires_collisions(local);
+    _requires_visuals = local;
+    _requires_collisions = local;
+  }
+  viewer->set_requires_visuals(_requires_visuals);
+  viewer->set_requires_collisions(_requires_collisions);
+  _enabled = true;
+
+  // Radii agreed in the handshake; 0 (host player, offline) keeps the
+  // terrain's defaults.
+  NetworkManager *net = NetUtils::get_net_manager(player);
+  const int peer_id = player->get_peer_id();
+  const int view = net ? net->get_peer_view_distance(peer_id) : 0;
+  const int collision = net ? net->get_peer_collision_distance(peer_id) : 0;
+  _view_distance = view;
+  if (view <= 0) {
+    return;
+  }
+  viewer->set_view_distance(view);
+  if (!_requires_collisions || collision >= view) {
+    return;
+  }
+  // Collisions only within the smaller radius, on a viewer of their own.
+  viewer->set_requires_collisions(false);
+  if (collision > 0) {
+    VoxelViewer *collision_viewer = memnew(VoxelViewer);
+    collision_viewer->set_name("TerrainCollisionViewer");
+    collision_viewer->set_view_distance(collision);
+    collision_viewer->set_requires_visuals(false);
+    collision_viewer->set_requires_collisions(true);
+    player->add_child(collision_viewer);
+  }
+}
+
+void PlayerTerrainViewer::update(Player *player, float delta) {
+  if (!_enabled || !player) {
+    return;
   }
+  update_lookahead(player, delta);
+  track_arrival(player);
+}
+
+void PlayerTerrainViewer::update_lookahead(Player *player, float delta) {
+  const Vector3 velocity = player->get_velocity();
+  const float speed = velocity.length();
+  const bool fast = _lookahead_time > 0.0f &&
+                    speed > player->get_speed() * k_lookahead_speed_factor;
+
+  if (!fast) {
+    if (_lookahead) {
+      _lookahead_left -= delta;
+      if (_lookahead_left <= 0.0f) {
+        _lookahead->queue_free();
+        _lookahead = nullptr;
+      }
+    }
+    return;
+  }
+
+  _lookahead_left = k_lookahead_linger_s;
+  if (!_lookahead) {
+    _lookahead = memnew(VoxelViewer);
+    _lookahead->set_name("TerrainLookahead");
+    _lookahead->set_as_top_level(true);
+    _lookahead->set_view_distance(
+        _view_distance > 0
+            ? Math::min(k_lookahead_view_distance, _view_distance)
+            : k_lookahead_view_distance);
+    _lookahead->set_requires_visuals(_requires_visuals);
+    _lookahead->set_requires_collisions(_requires_collisions);
+    player->add_child(_lookahead);
+  }
+
+  Vector3 direction = velocity / speed;
+  Node3D *head = player->get_head_node();
+  if (head) {
+    const Vector3 forward = -head->get_global_transform().basis.get_column(2);
+    direction = direction * (1.0f - k_view_weight) + forward * k_view_weight;
+    if (direction.length_squared() > CMP_EPSILON) {
+      direction.normalize();
+    }
+  }
+  _lookahead->set_global_position(player->get_global_position() +
+                                  direction * speed * _lookahead_time);
+}
+
+void PlayerTerrainViewer::track_arrival(Player *player) {
+  if (!_terrain && !find_terrain(player)) {
+    return;
+  }
+  const int block_size = _terrain->get_data_block_size();
+  const Vector3 local = _terrain->to_local(player->get_global_position());
+  const Vector3i block(Math::floor(local.x / block_size),
+                       Math::floor(local.y / block_size),
+                       Math::floor(local.z / block_size));
+  const AABB area(Vector3(block * block_size),
+                  Vector3(block_size, block_size, block_size));
+  const uint64_t now = Time::get_singleton()->get_ticks_usec();
+
+  if (!_has_block || block != _block) {
+    _has_block = true;
+    _block = block;
+    _blocks_entered++;
+    _waiting = !_vt->is_area_editable(area);
+    if (_waiting) {
+      _entered_usec = now;
+    } else {
+      _blocks_ready++;
+    }
+    return;
+  }
+
+  if (_waiting && _vt->is_area_editable(area)) {
+    _waiting = false;
+    _last_wait_ms = static_cast<float>(now - _entered_usec) / 1000.0f;
+    _max_wait_ms = Math::max(_max_wait_ms, _last_wait_ms);
+    _total_wait_ms += _last_wait_ms;
+    _stalls++;
+  }
+}
+
+bool PlayerTerrainViewer::find_terrain(Player *player) {
+  for (Node *node = player->get_parent(); node; node = node->get_parent()) {
+    World *world = Object::cast_to<World>(node);
+    if (world && world->get_terrain()) {
+      _terrain = world->get_terrain();
+      _vt = _terrain->get_voxel_tool();
+      return _vt.is_valid();
+    }
+  }
+  return false;
+}
+
+Dictionary PlayerTerrainViewer::get_stats() const {
+  Dictionary stats;
+  stats["lookahead_active"] = is_lookahead_active();
+  stats["blocks_entered"] = _blocks_entered;
+  // Entered blocks that were already loaded.
+  stats["blocks_ready"] = _blocks_ready;
+  stats["stalls"] = _stalls;
+  stats["waiting"] = _waiting;
+  stats["last_time_to_first_block_ms"] = _last_wait_ms;
+  stats["max_time_to_first_block_ms"] = _max_wait_ms;
+  stats["avg_time_to_first_block_ms"] =
+      _stalls > 0 ? _total_wait_ms / _stalls : 0.0;
+  return stats;
 }
 } // namespace morphic
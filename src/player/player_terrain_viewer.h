@@ -1,13 +1,74 @@
 #pragma once
 #include "godot_cpp/classes/node.hpp"
+#include "godot_cpp/classes/voxel_terrain.hpp"
+#include "godot_cpp/classes/voxel_tool.hpp"
+#include "godot_cpp/classes/voxel_viewer.hpp"
+#include "godot_cpp/variant/dictionary.hpp"
+
+#include <cstdint>
 
 using namespace godot;
 
 namespace morphic {
 
+class Player;
+
+// Terrain loading around a player. Besides the VoxelViewer on the player,
+// fast movers get a short-lived lookahead viewer placed where they will be
+// in `lookahead_time` seconds, along their velocity bent towards where the
+// Head looks. godot_voxel orders block requests by distance to the
+// nearest viewer, so that pulls the blocks ahead of the player forward in
+// the queue.
+//
+// Also measures time-to-first-block: on entering a data block that is not
+// loaded yet, how long until it is.
 class PlayerTerrainViewer {
 public:
   void setup_viewer(Node *player);
+  // Every physics frame.
+  void update(Player *player, float delta);
+
+  float get_lookahead_time() const { return _lookahead_time; }
+  void set_lookahead_time(float seconds) { _lookahead_time = seconds; }
+  bool is_lookahead_active() const { return _lookahead != nullptr; }
+  Dictionary get_stats() const;
+
+private:
+  // Lookahead only above walking speed times this.
+  static constexpr float k_lookahead_speed_factor = 1.2f;
+  // Share of the view direction in the lookahead direction.
+  static constexpr float k_view_weight = 0.3f;
+  static constexpr int k_lookahead_view_distance = 48;
+  // Kept this long after the player slowed down.
+  static constexpr float k_lookahead_linger_s = 1.0f;
+
+  bool _enabled = false;
+  bool _requires_visuals = false;
+  bool _requires_collisions = false;
+  // Negotiated view distance, 0 = terrain default.
+  int _view_distance = 0;
+  float _lookahead_time = 1.5f;
+  VoxelViewer *_lookahead = nullptr;
+  float _lookahead_left = 0.0f;
+
+  VoxelTerrain *_terrain = nullptr;
+  Ref<VoxelTool> _vt;
+
+  Vector3i _block;
+  bool _has_block = false;
+  bool _waiting = false;
+  uint64_t _entered_usec = 0;
+
+  int64_t _blocks_entered = 0;
+  int64_t _blocks_ready = 0;
+  int64_t _stalls = 0;
+  float _last_wait_ms = 0.0f;
+  float _max_wait_ms = 0.0f;
+  double _total_wait_ms = 0.0;
+
+  void update_lookahead(Player *player, float delta);
+  void track_arrival(Player *player);
+  bool find_terrain(Player *player);
 };
 
 } // namespace morphic
@@ -0,0 +1,31 @@
+#include "player_transform_history.h"
+
+namespace morphic {
+
+void PlayerTransformHistory::record(uint32_t tick,
+                                    const Transform3D &transform) {
+  Entry &entry = _entries[tick % k_capacity];
+  entry.tick = tick;
+  entry.valid = true;
+  entry.transform = transform;
+  _newest_tick = tick;
+}
+
+bool PlayerTransformHistory::get(uint32_t tick,
+                                 Transform3D &r_transform) const {
+  const Entry &entry = _entries[tick % k_capacity];
+  if (!entry.valid || entry.tick != tick) {
+    return false;
+  }
+  r_transform = entry.transform;
+  return true;
+}
+
+void PlayerTransformHistory::clear() {
+  for (Entry &entry : _entries) {
+    entry.valid = false;
+  }
+  _newest_tick = 0;
+}
+
+} // namespace morphic
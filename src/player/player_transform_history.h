@@ -0,0 +1,38 @@
+#pragma once
+
+#include <godot_cpp/variant/transform3d.hpp>
+
+#include <array>
+#include <cstdint>
+
+using namespace godot;
+
+namespace morphic {
+
+// Server-side record of where a player's body stood on each recent server
+// tick, for lag-compensated hit checks. A fixed ring indexed by tick:
+// recording never allocates and lookup is O(1).
+class PlayerTransformHistory {
+public:
+  // Covers PlayerRewind::k_max_rewind_s at physics rates up to 120 Hz.
+  static constexpr uint32_t k_capacity = 64;
+
+  void record(uint32_t tick, const Transform3D &transform);
+  // False when the tick fell out of the ring or was never recorded.
+  bool get(uint32_t tick, Transform3D &r_transform) const;
+  void clear();
+
+  uint32_t get_newest_tick() const { return _newest_tick; }
+
+private:
+  struct Entry {
+    uint32_t tick = 0;
+    bool valid = false;
+    Transform3D transform;
+  };
+
+  std::array<Entry, k_capacity> _entries;
+  uint32_t _newest_tick = 0;
+};
+
+} // namespace morphic
@@ -1,5 +1,6 @@
 #include "register_types.h"
 #include "core/network_manager.h"
+#include "core/threaded_enet_peer.h"
 #include "items/item_action.h"
 #include "items/item_database.h"
 #include "items/item_definition.h"
@@ -8,7 +9,9 @@
 #include "player/player_animator.h"
 #include "player/player_equipment.h"
 #include "saves/save_manager.h"
+#include "session/dedicated_server.h"
 #include "ui/main_menu.h"
+#include "world/player_replicator.h"
 #include "world/player_spawner.h"
 #include "world/world.h"
 #include "world/world_loader.h"
@@ -26,16 +29,19 @@ void initialize_morphic_module(ModuleInitializationLevel p_level) {
     return;
   }
   ClassDB::register_class<morphic::NetworkManager>();
+  ClassDB::register_class<morphic::ThreadedENetPeer>();
   ClassDB::register_class<morphic::ItemAction>();
   ClassDB::register_class<morphic::ItemDefinition>();
   ClassDB::register_class<morphic::ItemDatabase>();
   ClassDB::register_class<morphic::World>();
   ClassDB::register_class<morphic::PlayerSpawner>();
+  ClassDB::register_class<morphic::PlayerReplicator>();
   ClassDB::register_class<morphic::Player>();
   ClassDB::register_class<morphic::PlayerAnimator>();
   ClassDB::register_class<morphic::PlayerEquipment>();
   ClassDB::register_class<morphic::LocalPlayerController>();
   ClassDB::register_class<morphic::MainMenu>();
+  ClassDB::register_class<morphic::DedicatedServer>();
   ClassDB::register_class<morphic::WorldLoader>();
   ClassDB::register_class<morphic::SaveManager>();
   UtilityFunctions::print("morphic_core loaded!");
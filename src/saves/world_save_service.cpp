@@ -57,6 +57,7 @@ WorldSaveService::read_world_cfg(const String &save_dir_path) {
   info.save_dir = normalized;
   info.world_cfg_path = normalized.path_join(k_world_config_name);
   info.terrain_db_path = normalized.path_join(k_terrain_db_name);
+  info.terrain_edits_path = normalized.path_join(k_terrain_edits_name);
 
   ERR_FAIL_COND_V_MSG(
       !FileAccess::file_exists(info.world_cfg_path), info,
@@ -97,6 +98,7 @@ WorldSaveService::write_world_cfg_new(const String &save_dir_path, int seed) {
   info.save_dir = normalized;
   info.world_cfg_path = normalized.path_join(k_world_config_name);
   info.terrain_db_path = normalized.path_join(k_terrain_db_name);
+  info.terrain_edits_path = normalized.path_join(k_terrain_edits_name);
 
   ERR_FAIL_COND_V_MSG(seed == 0, info,
                       "WorldSaveService: Refusing to create new save with "
@@ -168,6 +170,7 @@ Dictionary WorldSaveService::to_dict(const WorldSaveInfo &info) const {
   d["save_dir"] = info.save_dir;
   d["world_cfg_path"] = info.world_cfg_path;
   d["terrain_db_path"] = info.terrain_db_path;
+  d["terrain_edits_path"] = info.terrain_edits_path;
   d["generator_signature"] = info.generator_signature;
   return d;
 }
@@ -20,6 +20,8 @@ public:
     String save_dir;
     String world_cfg_path;
     String terrain_db_path;
+    // blocks that differ from the generator (see TerrainEditLog)
+    String terrain_edits_path;
 
     // optional metadata, terrain can use it to validate generator compatibility
     String generator_signature; // e.g. "graph_hash:abcd..." or "v1"
@@ -42,6 +44,7 @@ private:
   static constexpr int k_world_config_version = 1;
   static constexpr const char *k_world_config_name = "world.cfg";
   static constexpr const char *k_terrain_db_name = "terrain.sqlite";
+  static constexpr const char *k_terrain_edits_name = "terrain_edits.bin";
 
   bool ensure_save_directory(const String &save_dir_path);
   bool world_cfg_exists(const String &save_dir_path) const;
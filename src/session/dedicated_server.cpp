@@ -0,0 +1,162 @@
+#include "dedicated_server.h"
+#include "utils/bind_methods.h"
+#include "utils/debug_utils.h"
+#include "utils/network_utils.h"
+
+#include "godot_cpp/classes/engine.hpp"
+#include "godot_cpp/classes/os.hpp"
+#include "godot_cpp/classes/scene_tree.hpp"
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/defs.hpp>
+
+using namespace godot;
+
+namespace morphic {
+
+void DedicatedServer::_ready() {
+  if (Engine::get_singleton()->is_editor_hint())
+    return;
+
+  apply_command_line();
+
+  // Nothing is drawn: frames past the physics rate only burn CPU.
+  Engine::get_singleton()->set_max_fps(
+      Engine::get_singleton()->get_physics_ticks_per_second());
+
+  _world_loader = get_node<WorldLoader>(_world_loader_path);
+  if (!_world_loader) {
+    fail_startup(
+        "Cant get WorldLoader in dedicated server. Check if path is correct");
+    return;
+  }
+
+  _net_manager = NetUtils::get_net_manager(this);
+  if (!_net_manager) {
+    fail_startup("Cant get NetworkManager in server");
+    return;
+  }
+  _save_manager =
+      cast_to<SaveManager>(get_node_or_null("/root/GlobalSaveManager"));
+  if (!_save_manager) {
+    fail_startup("Cant get SaveManager with path: /root/GlobalSaveManager");
+    return;
+  }
+  if (!_session_flow.configure(_net_manager, _world_loader, _save_manager)) {
+    fail_startup("DedicatedServer: failed configuring SessionFlow");
+    return;
+  }
+
+  Error err = _world_loader->connect(
+      "loading_finished", Callable(this, "on_world_loading_finished"));
+  if (err != OK) {
+    ERR_PRINT(
+        DebugUtils::format_log("connect loading_finished failed: %d", err));
+  }
+  err = _world_loader->connect("loading_failed",
+                               Callable(this, "on_world_loading_failed"));
+  if (err != OK) {
+    ERR_PRINT(DebugUtils::format_log("connect loading_failed failed: %d", err));
+  }
+
+  LOG("DedicatedServer: port %d, save %s, seed %d", _port, _save_name, _seed);
+  if (!_session_flow.request_dedicated(_world_scene_path, _port, _saves_path,
+                                       _save_name, _seed)) {
+    get_tree()->quit(1);
+  }
+}
+
+void DedicatedServer::apply_command_line() {
+  const PackedStringArray args = OS::get_singleton()->get_cmdline_user_args();
+  for (int i = 0; i < args.size(); i++) {
+    String key = args[i];
+    String value;
+    if (!key.begins_with("--")) {
+      WARN_PRINT("DedicatedServer: ignoring argument " + key);
+      continue;
+    }
+    if (key.contains("=")) {
+      value = key.get_slice("=", 1);
+      key = key.get_slice("=", 0);
+    } else if (i + 1 < args.size()) {
+      value = args[++i];
+    }
+
+    if (key == "--port" && value.is_valid_int()) {
+      _port = value.to_int();
+    } else if (key == "--save") {
+      _save_name = value;
+    } else if (key == "--saves-path") {
+      _saves_path = value;
+    } else if (key == "--seed" && value.is_valid_int()) {
+      _seed = value.to_int();
+    } else if (key == "--world-scene") {
+      _world_scene_path = value;
+    } else {
+      WARN_PRINT("DedicatedServer: unknown argument " + key);
+    }
+  }
+}
+
+void DedicatedServer::on_world_loading_finished() {
+  _session_flow.on_world_loading_finished();
+  LOG("DedicatedServer: world loaded, accepting players");
+}
+
+void DedicatedServer::fail_startup(const String &reason) {
+  ERR_PRINT(reason);
+  get_tree()->quit(1);
+}
+
+void DedicatedServer::on_world_loading_failed(const String &error) {
+  _session_flow.on_world_loading_failed(error);
+  // Nobody is there to press a button: let the supervisor restart us.
+  get_tree()->quit(1);
+}
+
+String DedicatedServer::get_world_scene_path() const {
+  return _world_scene_path;
+}
+void DedicatedServer::set_world_scene_path(String p_path) {
+  _world_scene_path = p_path;
+}
+
+NodePath DedicatedServer::get_world_loader_path() const {
+  return _world_loader_path;
+}
+void DedicatedServer::set_world_loader_path(NodePath p_path) {
+  _world_loader_path = p_path;
+}
+
+String DedicatedServer::get_saves_path() const { return _saves_path; }
+void DedicatedServer::set_saves_path(const String &p_path) {
+  _saves_path = p_path;
+}
+
+String DedicatedServer::get_save_name() const { return _save_name; }
+void DedicatedServer::set_save_name(const String &p_name) {
+  _save_name = p_name;
+}
+
+int DedicatedServer::get_port() const { return _port; }
+void DedicatedServer::set_port(int p_port) { _port = p_port; }
+
+int DedicatedServer::get_seed() const { return _seed; }
+void DedicatedServer::set_seed(int p_seed) { _seed = p_seed; }
+
+void DedicatedServer::_bind_methods() {
+  ClassDB::bind_method(D_METHOD("on_world_loading_finished"),
+                       &DedicatedServer::on_world_loading_finished);
+  ClassDB::bind_method(D_METHOD("on_world_loading_failed", "error"),
+                       &DedicatedServer::on_world_loading_failed);
+
+  BIND_PROPERTY(DedicatedServer, Variant::STRING, "world_scene_path",
+                world_scene_path);
+  BIND_PROPERTY(DedicatedServer, Variant::NODE_PATH, "world_loader_path",
+                world_loader_path);
+  BIND_PROPERTY(DedicatedServer, Variant::STRING, "saves_path", saves_path);
+  BIND_PROPERTY(DedicatedServer, Variant::STRING, "save_name", save_name);
+  BIND_PROPERTY(DedicatedServer, Variant::INT, "port", port);
+  BIND_PROPERTY(DedicatedServer, Variant::INT, "seed", seed);
+}
+
+} // namespace morphic
@@ -0,0 +1,65 @@
+#pragma once
+#include "session/session_flow.h"
+#include "saves/save_manager.h"
+#include "world/world_loader.h"
+#include <core/network_manager.h>
+#include <godot_cpp/classes/node.hpp>
+
+using namespace godot;
+
+namespace morphic {
+
+// Boot scene of a dedicated server; replaces MainMenu. Started headless
+// with the scene on the command line and the session after `--`:
+//
+//   godot --headless --path game res://core/dedicated_server.tscn --
+//         --port=7777 --save=world --seed=1234
+//
+// Arguments left out keep the properties' values. There is no local
+// player: the world loads as WorldLoader::MODE_DEDICATED, players spawn
+// from PlayerSpawner's server scene and no terrain viewer needs visuals.
+class DedicatedServer : public Node {
+  GDCLASS(DedicatedServer, Node)
+
+protected:
+  static void _bind_methods();
+
+public:
+  void _ready() override;
+
+private:
+  NetworkManager *_net_manager = nullptr;
+  SaveManager *_save_manager = nullptr;
+  WorldLoader *_world_loader = nullptr;
+  SessionFlow _session_flow;
+
+  String _world_scene_path = "res://world/world.tscn";
+  NodePath _world_loader_path;
+  String _saves_path = "user://saves";
+  String _save_name = "world";
+  int _port = 7777;
+  int _seed = 0;
+
+  // Overrides the properties from `--key=value` / `--key value` user args.
+  void apply_command_line();
+  // Logs `reason` and exits non-zero, so a supervisor sees the failure.
+  void fail_startup(const String &reason);
+
+  void on_world_loading_finished();
+  void on_world_loading_failed(const String &error);
+
+  NodePath get_world_loader_path() const;
+  void set_world_loader_path(NodePath p_path);
+  String get_world_scene_path() const;
+  void set_world_scene_path(String p_path);
+  String get_saves_path() const;
+  void set_saves_path(const String &p_path);
+  String get_save_name() const;
+  void set_save_name(const String &p_name);
+  int get_port() const;
+  void set_port(int p_port);
+  int get_seed() const;
+  void set_seed(int p_seed);
+};
+
+} // namespace morphic
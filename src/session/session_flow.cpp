@@ -33,12 +33,27 @@ bool SessionFlow::configure(NetworkManager *net_manager,
 bool SessionFlow::request_host(const String &world_scene_path, int host_port,
                                const String &saves_path,
                                const String &save_name, int seed) {
+  return start_server(world_scene_path, host_port, saves_path, save_name,
+                      seed, false);
+}
+
+bool SessionFlow::request_dedicated(const String &world_scene_path, int port,
+                                    const String &saves_path,
+                                    const String &save_name, int seed) {
+  return start_server(world_scene_path, port, saves_path, save_name, seed,
+                      true);
+}
+
+bool SessionFlow::start_server(const String &world_scene_path, int port,
+                               const String &saves_path,
+                               const String &save_name, int seed,
+                               bool dedicated) {
   if (!dependencies_ready()) {
     return false;
   }
 
   if (!can_start_new_flow()) {
-    ERR_PRINT("SessionFlow: request_host rejected. Flow already in progress.");
+    ERR_PRINT("SessionFlow: server start rejected. Flow already in progress.");
     return false;
   }
 
@@ -49,11 +64,13 @@ bool SessionFlow::request_host(const String &world_scene_path, int host_port,
   _loading_epoch = 0;
   _connecting_epoch = 0;
 
-  if (!transition(HOST_STARTING, "Host start requested")) {
+  if (!transition(HOST_STARTING, dedicated ? "Dedicated start requested"
+                                            : "Host start requested")) {
     return false;
   }
 
-  if (!_net_manager->start_host(host_port)) {
+  _net_manager->set_dedicated(dedicated);
+  if (!_net_manager->start_host(port)) {
     return fail("Failed starting host");
   }
 
@@ -79,8 +96,9 @@ bool SessionFlow::request_host(const String &world_scene_path, int host_port,
     return false;
   }
   _loading_epoch = _epoch;
-  _world_loader->load_world_from_save_async(world_scene_path,
-                                            WorldLoader::MODE_HOST, save);
+  _world_loader->load_world_from_save_async(
+      world_scene_path,
+      dedicated ? WorldLoader::MODE_DEDICATED : WorldLoader::MODE_HOST, save);
   return true;
 }
 
@@ -28,6 +28,10 @@ public:
   bool request_host(const godot::String &world_scene_path, int host_port,
                     const godot::String &saves_path,
                     const godot::String &save_name, int seed);
+  // Like request_host, but without a local player (see DedicatedServer).
+  bool request_dedicated(const godot::String &world_scene_path, int port,
+                         const godot::String &saves_path,
+                         const godot::String &save_name, int seed);
   bool request_join(const godot::String &world_scene_path,
                     const godot::String &join_address, int join_port,
                     const godot::String &expected_world_id);
@@ -55,6 +59,9 @@ private:
   int _pending_join_port = 0;
   godot::String _pending_expected_world_id;
 
+  bool start_server(const godot::String &world_scene_path, int port,
+                    const godot::String &saves_path,
+                    const godot::String &save_name, int seed, bool dedicated);
   bool dependencies_ready() const;
   bool can_start_new_flow() const;
   godot::String build_save_path(const godot::String &saves_path,
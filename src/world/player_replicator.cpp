@@ -0,0 +1,737 @@
+#include "player_replicator.h"
+#include "player_rewind.h"
+#include "utils/bind_methods.h"
+#include "utils/debug_utils.h"
+#include "utils/network_utils.h"
+
+#include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/physics_direct_space_state3d.hpp>
+#include <godot_cpp/classes/physics_ray_query_parameters3d.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/classes/voxel_terrain.hpp>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+#include <godot_cpp/classes/world3d.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+using namespace godot;
+
+namespace morphic {
+
+void PlayerReplicator::_ready() {
+  if (Engine::get_singleton()->is_editor_hint()) {
+    set_physics_process(false);
+    return;
+  }
+
+  _players_root = get_node_or_null(_players_path);
+  ERR_FAIL_COND_MSG(!_players_root,
+                    "PlayerReplicator: Cant find Players node. Check path");
+
+  bind_messages();
+
+  if (NetUtils::is_server(this)) {
+    server_bind_to_network();
+  }
+
+  set_physics_process(true);
+}
+
+void PlayerReplicator::_physics_process(double delta) {
+  if (!_players_root || !NetUtils::is_server(this)) {
+    return;
+  }
+  server_tick(delta);
+}
+
+void PlayerReplicator::_exit_tree() {
+  if (Engine::get_singleton()->is_editor_hint()) {
+    return;
+  }
+  unbind_messages();
+}
+
+void PlayerReplicator::bind_messages() {
+  NetworkManager *net_manager = NetUtils::get_net_manager(this);
+  ERR_FAIL_COND_MSG(!net_manager, "PlayerReplicator: NetworkManager missing");
+
+  NetDispatcher &dispatcher = net_manager->get_dispatcher();
+  dispatcher.bind<PlayerInputMessage>(
+      [this](int sender_id, const PlayerInputMessage &message) {
+        server_on_input(sender_id, message);
+      });
+  dispatcher.bind<SnapshotAckMessage>(
+      [this](int sender_id, const SnapshotAckMessage &message) {
+        server_on_snapshot_ack(sender_id, message);
+      });
+  dispatcher.bind<PlayerSnapshotMessage>(
+      [this](int, const PlayerSnapshotMessage &message) {
+        client_on_snapshot(message);
+      });
+}
+
+void PlayerReplicator::unbind_messages() {
+  NetworkManager *net_manager = NetUtils::get_net_manager(this);
+  if (!net_manager) {
+    return;
+  }
+  NetDispatcher &dispatcher = net_manager->get_dispatcher();
+  dispatcher.unbind<PlayerInputMessage>();
+  dispatcher.unbind<SnapshotAckMessage>();
+  dispatcher.unbind<PlayerSnapshotMessage>();
+}
+
+Player *PlayerReplicator::find_player(int p_peer_id) const {
+  if (!_players_root) {
+    return nullptr;
+  }
+  // PlayerSpawner names players after their peer id.
+  return Object::cast_to<Player>(
+      _players_root->get_node_or_null(NodePath(String::num_int64(p_peer_id))));
+}
+
+//////// SERVER ////////////////
+
+void PlayerReplicator::server_bind_to_network() {
+  NetworkManager *net_manager = NetUtils::get_net_manager(this);
+  ERR_FAIL_COND_MSG(!net_manager, "PlayerReplicator: NetworkManager missing");
+
+  net_manager->connect("player_left", Callable(this, "server_on_peer_left"));
+}
+
+void PlayerReplicator::server_tick(double delta) {
+  // Snapshots and transform history use the NetworkManager tick, the same
+  // timeline clients estimate through clock sync.
+  NetworkManager *net_manager = NetUtils::get_net_manager(this);
+  ERR_FAIL_COND_MSG(!net_manager, "PlayerReplicator: NetworkManager missing");
+  _server_tick = net_manager->get_server_tick();
+
+  Time *time = Time::get_singleton();
+  std::fill(std::begin(_phase_usec), std::end(_phase_usec), 0);
+
+  // Ingest: this tick's inputs off every simulated player's queue.
+  const uint64_t ingest_start = time->get_ticks_usec();
+  _simulated_players.clear();
+  if (_batched_simulation) {
+    _sim.begin_tick();
+  }
+  for (int i = 0; i < _players_root->get_child_count(); i++) {
+    Player *player = Object::cast_to<Player>(_players_root->get_child(i));
+    if (!player || !player->is_server_simulated()) {
+      continue;
+    }
+    if (_batched_simulation) {
+      _sim.gather(player);
+    }
+    _simulated_players.push_back(player);
+  }
+  _phase_usec[PHASE_INGEST] = time->get_ticks_usec() - ingest_start;
+
+  // Simulate: movement, then transform history and swings against it.
+  const uint64_t simulate_start = time->get_ticks_usec();
+  if (_batched_simulation) {
+    _sim.step(delta);
+    _sim.mirror();
+  } else {
+    for (Player *player : _simulated_players) {
+      player->server_simulate(delta);
+    }
+  }
+  _last_simulation_usec = time->get_ticks_usec() - ingest_start;
+  _simulated_player_count = static_cast<int>(_simulated_players.size());
+
+  int dormant = 0;
+  int active = 0;
+  for (int i = 0; i < _players_root->get_child_count(); i++) {
+    Player *player = Object::cast_to<Player>(_players_root->get_child(i));
+    if (!player) {
+      continue;
+    }
+    player->record_transform_history(_server_tick);
+    if (player->is_dormant()) {
+      dormant++;
+    } else {
+      active++;
+    }
+  }
+  _dormant_player_count = dormant;
+  _active_player_count = active;
+
+  server_resolve_swings();
+  _phase_usec[PHASE_SIMULATE] = time->get_ticks_usec() - simulate_start;
+
+  if (_server_tick % static_cast<uint32_t>(_snapshot_interval_ticks) == 0) {
+    server_send_snapshots();
+  }
+}
+
+void PlayerReplicator::server_resolve_swings() {
+  for (int i = 0; i < _players_root->get_child_count(); i++) {
+    Player *player = Object::cast_to<Player>(_players_root->get_child(i));
+    uint32_t view_tick = 0;
+    if (player && player->consume_pending_swing(view_tick)) {
+      server_check_swing(player, view_tick);
+    }
+  }
+}
+
+void PlayerReplicator::server_check_swing(Player *attacker,
+                                          uint32_t view_tick) {
+  Node3D *head = attacker->get_head_node();
+  if (!head || !attacker->is_inside_tree()) {
+    return;
+  }
+  const uint64_t start_usec = Time::get_singleton()->get_ticks_usec();
+
+  const Transform3D aim = head->get_global_transform();
+  const Vector3 to = aim.origin - aim.basis.get_column(2) * _hit_reach;
+
+  // Players as the attacker saw them; terrain (and anything else) as it is
+  // now, in a query that skips every player body.
+  PlayerRewind rewind(_players_root, attacker,
+                      _lag_compensation_enabled ? view_tick : _server_tick,
+                      _server_tick);
+  _last_rewind_ticks = _server_tick - rewind.get_tick();
+  PlayerRewind::Hit player_hit;
+  const bool hit_player = rewind.intersect_ray(aim.origin, to, player_hit);
+
+  Ref<PhysicsRayQueryParameters3D> query =
+      PhysicsRayQueryParameters3D::create(aim.origin, to);
+  query->set_exclude(rewind.get_player_bodies());
+  const Dictionary hit =
+      attacker->get_world_3d()->get_direct_space_state()->intersect_ray(
+          query);
+
+  _last_hit_check_usec = Time::get_singleton()->get_ticks_usec() - start_usec;
+  _hit_check_count++;
+
+  // Whichever is nearer blocks the other.
+  const float world_distance =
+      hit.is_empty() ? Math_INF
+                     : aim.origin.distance_to(Vector3(hit["position"]));
+  if (hit_player && player_hit.distance <= world_distance) {
+    player_hit.player->wake_dormant();
+    emit_signal("player_hit", attacker->get_peer_id(),
+                player_hit.player->get_peer_id(), player_hit.position);
+    return;
+  }
+  if (hit.is_empty()) {
+    return;
+  }
+  Object *collider = hit["collider"];
+  if (Object::cast_to<VoxelTerrain>(collider)) {
+    emit_signal("terrain_hit", attacker->get_peer_id(), hit["position"],
+                hit["normal"]);
+  }
+}
+
+void PlayerReplicator::server_send_snapshots() {
+  NetworkManager *net_manager = NetUtils::get_net_manager(this);
+  if (!net_manager) {
+    return;
+  }
+  Time *time = Time::get_singleton();
+
+  // Interest: gather the world state on this thread (scene reads), then
+  // update every viewer's relevant set in parallel.
+  const uint64_t interest_start = time->get_ticks_usec();
+  server_prepare_peer_jobs(net_manager);
+  _interest.rebuild(_interest_entities);
+  run_peer_tasks(&PlayerReplicator::server_interest_task);
+  _phase_usec[PHASE_INTEREST] = time->get_ticks_usec() - interest_start;
+  _last_interest_usec = _phase_usec[PHASE_INTEREST];
+
+  // Encode: every peer's snapshot against its own baseline, in parallel.
+  const uint64_t encode_start = time->get_ticks_usec();
+  run_peer_tasks(&PlayerReplicator::server_encode_task);
+  _phase_usec[PHASE_ENCODE] = time->get_ticks_usec() - encode_start;
+
+  // Send: visibility changes and packets go out from this thread, in peer
+  // order, as the scene and the multiplayer peer are not thread safe.
+  const uint64_t send_start = time->get_ticks_usec();
+  _last_snapshot_bytes = 0;
+  for (int i = 0; i < _peer_job_count; i++) {
+    const PeerTickJob &job = _peer_jobs[i];
+    if (job.has_viewer) {
+      server_apply_visibility(job);
+    }
+
+    PlayerSnapshotMessage message;
+    message.snapshot.bytes = job.bytes;
+    const Error err = net_manager->send_message(job.peer_id, message);
+    if (err != OK) {
+      _snapshot_send_failures++;
+      // Once per run; get_snapshot_send_failures() keeps the count.
+      WARN_PRINT_ONCE(DebugUtils::format_log(
+          "PlayerReplicator: snapshot of %d bytes to peer %d not sent: %d",
+          static_cast<int>(job.bytes.size()), job.peer_id, err));
+      continue;
+    }
+
+    _last_snapshot_bytes += static_cast<int>(job.bytes.size());
+    _snapshot_bytes_sent += job.bytes.size();
+    if (job.delta) {
+      _delta_snapshots_sent++;
+    } else {
+      _full_snapshots_sent++;
+    }
+  }
+  _phase_usec[PHASE_SEND] = time->get_ticks_usec() - send_start;
+}
+
+void PlayerReplicator::server_prepare_peer_jobs(NetworkManager *net_manager) {
+  _world_snapshot.sequence = ++_snapshot_sequence;
+  _world_snapshot.server_tick = _server_tick;
+  _world_snapshot.players.clear();
+  _snapshot_players.clear();
+  _interest_entities.clear();
+  for (int i = 0; i < _players_root->get_child_count(); i++) {
+    Player *player = Object::cast_to<Player>(_players_root->get_child(i));
+    if (!player || !player->get_server_authoritative()) {
+      continue;
+    }
+    const int peer_id = player->get_peer_id();
+    const PlayerNetState state = player->get_net_state();
+    _world_snapshot.players.push_back(
+        QuantizedPlayerState::quantize(peer_id, state));
+    _snapshot_players[peer_id] = player;
+    _interest_entities.push_back({peer_id, state.position});
+  }
+  std::sort(_world_snapshot.players.begin(), _world_snapshot.players.end(),
+            [](const QuantizedPlayerState &a, const QuantizedPlayerState &b) {
+              return a.peer_id < b.peer_id;
+            });
+
+  // Everything the tasks would otherwise look up in shared maps is
+  // resolved here, so they only ever write to their own job.
+  _peer_job_count = 0;
+  Array peer_ids = net_manager->get_ready_player_ids();
+  for (int i = 0; i < peer_ids.size(); i++) {
+    const int peer_id = peer_ids[i];
+    if (peer_id == 1) {
+      continue;
+    }
+    if (_peer_job_count == static_cast<int>(_peer_jobs.size())) {
+      _peer_jobs.emplace_back();
+    }
+    PeerTickJob &job = _peer_jobs[_peer_job_count++];
+    job.peer_id = peer_id;
+    job.state = &_peer_snapshots[peer_id];
+    job.ack_tick = 0;
+    job.input_fill = 0;
+
+    // Viewers without a player yet see nobody; their own player reaches
+    // them through the owner visibility set in Player.
+    auto viewer_it = _snapshot_players.find(peer_id);
+    job.has_viewer = viewer_it != _snapshot_players.end();
+    if (job.has_viewer) {
+      const Player *viewer = viewer_it->second;
+      job.position = viewer->get_global_position();
+      job.ack_tick =
+          static_cast<uint32_t>(viewer->get_last_processed_input_tick());
+      job.input_fill = static_cast<uint8_t>(
+          std::min(viewer->get_pending_input_count(), 255));
+      _interest.add_viewer(peer_id);
+    }
+  }
+}
+
+void PlayerReplicator::run_peer_tasks(PeerTask p_task) {
+  if (_peer_job_count == 0) {
+    return;
+  }
+  int tasks = 1;
+  if (_parallel_tick) {
+    const int per_task = MAX(_peers_per_task, 1);
+    tasks = MIN((_peer_job_count + per_task - 1) / per_task,
+                OS::get_singleton()->get_processor_count());
+    tasks = MAX(tasks, 1);
+  }
+  if (static_cast<int>(_task_scratch.size()) < tasks) {
+    _task_scratch.resize(tasks);
+  }
+  _task_count = tasks;
+  _last_task_count = tasks;
+
+  if (tasks == 1) {
+    (this->*p_task)(0);
+    return;
+  }
+  WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+  const int64_t group = pool->add_group_task(callable_mp(this, p_task), tasks,
+                                             tasks, true, "PlayerReplicator");
+  pool->wait_for_group_task_completion(group);
+}
+
+void PlayerReplicator::server_interest_task(uint32_t p_task) {
+  TaskScratch &scratch = _task_scratch[p_task];
+  const int begin = p_task * _peer_job_count / _task_count;
+  const int end = (p_task + 1) * _peer_job_count / _task_count;
+  for (int i = begin; i < end; i++) {
+    PeerTickJob &job = _peer_jobs[i];
+    job.entered.clear();
+    job.left.clear();
+    if (job.has_viewer) {
+      _interest.update_viewer(job.peer_id, job.position, scratch.relevant,
+                              job.entered, job.left);
+    }
+  }
+}
+
+void PlayerReplicator::server_encode_task(uint32_t p_task) {
+  const int begin = p_task * _peer_job_count / _task_count;
+  const int end = (p_task + 1) * _peer_job_count / _task_count;
+  for (int i = begin; i < end; i++) {
+    PeerTickJob &job = _peer_jobs[i];
+    PlayerSnapshot &snapshot = job.snapshot;
+    snapshot.sequence = _world_snapshot.sequence;
+    snapshot.server_tick = _world_snapshot.server_tick;
+    snapshot.ack_tick = job.ack_tick;
+    snapshot.input_fill = job.input_fill;
+    snapshot.players.clear();
+
+    const std::vector<int32_t> *relevant = _interest.get_relevant(job.peer_id);
+    if (relevant) {
+      // Both lists are sorted by peer id.
+      size_t r = 0;
+      for (const QuantizedPlayerState &state : _world_snapshot.players) {
+        while (r < relevant->size() && (*relevant)[r] < state.peer_id) {
+          r++;
+        }
+        if (r < relevant->size() && (*relevant)[r] == state.peer_id) {
+          snapshot.players.push_back(state);
+        }
+      }
+    }
+
+    PeerSnapshotState &peer = *job.state;
+    const PlayerSnapshot *baseline =
+        peer.acked_sequence != 0 ? peer.history.find(peer.acked_sequence)
+                                 : nullptr;
+    job.bytes = PlayerSnapshotCodec::encode(snapshot, baseline);
+    job.delta = baseline != nullptr;
+    peer.history.store(snapshot);
+  }
+}
+
+void PlayerReplicator::server_apply_visibility(const PeerTickJob &job) {
+  for (int32_t id : job.entered) {
+    auto it = _snapshot_players.find(id);
+    if (it != _snapshot_players.end()) {
+      it->second->set_replicated_to_peer(job.peer_id, true);
+    }
+  }
+  for (int32_t id : job.left) {
+    auto it = _snapshot_players.find(id);
+    if (it != _snapshot_players.end()) {
+      it->second->set_replicated_to_peer(job.peer_id, false);
+    }
+  }
+}
+
+void PlayerReplicator::server_on_peer_left(int p_peer_id) {
+  _peer_snapshots.erase(p_peer_id);
+  _interest.remove_viewer(p_peer_id);
+}
+
+void PlayerReplicator::server_on_input(int p_sender_id,
+                                       const PlayerInputMessage &message) {
+  // Only the owner's packets reach its player; everyone else's id differs.
+  Player *player = find_player(p_sender_id);
+  if (player && player->get_peer_id() == p_sender_id) {
+    player->server_receive_input(message.inputs.bytes);
+  }
+}
+
+void PlayerReplicator::server_on_snapshot_ack(
+    int p_sender_id, const SnapshotAckMessage &message) {
+  auto it = _peer_snapshots.find(p_sender_id);
+  if (it == _peer_snapshots.end()) {
+    return;
+  }
+
+  PeerSnapshotState &peer = it->second;
+  const uint32_t seq = message.sequence;
+  if (seq > peer.acked_sequence && peer.history.find(seq)) {
+    peer.acked_sequence = seq;
+  }
+}
+
+//////// CLIENT ////////////////
+
+void PlayerReplicator::client_on_snapshot(
+    const PlayerSnapshotMessage &message) {
+  if (!_players_root) {
+    return;
+  }
+
+  const PackedByteArray &bytes = message.snapshot.bytes;
+
+  uint32_t sequence = 0;
+  uint32_t baseline_sequence = 0;
+  if (!PlayerSnapshotCodec::peek_baseline(bytes, sequence,
+                                          baseline_sequence)) {
+    return;
+  }
+  if (sequence <= _client_latest_sequence) {
+    return;
+  }
+
+  const PlayerSnapshot *baseline =
+      baseline_sequence != 0 ? _client_history.find(baseline_sequence)
+                             : nullptr;
+  PlayerSnapshot snapshot;
+  if (!PlayerSnapshotCodec::decode(bytes, baseline, snapshot)) {
+    // Baseline already dropped from our history; the server falls back to
+    // a full snapshot once acks stop advancing.
+    return;
+  }
+
+  _client_history.store(snapshot);
+  _client_latest_sequence = snapshot.sequence;
+  client_apply_snapshot(snapshot);
+
+  NetworkManager *net_manager = NetUtils::get_net_manager(this);
+  if (net_manager) {
+    SnapshotAckMessage ack;
+    ack.sequence = snapshot.sequence;
+    net_manager->send_message(1, ack);
+  }
+}
+
+void PlayerReplicator::client_apply_snapshot(const PlayerSnapshot &snapshot) {
+  const int my_id = NetUtils::get_mp(this)->get_unique_id();
+
+  for (int i = 0; i < _players_root->get_child_count(); i++) {
+    Player *player = Object::cast_to<Player>(_players_root->get_child(i));
+    if (!player) {
+      continue;
+    }
+    const QuantizedPlayerState *state = snapshot.find(player->get_peer_id());
+    if (!state) {
+      continue;
+    }
+    PlayerNetState net_state = state->dequantize();
+    if (player->get_peer_id() != my_id) {
+      player->push_remote_state(snapshot.server_tick, net_state);
+      continue;
+    }
+    net_state.tick = snapshot.ack_tick;
+    player->apply_net_state(net_state);
+    player->apply_input_feedback(snapshot.input_fill);
+  }
+}
+
+////////////////////
+
+NodePath PlayerReplicator::get_players_path() const { return _players_path; }
+void PlayerReplicator::set_players_path(NodePath p_path) {
+  _players_path = p_path;
+}
+
+int PlayerReplicator::get_snapshot_interval_ticks() const {
+  return _snapshot_interval_ticks;
+}
+void PlayerReplicator::set_snapshot_interval_ticks(int p_ticks) {
+  _snapshot_interval_ticks = p_ticks < 1 ? 1 : p_ticks;
+}
+
+bool PlayerReplicator::get_interest_enabled() const {
+  return _interest.is_enabled();
+}
+void PlayerReplicator::set_interest_enabled(bool p_enabled) {
+  _interest.set_enabled(p_enabled);
+}
+
+float PlayerReplicator::get_interest_enter_radius() const {
+  return _interest.get_enter_radius();
+}
+void PlayerReplicator::set_interest_enter_radius(float p_radius) {
+  _interest.set_radii(p_radius, _interest.get_leave_radius());
+}
+
+float PlayerReplicator::get_interest_leave_radius() const {
+  return _interest.get_leave_radius();
+}
+void PlayerReplicator::set_interest_leave_radius(float p_radius) {
+  _interest.set_radii(_interest.get_enter_radius(), p_radius);
+}
+
+bool PlayerReplicator::get_lag_compensation_enabled() const {
+  return _lag_compensation_enabled;
+}
+void PlayerReplicator::set_lag_compensation_enabled(bool p_enabled) {
+  _lag_compensation_enabled = p_enabled;
+}
+
+float PlayerReplicator::get_hit_reach() const { return _hit_reach; }
+void PlayerReplicator::set_hit_reach(float p_reach) {
+  _hit_reach = MAX(p_reach, 0.0f);
+}
+
+bool PlayerReplicator::get_batched_simulation() const {
+  return _batched_simulation;
+}
+void PlayerReplicator::set_batched_simulation(bool p_enabled) {
+  if (_batched_simulation && !p_enabled) {
+    // The nodes already mirror the sim state; they take over from here.
+    _sim.clear();
+  }
+  _batched_simulation = p_enabled;
+}
+
+bool PlayerReplicator::get_parallel_tick() const { return _parallel_tick; }
+void PlayerReplicator::set_parallel_tick(bool p_enabled) {
+  _parallel_tick = p_enabled;
+}
+
+int PlayerReplicator::get_peers_per_task() const { return _peers_per_task; }
+void PlayerReplicator::set_peers_per_task(int p_peers) {
+  _peers_per_task = p_peers < 1 ? 1 : p_peers;
+}
+
+int PlayerReplicator::get_last_simulation_usec() const {
+  return static_cast<int>(_last_simulation_usec);
+}
+
+int PlayerReplicator::get_simulated_player_count() const {
+  return _simulated_player_count;
+}
+
+float PlayerReplicator::get_simulation_usec_per_player() const {
+  if (_simulated_player_count == 0) {
+    return 0.0f;
+  }
+  return static_cast<float>(_last_simulation_usec) / _simulated_player_count;
+}
+
+int PlayerReplicator::get_dormant_player_count() const {
+  return _dormant_player_count;
+}
+
+int PlayerReplicator::get_active_player_count() const {
+  return _active_player_count;
+}
+
+int PlayerReplicator::get_last_snapshot_bytes() const {
+  return _last_snapshot_bytes;
+}
+
+int64_t PlayerReplicator::get_snapshot_bytes_sent() const {
+  return _snapshot_bytes_sent;
+}
+
+int64_t PlayerReplicator::get_full_snapshots_sent() const {
+  return _full_snapshots_sent;
+}
+
+int64_t PlayerReplicator::get_delta_snapshots_sent() const {
+  return _delta_snapshots_sent;
+}
+
+int64_t PlayerReplicator::get_snapshot_send_failures() const {
+  return _snapshot_send_failures;
+}
+
+int PlayerReplicator::get_last_interest_usec() const {
+  return static_cast<int>(_last_interest_usec);
+}
+
+int PlayerReplicator::get_interest_pair_count() const {
+  return _interest.get_relevant_pair_count();
+}
+
+int PlayerReplicator::get_last_hit_check_usec() const {
+  return static_cast<int>(_last_hit_check_usec);
+}
+
+int PlayerReplicator::get_last_rewind_ticks() const {
+  return static_cast<int>(_last_rewind_ticks);
+}
+
+int64_t PlayerReplicator::get_hit_check_count() const {
+  return _hit_check_count;
+}
+
+Dictionary PlayerReplicator::get_tick_phase_usec() const {
+  Dictionary phases;
+  phases["ingest"] = static_cast<int64_t>(_phase_usec[PHASE_INGEST]);
+  phases["simulate"] = static_cast<int64_t>(_phase_usec[PHASE_SIMULATE]);
+  phases["interest"] = static_cast<int64_t>(_phase_usec[PHASE_INTEREST]);
+  phases["encode"] = static_cast<int64_t>(_phase_usec[PHASE_ENCODE]);
+  phases["send"] = static_cast<int64_t>(_phase_usec[PHASE_SEND]);
+  phases["tasks"] = _last_task_count;
+  return phases;
+}
+
+void PlayerReplicator::_bind_methods() {
+  ClassDB::bind_method(D_METHOD("get_last_simulation_usec"),
+                       &PlayerReplicator::get_last_simulation_usec);
+  ClassDB::bind_method(D_METHOD("get_simulated_player_count"),
+                       &PlayerReplicator::get_simulated_player_count);
+  ClassDB::bind_method(D_METHOD("get_simulation_usec_per_player"),
+                       &PlayerReplicator::get_simulation_usec_per_player);
+  ClassDB::bind_method(D_METHOD("get_dormant_player_count"),
+                       &PlayerReplicator::get_dormant_player_count);
+  ClassDB::bind_method(D_METHOD("get_active_player_count"),
+                       &PlayerReplicator::get_active_player_count);
+  ClassDB::bind_method(D_METHOD("get_last_snapshot_bytes"),
+                       &PlayerReplicator::get_last_snapshot_bytes);
+  ClassDB::bind_method(D_METHOD("get_snapshot_bytes_sent"),
+                       &PlayerReplicator::get_snapshot_bytes_sent);
+  ClassDB::bind_method(D_METHOD("get_full_snapshots_sent"),
+                       &PlayerReplicator::get_full_snapshots_sent);
+  ClassDB::bind_method(D_METHOD("get_delta_snapshots_sent"),
+                       &PlayerReplicator::get_delta_snapshots_sent);
+  ClassDB::bind_method(D_METHOD("get_snapshot_send_failures"),
+                       &PlayerReplicator::get_snapshot_send_failures);
+  ClassDB::bind_method(D_METHOD("get_last_interest_usec"),
+                       &PlayerReplicator::get_last_interest_usec);
+  ClassDB::bind_method(D_METHOD("get_interest_pair_count"),
+                       &PlayerReplicator::get_interest_pair_count);
+  ClassDB::bind_method(D_METHOD("get_last_hit_check_usec"),
+                       &PlayerReplicator::get_last_hit_check_usec);
+  ClassDB::bind_method(D_METHOD("get_last_rewind_ticks"),
+                       &PlayerReplicator::get_last_rewind_ticks);
+  ClassDB::bind_method(D_METHOD("get_hit_check_count"),
+                       &PlayerReplicator::get_hit_check_count);
+
+  ClassDB::bind_method(D_METHOD("get_tick_phase_usec"),
+                       &PlayerReplicator::get_tick_phase_usec);
+
+  ClassDB::bind_method(D_METHOD("server_on_peer_left", "p_peer_id"),
+                       &PlayerReplicator::server_on_peer_left);
+
+  BIND_PROPERTY(PlayerReplicator, Variant::NODE_PATH, "players_path",
+                players_path);
+  BIND_PROPERTY(PlayerReplicator, Variant::INT, "snapshot_interval_ticks",
+                snapshot_interval_ticks);
+  BIND_PROPERTY(PlayerReplicator, Variant::BOOL, "interest_enabled",
+                interest_enabled);
+  BIND_PROPERTY(PlayerReplicator, Variant::FLOAT, "interest_enter_radius",
+                interest_enter_radius);
+  BIND_PROPERTY(PlayerReplicator, Variant::FLOAT, "interest_leave_radius",
+                interest_leave_radius);
+  BIND_PROPERTY(PlayerReplicator, Variant::BOOL, "lag_compensation_enabled",
+                lag_compensation_enabled);
+  BIND_PROPERTY(PlayerReplicator, Variant::FLOAT, "hit_reach", hit_reach);
+  BIND_PROPERTY(PlayerReplicator, Variant::BOOL, "batched_simulation",
+                batched_simulation);
+  BIND_PROPERTY(PlayerReplicator, Variant::BOOL, "parallel_tick",
+                parallel_tick);
+  BIND_PROPERTY(PlayerReplicator, Variant::INT, "peers_per_task",
+                peers_per_task);
+
+  ADD_SIGNAL(MethodInfo("player_hit",
+                        PropertyInfo(Variant::INT, "attacker_id"),
+                        PropertyInfo(Variant::INT, "victim_id"),
+                        PropertyInfo(Variant::VECTOR3, "position")));
+  ADD_SIGNAL(MethodInfo("terrain_hit",
+                        PropertyInfo(Variant::INT, "attacker_id"),
+                        PropertyInfo(Variant::VECTOR3, "position"),
+                        PropertyInfo(Variant::VECTOR3, "normal")));
+}
+
+} // namespace morphic
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "net/interest_manager.h"
+#include "net/net_messages.h"
+#include "net/player_snapshot.h"
+#include "player/player.h"
+#include "server_player_sim.h"
+
+#include <godot_cpp/classes/node.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+using namespace godot;
+
+namespace morphic {
+
+class NetworkManager;
+
+// Server-side driver for server-authoritative player movement. Every physics
+// tick it moves all client-owned players from their queued inputs, batched
+// through ServerPlayerSim (or one PlayerMovement per node with
+// `batched_simulation` off); every `snapshot_interval_ticks` it sends each
+// ready peer a quantized snapshot delta-encoded against the last one that
+// peer acked.
+// On clients it decodes snapshots and hands the states to the players.
+//
+// Snapshots and spawns are culled per peer by an InterestManager: a peer
+// only gets players near its own, and far players are despawned on it
+// through MultiplayerSynchronizer visibility.
+//
+// A server tick runs in ordered phases: ingest (inputs off the queues),
+// simulate (movement, transform history, swings), and on snapshot ticks
+// interest, encode and send. Interest queries and per-peer encoding only
+// touch their own peer's state, so with `parallel_tick` they fan out over
+// the WorkerThreadPool in chunks of `peers_per_task` peers, each chunk with
+// its own scratch buffers. Everything that touches the scene tree or the
+// multiplayer peer stays on the main thread.
+//
+// Swings (a primary press with an item that has a primary action) are
+// lag compensated: every player's transform is recorded per tick, and the
+// hit ray is tested against the other players' capsules at the tick the
+// attacker was looking at (PlayerRewind) and against the present terrain.
+class PlayerReplicator : public Node {
+  GDCLASS(PlayerReplicator, Node)
+
+protected:
+  static void _bind_methods();
+
+public:
+  void _ready() override;
+  void _exit_tree() override;
+  void _physics_process(double delta) override;
+
+  NodePath get_players_path() const;
+  void set_players_path(NodePath p_path);
+  int get_snapshot_interval_ticks() const;
+  void set_snapshot_interval_ticks(int p_ticks);
+  bool get_interest_enabled() const;
+  void set_interest_enabled(bool p_enabled);
+  float get_interest_enter_radius() const;
+  void set_interest_enter_radius(float p_radius);
+  float get_interest_leave_radius() const;
+  void set_interest_leave_radius(float p_radius);
+  bool get_lag_compensation_enabled() const;
+  void set_lag_compensation_enabled(bool p_enabled);
+  float get_hit_reach() const;
+  void set_hit_reach(float p_reach);
+  bool get_batched_simulation() const;
+  void set_batched_simulation(bool p_enabled);
+  bool get_parallel_tick() const;
+  void set_parallel_tick(bool p_enabled);
+  int get_peers_per_task() const;
+  void set_peers_per_task(int p_peers);
+
+  int get_last_simulation_usec() const;
+  int get_simulated_player_count() const;
+  float get_simulation_usec_per_player() const;
+  // Players (all, host included) dormant / awake after the last tick.
+  int get_dormant_player_count() const;
+  int get_active_player_count() const;
+  int get_last_snapshot_bytes() const;
+  int64_t get_snapshot_bytes_sent() const;
+  int64_t get_full_snapshots_sent() const;
+  int64_t get_delta_snapshots_sent() const;
+  // Snapshots that failed to encode or send.
+  int64_t get_snapshot_send_failures() const;
+  int get_last_interest_usec() const;
+  int get_interest_pair_count() const;
+  int get_last_hit_check_usec() const;
+  int get_last_rewind_ticks() const;
+  int64_t get_hit_check_count() const;
+  // Microseconds per phase of the last tick (ingest, simulate, interest,
+  // encode, send) and the task count of the last fan-out.
+  Dictionary get_tick_phase_usec() const;
+
+private:
+  struct PeerSnapshotState {
+    PlayerSnapshotHistory history;
+    uint32_t acked_sequence = 0;
+  };
+
+  enum TickPhase {
+    PHASE_INGEST,
+    PHASE_SIMULATE,
+    PHASE_INTEREST,
+    PHASE_ENCODE,
+    PHASE_SEND,
+    PHASE_MAX,
+  };
+
+  // One ready peer's share of a snapshot tick. Tasks write only to their
+  // own jobs; the main thread fills them in and sends from them.
+  struct PeerTickJob {
+    int peer_id = 0;
+    bool has_viewer = false;
+    Vector3 position;
+    uint32_t ack_tick = 0;
+    uint8_t input_fill = 0;
+    PeerSnapshotState *state = nullptr;
+    std::vector<int32_t> entered;
+    std::vector<int32_t> left;
+    PlayerSnapshot snapshot;
+    PackedByteArray bytes;
+    bool delta = false;
+  };
+
+  struct TaskScratch {
+    std::vector<int32_t> relevant;
+  };
+
+  NodePath _players_path;
+  Node *_players_root = nullptr;
+  int _snapshot_interval_ticks = 2;
+
+  uint32_t _server_tick = 0;
+  uint32_t _snapshot_sequence = 0;
+  std::unordered_map<int, PeerSnapshotState> _peer_snapshots;
+
+  InterestManager _interest;
+  std::vector<InterestManager::Entity> _interest_entities;
+
+  bool _parallel_tick = true;
+  int _peers_per_task = 8;
+  std::vector<Player *> _simulated_players;
+  PlayerSnapshot _world_snapshot;
+  std::unordered_map<int, Player *> _snapshot_players;
+  // Grown on demand, never shrunk: the buffers inside are reused per tick.
+  std::vector<PeerTickJob> _peer_jobs;
+  int _peer_job_count = 0;
+  std::vector<TaskScratch> _task_scratch;
+  int _task_count = 1;
+  int _last_task_count = 0;
+  uint64_t _phase_usec[PHASE_MAX] = {};
+
+  PlayerSnapshotHistory _client_history;
+  uint32_t _client_latest_sequence = 0;
+
+  bool _batched_simulation = true;
+  ServerPlayerSim _sim;
+  uint64_t _last_simulation_usec = 0;
+  int _simulated_player_count = 0;
+  int _dormant_player_count = 0;
+  int _active_player_count = 0;
+  int _last_snapshot_bytes = 0;
+  int64_t _snapshot_bytes_sent = 0;
+  int64_t _full_snapshots_sent = 0;
+  int64_t _delta_snapshots_sent = 0;
+  int64_t _snapshot_send_failures = 0;
+  uint64_t _last_interest_usec = 0;
+
+  bool _lag_compensation_enabled = true;
+  float _hit_reach = 3.0f;
+  uint64_t _last_hit_check_usec = 0;
+  uint32_t _last_rewind_ticks = 0;
+  int64_t _hit_check_count = 0;
+
+  void bind_messages();
+  void unbind_messages();
+  Player *find_player(int p_peer_id) const;
+  void server_bind_to_network();
+  void server_tick(double delta);
+  void server_send_snapshots();
+  void server_prepare_peer_jobs(NetworkManager *net_manager);
+  // Runs p_task(i) for i in [0, _task_count): on this thread alone, or as
+  // a WorkerThreadPool group; each task handles one chunk of _peer_jobs.
+  using PeerTask = void (PlayerReplicator::*)(uint32_t);
+  void run_peer_tasks(PeerTask p_task);
+  void server_interest_task(uint32_t p_task);
+  void server_encode_task(uint32_t p_task);
+  void server_resolve_swings();
+  void server_check_swing(Player *attacker, uint32_t view_tick);
+  void server_on_peer_left(int p_peer_id);
+  void server_on_input(int p_sender_id, const PlayerInputMessage &message);
+  void server_on_snapshot_ack(int p_sender_id,
+                              const SnapshotAckMessage &message);
+  void server_apply_visibility(const PeerTickJob &job);
+
+  void client_apply_snapshot(const PlayerSnapshot &snapshot);
+
+  void client_on_snapshot(const PlayerSnapshotMessage &message);
+};
+
+} // namespace morphic
@@ -0,0 +1,151 @@
+#include "player_rewind.h"
+#include "player/player.h"
+
+#include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/physics_server3d.hpp>
+#include <godot_cpp/core/math.hpp>
+
+#include <algorithm>
+
+using namespace godot;
+
+namespace morphic {
+
+namespace {
+// First entry of the ray `from + t * dir` (t in [0, 1]) into a sphere.
+bool ray_sphere(const Vector3 &from, const Vector3 &dir, const Vector3 &center,
+                float radius, float &r_t) {
+  const Vector3 m = from - center;
+  const float a = dir.dot(dir);
+  const float b = m.dot(dir);
+  const float c = m.dot(m) - radius * radius;
+  const float disc = b * b - a * c;
+  if (a <= CMP_EPSILON || disc < 0.0f) {
+    return false;
+  }
+  const float t = (-b - Math::sqrt(disc)) / a;
+  if (t < 0.0f || t > 1.0f) {
+    return false;
+  }
+  r_t = t;
+  return true;
+}
+
+// Same for a capsule along Y, centred at the origin. A ray starting inside
+// hits at t = 0.
+bool ray_capsule(const Vector3 &from, const Vector3 &dir, float radius,
+                 float half_segment, float &r_t, Vector3 &r_normal) {
+  const float inside_y = Math::clamp(from.y, -half_segment, half_segment);
+  if (from.distance_squared_to(Vector3(0.0f, inside_y, 0.0f)) <=
+      radius * radius) {
+    r_t = 0.0f;
+    r_normal = -dir.normalized();
+    return true;
+  }
+
+  bool found = false;
+  float best = 2.0f;
+  // Side: infinite cylinder, limited to the segment.
+  const float a = dir.x * dir.x + dir.z * dir.z;
+  if (a > CMP_EPSILON) {
+    const float b = from.x * dir.x + from.z * dir.z;
+    const float c = from.x * from.x + from.z * from.z - radius * radius;
+    const float disc = b * b - a * c;
+    if (disc >= 0.0f) {
+      const float t = (-b - Math::sqrt(disc)) / a;
+      const Vector3 point = from + dir * t;
+      if (t >= 0.0f && t <= 1.0f && Math::abs(point.y) <= half_segment) {
+        best = t;
+        r_normal = Vector3(point.x, 0.0f, point.z) / radius;
+        found = true;
+      }
+    }
+  }
+  // Caps.
+  for (float sign : {-1.0f, 1.0f}) {
+    const Vector3 center(0.0f, sign * half_segment, 0.0f);
+    float t = 0.0f;
+    if (ray_sphere(from, dir, center, radius, t) && t < best) {
+      best = t;
+      r_normal = (from + dir * t - center) / radius;
+      found = true;
+    }
+  }
+  r_t = best;
+  return found;
+}
+} // namespace
+
+PlayerRewind::PlayerRewind(Node *players_root, const Player *shooter,
+                           uint32_t view_tick, uint32_t current_tick) {
+  const uint32_t max_ticks = static_cast<uint32_t>(
+      Engine::get_singleton()->get_physics_ticks_per_second() *
+      k_max_rewind_s);
+  const uint32_t oldest =
+      current_tick > max_ticks ? current_tick - max_ticks : 0;
+  _tick = std::clamp(view_tick, oldest, current_tick);
+
+  if (!players_root) {
+    return;
+  }
+
+  PhysicsServer3D *physics = PhysicsServer3D::get_singleton();
+  _capsules.reserve(players_root->get_child_count());
+  for (int i = 0; i < players_root->get_child_count(); i++) {
+    Player *player = Object::cast_to<Player>(players_root->get_child(i));
+    if (!player) {
+      continue;
+    }
+    const RID body = player->get_rid();
+    _bodies.push_back(body);
+    if (player == shooter) {
+      continue;
+    }
+
+    Transform3D pose = player->get_global_transform();
+    if (_tick != current_tick &&
+        player->get_transform_history().get(_tick, pose)) {
+      _rewound++;
+    }
+    for (int s = 0; s < physics->body_get_shape_count(body); s++) {
+      const RID shape = physics->body_get_shape(body, s);
+      if (physics->body_is_shape_disabled(body, s) ||
+          physics->shape_get_type(shape) != PhysicsServer3D::SHAPE_CAPSULE) {
+        continue;
+      }
+      const Dictionary data = physics->shape_get_data(shape);
+      Capsule &capsule = _capsules.emplace_back();
+      capsule.player = player;
+      capsule.transform = pose * physics->body_get_shape_transform(body, s);
+      capsule.radius = data["radius"];
+      const float height = data["height"];
+      capsule.half_segment = Math::max(height * 0.5f - capsule.radius, 0.0f);
+    }
+  }
+}
+
+bool PlayerRewind::intersect_ray(const Vector3 &from, const Vector3 &to,
+                                 Hit &r_hit) const {
+  const Vector3 dir = to - from;
+  float best = 2.0f;
+  for (const Capsule &capsule : _capsules) {
+    const Transform3D inverse = capsule.transform.affine_inverse();
+    const Vector3 local_from = inverse.xform(from);
+    const Vector3 local_dir = inverse.basis.xform(dir);
+    float t = 0.0f;
+    Vector3 normal;
+    if (!ray_capsule(local_from, local_dir, capsule.radius,
+                     capsule.half_segment, t, normal) ||
+        t >= best) {
+      continue;
+    }
+    best = t;
+    r_hit.player = capsule.player;
+    r_hit.position = from + dir * t;
+    r_hit.normal = capsule.transform.basis.xform(normal).normalized();
+    r_hit.distance = dir.length() * t;
+  }
+  return best <= 1.0f;
+}
+
+} // namespace morphic
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <godot_cpp/classes/node.hpp>
+#include <godot_cpp/variant/rid.hpp>
+#include <godot_cpp/variant/transform3d.hpp>
+#include <godot_cpp/variant/typed_array.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace godot;
+
+namespace morphic {
+
+class Player;
+
+// Lag compensation for one swing: every player under the root (except the
+// shooter) is taken as it stood on a past server tick, from its
+// PlayerTransformHistory, and rays are tested against its capsule shapes
+// at that pose. Nothing is moved on the physics server: players are
+// kinematic bodies, whose transforms only take effect on the next physics
+// step, so a query right after posing them would still see the present.
+// World queries should exclude get_player_bodies() and be compared with
+// intersect_ray() by distance.
+class PlayerRewind {
+public:
+  static constexpr double k_max_rewind_s = 0.5;
+
+  struct Hit {
+    Player *player = nullptr;
+    Vector3 position;
+    Vector3 normal;
+    float distance = 0.0f;
+  };
+
+  // `view_tick` is clamped to k_max_rewind_s behind `current_tick`. Players
+  // without history for it are tested where they are now.
+  PlayerRewind(Node *players_root, const Player *shooter, uint32_t view_tick,
+               uint32_t current_tick);
+
+  // Nearest player capsule along `from` -> `to`.
+  bool intersect_ray(const Vector3 &from, const Vector3 &to,
+                     Hit &r_hit) const;
+  // Every player body, the shooter's included.
+  const TypedArray<RID> &get_player_bodies() const { return _bodies; }
+
+  uint32_t get_tick() const { return _tick; }
+  int get_rewound_count() const { return _rewound; }
+
+private:
+  // A capsule shape of a player, posed in world space; its axis is local Y.
+  struct Capsule {
+    Player *player = nullptr;
+    Transform3D transform;
+    float radius = 0.0f;
+    float half_segment = 0.0f;
+  };
+
+  std::vector<Capsule> _capsules;
+  TypedArray<RID> _bodies;
+  int _rewound = 0;
+  uint32_t _tick = 0;
+};
+
+} // namespace morphic
@@ -3,6 +3,9 @@
 #include "utils/network_utils.h"
 
 #include "godot_cpp/classes/engine.hpp"
+#include "godot_cpp/classes/time.hpp"
+
+#include <vector>
 
 using namespace godot;
 
@@ -22,6 +25,24 @@ void PlayerSpawner::_ready() {
     return;
 
   server_bind_spawner_to_network();
+  set_process(true);
+}
+
+void PlayerSpawner::_process(double) {
+  if (_lingers.empty()) {
+    return;
+  }
+  const uint64_t now = Time::get_singleton()->get_ticks_usec();
+  std::vector<uint64_t> expired;
+  for (const auto &entry : _lingers) {
+    if (now >= entry.second.expires_usec) {
+      expired.push_back(entry.first);
+    }
+  }
+  for (uint64_t identity : expired) {
+    server_end_linger(identity);
+    _linger_expired++;
+  }
 }
 
 //////// SERVER ////////////////
@@ -58,7 +79,16 @@ void PlayerSpawner::server_spawn_player(int p_peer_id) {
     return;
   }
 
-  Vector3 spawn_pos = calc_spawn_position();
+  // A client back within the linger period continues where it left, in
+  // the region its lingering viewer kept loaded.
+  NetworkManager *net_manager = NetUtils::get_net_manager(this);
+  const uint64_t identity =
+      net_manager ? net_manager->get_peer_identity(p_peer_id) : 0;
+  auto linger = identity != 0 ? _lingers.find(identity) : _lingers.end();
+  const bool returning = linger != _lingers.end();
+
+  Vector3 spawn_pos =
+      returning ? linger->second.transform.origin : calc_spawn_position();
   Dictionary data;
   data["peer_id"] = p_peer_id;
   data["spawn_pos"] = spawn_pos;
@@ -67,6 +97,11 @@ void PlayerSpawner::server_spawn_player(int p_peer_id) {
   if (spawned) {
     LOG("Spawned player %d at: %s", p_peer_id, spawn_pos);
   }
+  if (returning) {
+    // The new player's own viewer holds the region from here on.
+    server_end_linger(identity);
+    _linger_hits++;
+  }
 }
 
 void PlayerSpawner::server_despawn_player(int p_peer_id) {
@@ -76,6 +111,12 @@ void PlayerSpawner::server_despawn_player(int p_peer_id) {
   Player *existing_player = find_player(p_peer_id);
 
   if (existing_player) {
+    NetworkManager *net_manager = NetUtils::get_net_manager(this);
+    const uint64_t identity =
+        net_manager ? net_manager->get_peer_identity(p_peer_id) : 0;
+    if (identity != 0 && _viewer_linger_time > 0.0f) {
+      server_start_linger(existing_player, identity);
+    }
     existing_player->queue_free();
     LOG("Player %d removed", p_peer_id);
     return;
@@ -84,6 +125,88 @@ void PlayerSpawner::server_despawn_player(int p_peer_id) {
   LOG("Player %d not found. Cant remove", p_peer_id);
 }
 
+void PlayerSpawner::server_start_linger(Player *player, uint64_t identity) {
+  VoxelViewer *own =
+      Object::cast_to<VoxelViewer>(player->get_node_or_null("TerrainViewer"));
+  Node3D *parent = Object::cast_to<Node3D>(_players_root->get_parent());
+  if (!own || !parent) {
+    return;
+  }
+  server_end_linger(identity);
+
+  // Collisions too, so the returning player does not wait for colliders,
+  // but only within the collision radius the peer negotiated: the same
+  // split as PlayerTerrainViewer, with the collision viewer as a child.
+  VoxelViewer *viewer = memnew(VoxelViewer);
+  viewer->set_name("LingerViewer");
+  viewer->set_view_distance(own->get_view_distance());
+  viewer->set_requires_visuals(false);
+  viewer->set_requires_collisions(own->is_requiring_collisions());
+  VoxelViewer *own_collision = Object::cast_to<VoxelViewer>(
+      player->get_node_or_null("TerrainCollisionViewer"));
+  if (own_collision) {
+    VoxelViewer *collision = memnew(VoxelViewer);
+    collision->set_name("LingerCollisionViewer");
+    collision->set_view_distance(own_collision->get_view_distance());
+    collision->set_requires_visuals(false);
+    collision->set_requires_collisions(true);
+    viewer->add_child(collision);
+  }
+  parent->add_child(viewer);
+  viewer->set_global_transform(player->get_global_transform());
+
+  const int64_t blocks_across = own->get_view_distance() * 2 / 16 + 1;
+  Linger linger;
+  linger.viewer = viewer->get_instance_id();
+  linger.transform = player->get_global_transform();
+  linger.expires_usec =
+      Time::get_singleton()->get_ticks_usec() +
+      static_cast<uint64_t>(_viewer_linger_time * 1000000.0f);
+  linger.bytes =
+      blocks_across * blocks_across * blocks_across * k_block_bytes_estimate;
+  _lingers[identity] = linger;
+  _linger_bytes += linger.bytes;
+  server_evict_lingers_to_budget();
+}
+
+void PlayerSpawner::server_end_linger(uint64_t identity) {
+  auto it = _lingers.find(identity);
+  if (it == _lingers.end()) {
+    return;
+  }
+  Object *viewer = ObjectDB::get_instance(it->second.viewer);
+  if (viewer) {
+    Object::cast_to<Node>(viewer)->queue_free();
+  }
+  _linger_bytes -= it->second.bytes;
+  _lingers.erase(it);
+}
+
+void PlayerSpawner::server_evict_lingers_to_budget() {
+  // Oldest first: the ones closest to expiring anyway.
+  while (_linger_bytes > _linger_budget && !_lingers.empty()) {
+    auto oldest = _lingers.begin();
+    for (auto it = _lingers.begin(); it != _lingers.end(); ++it) {
+      if (it->second.expires_usec < oldest->second.expires_usec) {
+        oldest = it;
+      }
+    }
+    server_end_linger(oldest->first);
+    _linger_evicted++;
+  }
+}
+
+Dictionary PlayerSpawner::get_linger_stats() const {
+  Dictionary stats;
+  stats["lingering"] = static_cast<int>(_lingers.size());
+  stats["estimated_bytes"] = _linger_bytes;
+  stats["budget_bytes"] = _linger_budget;
+  stats["hits"] = _linger_hits;
+  stats["expired"] = _linger_expired;
+  stats["evicted"] = _linger_evicted;
+  return stats;
+}
+
 ////////////////////////////
 
 Node *PlayerSpawner::create_player(const Variant &p_data) {
@@ -94,7 +217,13 @@ Node *PlayerSpawner::create_player(const Variant &p_data) {
   int peer_id = data.get("peer_id", 1);
   Vector3 spawn_pos = data.get("spawn_pos", Vector3());
 
-  Node *player_instance = _player_scene_prefab->instantiate();
+  NetworkManager *net_manager = NetUtils::get_net_manager(this);
+  const bool dedicated = net_manager && net_manager->is_dedicated();
+  const Ref<PackedScene> &scene =
+      dedicated && _server_player_scene_prefab.is_valid()
+          ? _server_player_scene_prefab
+          : _player_scene_prefab;
+  Node *player_instance = scene->instantiate();
   Player *player = cast_to<Player>(player_instance);
   if (!player) {
     ERR_PRINT_ONCE("Failed casting to type of Player!");
@@ -107,6 +236,14 @@ Node *PlayerSpawner::create_player(const Variant &p_data) {
   player->set_name(String::num(peer_id));
   player->set_position(spawn_pos);
 
+  // Our own player arriving completes the join on the client.
+  if (!NetUtils::is_server(this) &&
+      peer_id == NetUtils::get_mp(this)->get_unique_id()) {
+    if (net_manager) {
+      net_manager->notify_local_player_spawned();
+    }
+  }
+
   return player;
 }
 
@@ -136,6 +273,30 @@ Ref<PackedScene> PlayerSpawner::get_player_scene() const {
   return _player_scene_prefab;
 }
 
+void PlayerSpawner::set_server_player_scene(const Ref<PackedScene> &p_scene) {
+  _server_player_scene_prefab = p_scene;
+}
+
+Ref<PackedScene> PlayerSpawner::get_server_player_scene() const {
+  return _server_player_scene_prefab;
+}
+
+float PlayerSpawner::get_viewer_linger_time() const {
+  return _viewer_linger_time;
+}
+void PlayerSpawner::set_viewer_linger_time(float p_seconds) {
+  _viewer_linger_time = Math::max(p_seconds, 0.0f);
+}
+
+int PlayerSpawner::get_linger_budget_mb() const {
+  return static_cast<int>(_linger_budget / (1024 * 1024));
+}
+void PlayerSpawner::set_linger_budget_mb(int p_budget_mb) {
+  _linger_budget =
+      static_cast<int64_t>(Math::max(p_budget_mb, 0)) * 1024 * 1024;
+  server_evict_lingers_to_budget();
+}
+
 void PlayerSpawner::_bind_methods() {
   ClassDB::bind_method(D_METHOD("create_player", "data"),
                        &PlayerSpawner::create_player);
@@ -146,8 +307,17 @@ void PlayerSpawner::_bind_methods() {
   ClassDB::bind_method(D_METHOD("server_despawn_player", "p_peer_id"),
                        &PlayerSpawner::server_despawn_player);
 
+  ClassDB::bind_method(D_METHOD("get_linger_stats"),
+                       &PlayerSpawner::get_linger_stats);
+
   BIND_PROPERTY_HINT(PlayerSpawner, Variant::OBJECT, "player_scene",
                      player_scene, PROPERTY_HINT_RESOURCE_TYPE);
+  BIND_PROPERTY_HINT(PlayerSpawner, Variant::OBJECT, "server_player_scene",
+                     server_player_scene, PROPERTY_HINT_RESOURCE_TYPE);
+  BIND_PROPERTY(PlayerSpawner, Variant::FLOAT, "viewer_linger_time",
+                viewer_linger_time);
+  BIND_PROPERTY(PlayerSpawner, Variant::INT, "linger_budget_mb",
+                linger_budget_mb);
 }
 
 } // namespace morphic
@@ -4,6 +4,10 @@
 
 #include "godot_cpp/classes/multiplayer_spawner.hpp"
 #include "godot_cpp/classes/packed_scene.hpp"
+#include "godot_cpp/classes/voxel_viewer.hpp"
+
+#include <cstdint>
+#include <unordered_map>
 
 using namespace godot;
 
@@ -17,19 +21,57 @@ protected:
 
 public:
   void _ready() override;
+  void _process(double delta) override;
 
   Ref<PackedScene> get_player_scene() const;
   void set_player_scene(const Ref<PackedScene> &p_scene);
+  Ref<PackedScene> get_server_player_scene() const;
+  void set_server_player_scene(const Ref<PackedScene> &p_scene);
+  float get_viewer_linger_time() const;
+  void set_viewer_linger_time(float p_seconds);
+  int get_linger_budget_mb() const;
+  void set_linger_budget_mb(int p_budget_mb);
+
+  Dictionary get_linger_stats() const;
 
 private:
+  // Rough cost of one loaded data block (16^3 voxels, SDF + overhead), to
+  // turn a viewer's radius into bytes for the linger budget.
+  static constexpr int64_t k_block_bytes_estimate = 12 * 1024;
+
+  // A disconnected player's region, kept loaded by a detached viewer in
+  // case the same client comes back.
+  struct Linger {
+    ObjectID viewer;
+    Transform3D transform;
+    uint64_t expires_usec = 0;
+    int64_t bytes = 0;
+  };
+
   Node *_players_root = nullptr;
   Ref<PackedScene> _player_scene_prefab;
+  // Used instead on a dedicated server: the player without animation,
+  // meshes or hand sockets. Clients always use _player_scene_prefab.
+  Ref<PackedScene> _server_player_scene_prefab;
+
+  float _viewer_linger_time = 30.0f;
+  int64_t _linger_budget = 256 * 1024 * 1024;
+  // By client identity (NetworkManager::get_peer_identity).
+  std::unordered_map<uint64_t, Linger> _lingers;
+  int64_t _linger_bytes = 0;
+  int64_t _linger_hits = 0;
+  int64_t _linger_expired = 0;
+  int64_t _linger_evicted = 0;
 
   // server
 
   void server_bind_spawner_to_network();
   void server_spawn_player(int p_peer_id);
   void server_despawn_player(int p_peer_id);
+  void server_start_linger(Player *player, uint64_t identity);
+  // Frees the viewer; the region unloads unless someone else holds it.
+  void server_end_linger(uint64_t identity);
+  void server_evict_lingers_to_budget();
 
   Node *create_player(const Variant &p_data);
   Vector3 calc_spawn_position();
@@ -0,0 +1,256 @@
+#include "server_player_sim.h"
+
+#include <godot_cpp/classes/physics_server3d.hpp>
+#include <godot_cpp/core/math.hpp>
+
+#include <algorithm>
+
+namespace morphic {
+
+namespace {
+const Vector3 k_up(0, 1, 0);
+// Same limit PlayerMovement::apply_pitch clamps the head to.
+const float k_max_pitch = Math::deg_to_rad(89.0f);
+} // namespace
+
+void ServerPlayerSim::begin_tick() {
+  std::fill(_gathered.begin(), _gathered.end(), 0);
+  std::fill(_input_counts.begin(), _input_counts.end(), 0);
+  std::fill(_jumped.begin(), _jumped.end(), 0);
+  std::fill(_woken.begin(), _woken.end(), 0);
+}
+
+void ServerPlayerSim::gather(Player *player) {
+  auto it = _slot_by_peer.find(player->get_peer_id());
+  int slot = it != _slot_by_peer.end() ? it->second : add_slot(player);
+  if (_bodies[slot] != player->get_rid()) {
+    // Respawned under the same peer id: start over from the new node.
+    remove_slot(slot);
+    slot = add_slot(player);
+  }
+
+  _gathered[slot] = 1;
+  // Cheap to refresh, and keeps tuning edits on the node effective.
+  _params[slot] = PlayerMotionParams::from(*player);
+  _sensitivities[slot] = player->get_sensitivity();
+
+  PlayerInputState inputs[Player::k_max_inputs_per_tick];
+  const int count = player->server_take_inputs(inputs);
+  bool idle = true;
+  for (int i = 0; i < count; i++) {
+    _inputs[slot][i] = inputs[i];
+    idle = idle && PlayerDormancy::is_idle_input(inputs[i]);
+  }
+  _input_counts[slot] = static_cast<uint8_t>(count);
+  _idle[slot] = idle ? 1 : 0;
+  if (!idle) {
+    player->wake_dormant();
+  }
+  _dormant[slot] = player->is_dormant() ? 1 : 0;
+}
+
+void ServerPlayerSim::step(double delta) {
+  for (int slot = get_size() - 1; slot >= 0; slot--) {
+    if (!_gathered[slot]) {
+      remove_slot(slot);
+    }
+  }
+
+  PhysicsServer3D *physics = PhysicsServer3D::get_singleton();
+  const int size = get_size();
+  _dormant_count = static_cast<int>(
+      std::count(_dormant.begin(), _dormant.end(), uint8_t(1)));
+  // Input-major: every player's first input, then the catch-up inputs, so
+  // a player running two inputs does not get ahead of the others.
+  for (int pass = 0; pass < Player::k_max_inputs_per_tick; pass++) {
+    for (int slot = 0; slot < size; slot++) {
+      if (pass >= _input_counts[slot] || _dormant[slot]) {
+        continue;
+      }
+      const PlayerInputState &input = _inputs[slot][pass];
+      bool on_floor = _on_floor[slot] != 0;
+
+      bool jumped = false;
+      _velocities[slot] = PlayerKinematics::integrate_velocity(
+          _velocities[slot], on_floor, _yaws[slot], input, _params[slot],
+          delta, jumped);
+      _jumped[slot] |= jumped ? 1 : 0;
+      _sprinting[slot] = input.is_sprinting ? 1 : 0;
+
+      Transform3D transform(Basis(k_up, _yaws[slot]), _positions[slot]);
+      _kinematics.slide(_bodies[slot], transform, _velocities[slot],
+                        on_floor, delta);
+      _positions[slot] = transform.origin;
+      _on_floor[slot] = on_floor ? 1 : 0;
+
+      // PlayerMovement::apply_yaw / apply_pitch.
+      _yaws[slot] = Math::wrapf(
+          _yaws[slot] - input.look.x * _sensitivities[slot], -Math_PI,
+          Math_PI);
+      _pitches[slot] =
+          Math::clamp(_pitches[slot] - input.look.y * _sensitivities[slot],
+                      -k_max_pitch, k_max_pitch);
+
+      // Players are kinematic bodies: the new pose takes effect on the next
+      // physics step, so everyone in this pass collides with the others'
+      // poses from the previous tick, whatever the slot order.
+      transform.basis = Basis(k_up, _yaws[slot]);
+      physics->body_set_state(_bodies[slot],
+                              PhysicsServer3D::BODY_STATE_TRANSFORM, transform);
+
+      if (_dormant_count > 0) {
+        wake_contacts();
+      }
+    }
+  }
+}
+
+void ServerPlayerSim::mirror() {
+  const int size = get_size();
+  for (int slot = 0; slot < size; slot++) {
+    Player *player = _players[slot];
+    if (_woken[slot]) {
+      player->wake_dormant();
+    }
+    if (_input_counts[slot] == 0) {
+      continue; // starved: the node already shows the held state
+    }
+    if (_dormant[slot]) {
+      continue;
+    }
+    player->set_position(_positions[slot]);
+    Vector3 rotation = player->get_rotation();
+    rotation.y = _yaws[slot];
+    player->set_rotation(rotation);
+    player->set_velocity(_velocities[slot]);
+    player->set_grounded(_on_floor[slot] != 0);
+    player->set_movement_ref_speed(_sprinting[slot] ? _params[slot].sprint_speed
+                                                    : _params[slot].speed);
+    if (Node3D *head = player->get_head_node()) {
+      Vector3 head_rotation = head->get_rotation();
+      head_rotation.x = _pitches[slot];
+      head->set_rotation(head_rotation);
+    }
+    if (_jumped[slot]) {
+      player->notify_jump();
+    }
+    player->update_dormancy(_idle[slot] != 0);
+  }
+}
+
+void ServerPlayerSim::wake_contacts() {
+  for (uint64_t id : _kinematics.get_contacts()) {
+    auto it = _slot_by_instance.find(id);
+    if (it == _slot_by_instance.end() || !_dormant[it->second]) {
+      continue;
+    }
+    // Its inputs this tick are idle, so stepping them or not is the same.
+    _dormant[it->second] = 0;
+    _woken[it->second] = 1;
+    _dormant_count--;
+  }
+}
+
+void ServerPlayerSim::clear() {
+  _slot_by_peer.clear();
+  _slot_by_instance.clear();
+  _peer_ids.clear();
+  _instance_ids.clear();
+  _players.clear();
+  _bodies.clear();
+  _positions.clear();
+  _velocities.clear();
+  _yaws.clear();
+  _pitches.clear();
+  _on_floor.clear();
+  _params.clear();
+  _sensitivities.clear();
+  _inputs.clear();
+  _input_counts.clear();
+  _jumped.clear();
+  _sprinting.clear();
+  _gathered.clear();
+  _idle.clear();
+  _dormant.clear();
+  _woken.clear();
+  _dormant_count = 0;
+}
+
+int ServerPlayerSim::add_slot(Player *player) {
+  const int slot = get_size();
+  Node3D *head = player->get_head_node();
+
+  _slot_by_peer[player->get_peer_id()] = slot;
+  _slot_by_instance[player->get_instance_id()] = slot;
+  _peer_ids.push_back(player->get_peer_id());
+  _instance_ids.push_back(player->get_instance_id());
+  _players.push_back(player);
+  _bodies.push_back(player->get_rid());
+  _positions.push_back(player->get_position());
+  _velocities.push_back(player->get_velocity());
+  _yaws.push_back(player->get_rotation().y);
+  _pitches.push_back(head ? head->get_rotation().x : 0.0f);
+  _on_floor.push_back(player->is_grounded() ? 1 : 0);
+  _params.push_back(PlayerMotionParams::from(*player));
+  _sensitivities.push_back(player->get_sensitivity());
+  _inputs.push_back(Inputs());
+  _input_counts.push_back(0);
+  _jumped.push_back(0);
+  _sprinting.push_back(0);
+  _gathered.push_back(0);
+  _idle.push_back(0);
+  _dormant.push_back(0);
+  _woken.push_back(0);
+  return slot;
+}
+
+void ServerPlayerSim::remove_slot(int slot) {
+  // Swap-remove keeps the arrays dense.
+  const int last = get_size() - 1;
+  _slot_by_peer.erase(_peer_ids[slot]);
+  _slot_by_instance.erase(_instance_ids[slot]);
+  if (slot != last) {
+    _slot_by_peer[_peer_ids[last]] = slot;
+    _slot_by_instance[_instance_ids[last]] = slot;
+    _instance_ids[slot] = _instance_ids[last];
+    _peer_ids[slot] = _peer_ids[last];
+    _players[slot] = _players[last];
+    _bodies[slot] = _bodies[last];
+    _positions[slot] = _positions[last];
+    _velocities[slot] = _velocities[last];
+    _yaws[slot] = _yaws[last];
+    _pitches[slot] = _pitches[last];
+    _on_floor[slot] = _on_floor[last];
+    _params[slot] = _params[last];
+    _sensitivities[slot] = _sensitivities[last];
+    _inputs[slot] = _inputs[last];
+    _input_counts[slot] = _input_counts[last];
+    _jumped[slot] = _jumped[last];
+    _sprinting[slot] = _sprinting[last];
+    _gathered[slot] = _gathered[last];
+    _idle[slot] = _idle[last];
+    _dormant[slot] = _dormant[last];
+    _woken[slot] = _woken[last];
+  }
+  _peer_ids.pop_back();
+  _players.pop_back();
+  _bodies.pop_back();
+  _positions.pop_back();
+  _velocities.pop_back();
+  _yaws.pop_back();
+  _pitches.pop_back();
+  _on_floor.pop_back();
+  _params.pop_back();
+  _sensitivities.pop_back();
+  _inputs.pop_back();
+  _input_counts.pop_back();
+  _jumped.pop_back();
+  _sprinting.pop_back();
+  _gathered.pop_back();
+  _idle.pop_back();
+  _dormant.pop_back();
+  _woken.pop_back();
+  _instance_ids.pop_back();
+}
+
+} // namespace morphic
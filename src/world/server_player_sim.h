@@ -0,0 +1,82 @@
+#pragma once
+
+#include "player/player.h"
+#include "player/player_kinematics.h"
+
+#include <godot_cpp/variant/rid.hpp>
+#include <godot_cpp/variant/vector3.hpp>
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using namespace godot;
+
+namespace morphic {
+
+// Batched server-side movement for client-owned players. Movement state
+// lives here as structure-of-arrays, one slot per player, and each tick
+// steps every slot in one tight loop straight against the players' body
+// RIDs through PhysicsServer3D (PlayerKinematics). The Player nodes only
+// mirror the result afterwards, for snapshots, rewind and animation.
+//
+// The sim owns the movement state of a simulated player: once a slot
+// exists, its position, yaw, pitch and velocity are not read back from the
+// node. Slots are created from the node on first sight and dropped on the
+// first tick the player is not gathered.
+//
+// Dormant players (PlayerDormancy) keep their slot but are skipped by
+// step() and mirror(); an active player sliding into one wakes it.
+//
+// Per tick: begin_tick(), gather() for each simulated player, step(),
+// mirror().
+class ServerPlayerSim {
+public:
+  void begin_tick();
+  // Takes this tick's inputs from the player (applying its non-movement
+  // actions) into the player's slot.
+  void gather(Player *player);
+  void step(double delta);
+  void mirror();
+  void clear();
+
+  int get_size() const { return static_cast<int>(_players.size()); }
+  // Slots that were dormant in the last step().
+  int get_dormant_count() const { return _dormant_count; }
+
+private:
+  using Inputs = std::array<PlayerInputState, Player::k_max_inputs_per_tick>;
+
+  std::unordered_map<int, int> _slot_by_peer;
+  // Body instance id -> slot, to find the dormant players contacts hit.
+  std::unordered_map<uint64_t, int> _slot_by_instance;
+  std::vector<int> _peer_ids;
+  std::vector<uint64_t> _instance_ids;
+  std::vector<Player *> _players;
+  std::vector<RID> _bodies;
+  std::vector<Vector3> _positions;
+  std::vector<Vector3> _velocities;
+  std::vector<float> _yaws;
+  std::vector<float> _pitches;
+  std::vector<uint8_t> _on_floor;
+  std::vector<PlayerMotionParams> _params;
+  std::vector<float> _sensitivities;
+  std::vector<Inputs> _inputs;
+  std::vector<uint8_t> _input_counts;
+  std::vector<uint8_t> _jumped;
+  std::vector<uint8_t> _sprinting;
+  std::vector<uint8_t> _gathered;
+  std::vector<uint8_t> _idle;
+  std::vector<uint8_t> _dormant;
+  std::vector<uint8_t> _woken;
+  int _dormant_count = 0;
+
+  PlayerKinematics _kinematics;
+
+  int add_slot(Player *player);
+  void remove_slot(int slot);
+  void wake_contacts();
+};
+
+} // namespace morphic
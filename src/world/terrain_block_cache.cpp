@@ -0,0 +1,114 @@
+#include "terrain_block_cache.h"
+
+#include "utils/debug_utils.h"
+
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+
+namespace morphic {
+
+namespace {
+constexpr const char *k_cache_dir = "user://terrain_cache";
+constexpr uint32_t k_cache_magic = 0x43544D4D; // "MMTC"
+// 2 added the codec per entry, 3 the terrain dictionary version.
+constexpr uint32_t k_cache_format_version = 3;
+} // namespace
+
+String TerrainBlockCache::make_path(uint64_t world_id_hash, int seed) {
+  return String(k_cache_dir)
+      .path_join(String::num_uint64(world_id_hash, 16) + "_" +
+                 String::num_int64(seed) + ".bin");
+}
+
+bool TerrainBlockCache::load(const String &path) {
+  clear();
+  if (!FileAccess::file_exists(path)) {
+    return false;
+  }
+  Ref<FileAccess> file = FileAccess::open(path, FileAccess::READ);
+  ERR_FAIL_COND_V_MSG(file.is_null(), false,
+                      "TerrainBlockCache: cant open cache file");
+  if (file->get_32() != k_cache_magic ||
+      file->get_32() != k_cache_format_version) {
+    WARN_PRINT("TerrainBlockCache: unknown cache format, ignoring it");
+    return false;
+  }
+
+  // GENERATOR_DELTA entries only decode against the generator output they
+  // were taken from.
+  if (file->get_16() != k_terrain_dictionary_version) {
+    WARN_PRINT("TerrainBlockCache: built for another terrain generator, "
+               "ignoring it");
+    return false;
+  }
+
+  _log_id = file->get_64();
+  const uint32_t count = file->get_32();
+  for (uint32_t i = 0; i < count; i++) {
+    const int64_t key = static_cast<int64_t>(file->get_64());
+    Entry entry;
+    entry.version = file->get_32();
+    const uint8_t codec = file->get_8();
+    entry.codec = static_cast<TerrainCodec>(codec);
+    const uint32_t size = file->get_32();
+    entry.voxels = file->get_buffer(size);
+    if (codec >= static_cast<uint8_t>(TerrainCodec::COUNT)) {
+      WARN_PRINT("TerrainBlockCache: unknown block codec, ignoring the cache");
+      clear();
+      return false;
+    }
+    if (file->eof_reached() || entry.voxels.size() != size) {
+      WARN_PRINT("TerrainBlockCache: truncated cache file, ignoring it");
+      clear();
+      return false;
+    }
+    _entries[key] = entry;
+  }
+  _dirty = false;
+  return true;
+}
+
+bool TerrainBlockCache::save(const String &path) {
+  Ref<DirAccess> dir = DirAccess::open("user://");
+  ERR_FAIL_COND_V_MSG(dir.is_null(), false,
+                      "TerrainBlockCache: Cannot open user://");
+  const String rel = path.get_base_dir().trim_prefix("user://");
+  if (!dir->dir_exists(rel)) {
+    dir->make_dir_recursive(rel);
+  }
+
+  Ref<FileAccess> file = FileAccess::open(path, FileAccess::WRITE);
+  ERR_FAIL_COND_V_MSG(file.is_null(), false,
+                      "TerrainBlockCache: cant write cache file");
+  file->store_32(k_cache_magic);
+  file->store_32(k_cache_format_version);
+  file->store_16(k_terrain_dictionary_version);
+  file->store_64(_log_id);
+  file->store_32(static_cast<uint32_t>(_entries.size()));
+  for (const auto &entry : _entries) {
+    file->store_64(static_cast<uint64_t>(entry.first));
+    file->store_32(entry.second.version);
+    file->store_8(static_cast<uint8_t>(entry.second.codec));
+    file->store_32(static_cast<uint32_t>(entry.second.voxels.size()));
+    file->store_buffer(entry.second.voxels);
+  }
+  _dirty = false;
+  return true;
+}
+
+void TerrainBlockCache::put(int64_t key, uint32_t version, TerrainCodec codec,
+                            const PackedByteArray &voxels) {
+  Entry &entry = _entries[key];
+  entry.version = version;
+  entry.codec = codec;
+  entry.voxels = voxels;
+  _dirty = true;
+}
+
+void TerrainBlockCache::clear() {
+  _entries.clear();
+  _log_id = 0;
+  _dirty = false;
+}
+
+} // namespace morphic
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "net/net_messages.h"
+
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+
+using namespace godot;
+
+namespace morphic {
+
+// Client-side on-disk copy of the edited terrain blocks a server sent, one
+// file per world id and seed. Entries carry the server's edit version, and
+// the file records which server edit log (log id) those versions belong
+// to; a cache built against another log is worthless and gets dropped.
+// So is one written with another k_terrain_dictionary_version, whose
+// GENERATOR_DELTA entries would decode into garbage.
+class TerrainBlockCache {
+public:
+  struct Entry {
+    uint32_t version = 0;
+    TerrainCodec codec = TerrainCodec::VOXEL;
+    PackedByteArray voxels;
+  };
+
+  static String make_path(uint64_t world_id_hash, int seed);
+
+  // Replaces the contents; false (and empty) when missing or unreadable.
+  bool load(const String &path);
+  bool save(const String &path);
+
+  void put(int64_t key, uint32_t version, TerrainCodec codec,
+           const PackedByteArray &voxels);
+  void clear();
+
+  uint64_t get_log_id() const { return _log_id; }
+  void set_log_id(uint64_t log_id) { _log_id = log_id; }
+  bool is_dirty() const { return _dirty; }
+  int get_block_count() const { return static_cast<int>(_entries.size()); }
+  const std::unordered_map<int64_t, Entry> &get_entries() const {
+    return _entries;
+  }
+
+private:
+  std::unordered_map<int64_t, Entry> _entries;
+  uint64_t _log_id = 0;
+  bool _dirty = false;
+};
+
+} // namespace morphic
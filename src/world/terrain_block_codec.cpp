@@ -0,0 +1,115 @@
+#include "terrain_block_codec.h"
+
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/stream_peer_buffer.hpp>
+#include <godot_cpp/classes/voxel_block_serializer.hpp>
+
+#include <algorithm>
+
+namespace morphic {
+
+namespace {
+constexpr int k_size_header_bytes = 4;
+// Sanity bound for the size header; a serialized block is far smaller.
+constexpr uint32_t k_max_raw_size = 16 * 1024 * 1024;
+} // namespace
+
+PackedByteArray TerrainBlockCodec::encode(TerrainCodec codec,
+                                          const Ref<VoxelBuffer> &voxels,
+                                          const Ref<VoxelGenerator> &generator,
+                                          const Vector3i &origin,
+                                          TerrainCodec &r_codec) {
+  if (codec != TerrainCodec::GENERATOR_DELTA || generator.is_null()) {
+    r_codec = TerrainCodec::VOXEL;
+    return serialize(voxels, true);
+  }
+
+  PackedByteArray raw = serialize(voxels, false);
+  const uint32_t raw_size = static_cast<uint32_t>(raw.size());
+  xor_into(raw, generate_reference(generator, origin, voxels->get_size().x));
+  const PackedByteArray compressed = raw.compress(FileAccess::COMPRESSION_ZSTD);
+
+  PackedByteArray payload;
+  payload.resize(k_size_header_bytes + compressed.size());
+  payload.encode_u32(0, raw_size);
+  memcpy(payload.ptrw() + k_size_header_bytes, compressed.ptr(),
+         static_cast<size_t>(compressed.size()));
+  r_codec = TerrainCodec::GENERATOR_DELTA;
+  return payload;
+}
+
+Ref<VoxelBuffer> TerrainBlockCodec::decode(TerrainCodec codec,
+                                           const PackedByteArray &payload,
+                                           const Ref<VoxelGenerator> &generator,
+                                           const Vector3i &origin,
+                                           int block_size) {
+  switch (codec) {
+  case TerrainCodec::VOXEL:
+    return deserialize(payload, true);
+  case TerrainCodec::GENERATOR_DELTA:
+    break;
+  default:
+    ERR_FAIL_V_MSG(Ref<VoxelBuffer>(), "TerrainBlockCodec: unknown codec");
+  }
+
+  ERR_FAIL_COND_V_MSG(generator.is_null(), Ref<VoxelBuffer>(),
+                      "TerrainBlockCodec: delta block without a generator");
+  ERR_FAIL_COND_V_MSG(payload.size() < k_size_header_bytes, Ref<VoxelBuffer>(),
+                      "TerrainBlockCodec: truncated delta block");
+  const uint32_t raw_size = static_cast<uint32_t>(payload.decode_u32(0));
+  ERR_FAIL_COND_V_MSG(raw_size == 0 || raw_size > k_max_raw_size,
+                      Ref<VoxelBuffer>(),
+                      "TerrainBlockCodec: bad delta block size");
+
+  PackedByteArray raw =
+      payload.slice(k_size_header_bytes)
+          .decompress(raw_size, FileAccess::COMPRESSION_ZSTD);
+  ERR_FAIL_COND_V_MSG(raw.size() != raw_size, Ref<VoxelBuffer>(),
+                      "TerrainBlockCodec: delta block failed to decompress");
+  xor_into(raw, generate_reference(generator, origin, block_size));
+  return deserialize(raw, false);
+}
+
+PackedByteArray TerrainBlockCodec::serialize(const Ref<VoxelBuffer> &voxels,
+                                             bool compress) {
+  Ref<StreamPeerBuffer> peer;
+  peer.instantiate();
+  VoxelBlockSerializer::serialize_to_stream_peer(peer, voxels, compress);
+  return peer->get_data_array();
+}
+
+Ref<VoxelBuffer> TerrainBlockCodec::deserialize(const PackedByteArray &bytes,
+                                                bool compressed) {
+  Ref<StreamPeerBuffer> peer;
+  peer.instantiate();
+  peer->set_data_array(bytes);
+  Ref<VoxelBuffer> voxels;
+  voxels.instantiate();
+  VoxelBlockSerializer::deserialize_from_stream_peer(
+      peer, voxels, static_cast<int>(bytes.size()), compressed);
+  return voxels;
+}
+
+PackedByteArray TerrainBlockCodec::generate_reference(
+    const Ref<VoxelGenerator> &generator, const Vector3i &origin,
+    int block_size) {
+  Ref<VoxelBuffer> reference;
+  reference.instantiate();
+  reference->create(block_size, block_size, block_size);
+  generator->generate_block(reference, origin, 0);
+  return serialize(reference, false);
+}
+
+void TerrainBlockCodec::xor_into(PackedByteArray &bytes,
+                                 const PackedByteArray &reference) {
+  // Sizes differ when a channel is uniform on one side only; the tail
+  // then goes through as is.
+  const int64_t count = std::min(bytes.size(), reference.size());
+  uint8_t *dst = bytes.ptrw();
+  const uint8_t *src = reference.ptr();
+  for (int64_t i = 0; i < count; i++) {
+    dst[i] ^= src[i];
+  }
+}
+
+} // namespace morphic
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "net/net_messages.h"
+
+#include <godot_cpp/classes/voxel_buffer.hpp>
+#include <godot_cpp/classes/voxel_generator.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/vector3i.hpp>
+
+using namespace godot;
+
+namespace morphic {
+
+// Wire encoding of terrain data blocks.
+//
+// GENERATOR_DELTA uses the seeded generator as a per-block dictionary:
+// both sides can produce the unedited block, so only the XOR of the
+// serialized edited and generated blocks is compressed (zstd). Outside the
+// edit the XOR is zero, which leaves little for zstd to spend bytes on
+// even for small blocks, where a generic compressor has no history to
+// learn from. Payload: u32 raw size, then the zstd stream.
+class TerrainBlockCodec {
+public:
+  // Encodes the block at voxel `origin`. GENERATOR_DELTA without a
+  // generator falls back to VOXEL; `r_codec` is what was used.
+  static PackedByteArray encode(TerrainCodec codec,
+                                const Ref<VoxelBuffer> &voxels,
+                                const Ref<VoxelGenerator> &generator,
+                                const Vector3i &origin, TerrainCodec &r_codec);
+  // Null when the payload is malformed or the generator is missing.
+  static Ref<VoxelBuffer> decode(TerrainCodec codec,
+                                 const PackedByteArray &payload,
+                                 const Ref<VoxelGenerator> &generator,
+                                 const Vector3i &origin, int block_size);
+
+  // VoxelBlockSerializer output, optionally with its own compression.
+  static PackedByteArray serialize(const Ref<VoxelBuffer> &voxels,
+                                   bool compress);
+  static Ref<VoxelBuffer> deserialize(const PackedByteArray &bytes,
+                                      bool compressed);
+
+private:
+  static PackedByteArray generate_reference(
+      const Ref<VoxelGenerator> &generator, const Vector3i &origin,
+      int block_size);
+  static void xor_into(PackedByteArray &bytes,
+                       const PackedByteArray &reference);
+};
+
+} // namespace morphic
@@ -0,0 +1,128 @@
+#include "terrain_edit_log.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace morphic {
+
+namespace {
+
+constexpr int k_axis_bits = 21;
+constexpr int64_t k_axis_mask = (int64_t(1) << k_axis_bits) - 1;
+
+int floor_div(int value, int divisor) {
+  return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+int64_t sign_extend(int64_t value) {
+  const int64_t sign = int64_t(1) << (k_axis_bits - 1);
+  return (value ^ sign) - sign;
+}
+
+} // namespace
+
+int64_t TerrainEditLog::pack(const Vector3i &block) {
+  return ((int64_t(block.x) & k_axis_mask) << (2 * k_axis_bits)) |
+         ((int64_t(block.y) & k_axis_mask) << k_axis_bits) |
+         (int64_t(block.z) & k_axis_mask);
+}
+
+Vector3i TerrainEditLog::unpack(int64_t key) {
+  return Vector3i(
+      static_cast<int32_t>(sign_extend((key >> (2 * k_axis_bits)) &
+                                       k_axis_mask)),
+      static_cast<int32_t>(sign_extend((key >> k_axis_bits) & k_axis_mask)),
+      static_cast<int32_t>(sign_extend(key & k_axis_mask)));
+}
+
+void TerrainEditLog::mark_area(const Vector3i &min_voxel,
+                               const Vector3i &max_voxel, int block_size,
+                               std::vector<int64_t> *r_keys) {
+  if (block_size <= 0) {
+    return;
+  }
+  const uint32_t version = ++_latest_version;
+  for (int z = floor_div(min_voxel.z, block_size);
+       z <= floor_div(max_voxel.z, block_size); z++) {
+    for (int y = floor_div(min_voxel.y, block_size);
+         y <= floor_div(max_voxel.y, block_size); y++) {
+      for (int x = floor_div(min_voxel.x, block_size);
+           x <= floor_div(max_voxel.x, block_size); x++) {
+        const int64_t key = pack(Vector3i(x, y, z));
+        _blocks[key] = version;
+        if (r_keys) {
+          r_keys->push_back(key);
+        }
+      }
+    }
+  }
+}
+
+void TerrainEditLog::mark_block(const Vector3i &block, uint32_t version) {
+  if (version == 0) {
+    version = ++_latest_version;
+  }
+  _latest_version = std::max(_latest_version, version);
+  _blocks[pack(block)] = version;
+}
+
+void TerrainEditLog::collect_pending(int peer_id, const Vector3i &center,
+                                     int radius, int max_count,
+                                     std::vector<Block> &r_blocks) {
+  r_blocks.clear();
+  const std::unordered_map<int64_t, uint32_t> &sent = _sent[peer_id];
+
+  for (const auto &entry : _blocks) {
+    const Vector3i block = unpack(entry.first);
+    const Vector3i offset = block - center;
+    if (std::abs(offset.x) > radius || std::abs(offset.y) > radius ||
+        std::abs(offset.z) > radius) {
+      continue;
+    }
+    auto it = sent.find(entry.first);
+    if (it != sent.end() && it->second == entry.second) {
+      continue;
+    }
+    r_blocks.push_back(Block{block, entry.second});
+  }
+
+  auto distance = [&center](const Block &block) {
+    const Vector3i d = block.position - center;
+    return d.x * d.x + d.y * d.y + d.z * d.z;
+  };
+  if (static_cast<int>(r_blocks.size()) > max_count) {
+    std::partial_sort(r_blocks.begin(), r_blocks.begin() + max_count,
+                      r_blocks.end(), [&](const Block &a, const Block &b) {
+                        return distance(a) < distance(b);
+                      });
+    r_blocks.resize(max_count);
+  } else {
+    std::sort(r_blocks.begin(), r_blocks.end(),
+              [&](const Block &a, const Block &b) {
+                return distance(a) < distance(b);
+              });
+  }
+}
+
+void TerrainEditLog::mark_sent(int peer_id, const Block &block) {
+  _sent[peer_id][pack(block.position)] = block.version;
+}
+
+void TerrainEditLog::forget_peer(int peer_id) { _sent.erase(peer_id); }
+
+bool TerrainEditLog::is_modified(const Vector3i &block) const {
+  return _blocks.find(pack(block)) != _blocks.end();
+}
+
+uint32_t TerrainEditLog::get_version(const Vector3i &block) const {
+  auto it = _blocks.find(pack(block));
+  return it != _blocks.end() ? it->second : 0;
+}
+
+void TerrainEditLog::clear() {
+  _blocks.clear();
+  _sent.clear();
+  _latest_version = 0;
+}
+
+} // namespace morphic
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <godot_cpp/variant/vector3i.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using namespace godot;
+
+namespace morphic {
+
+// Server-side set of terrain data blocks that differ from what the seeded
+// generator produces. Clients generate everything else themselves, so
+// these are the only blocks that ever cross the wire. Every edit bumps the
+// block's version; per peer the log remembers which version was sent, so a
+// block goes out once and again only after it changes.
+class TerrainEditLog {
+public:
+  struct Block {
+    Vector3i position;
+    uint32_t version = 0;
+  };
+
+  // Marks every block overlapping the voxel box [min, max] as modified,
+  // appending their keys to `r_keys` when given.
+  void mark_area(const Vector3i &min_voxel, const Vector3i &max_voxel,
+                 int block_size, std::vector<int64_t> *r_keys = nullptr);
+  void mark_block(const Vector3i &block, uint32_t version = 0);
+
+  // Up to `max_count` modified blocks within `radius` blocks (Chebyshev)
+  // of `center` that `peer_id` has not received at their current version,
+  // nearest first. Call mark_sent() for the ones actually delivered.
+  void collect_pending(int peer_id, const Vector3i &center, int radius,
+                       int max_count, std::vector<Block> &r_blocks);
+  void mark_sent(int peer_id, const Block &block);
+  void forget_peer(int peer_id);
+
+  bool is_modified(const Vector3i &block) const;
+  uint32_t get_version(const Vector3i &block) const;
+  int get_modified_count() const { return static_cast<int>(_blocks.size()); }
+  uint32_t get_latest_version() const { return _latest_version; }
+  // Identifies this log's version sequence; a fresh log gets a new id, so
+  // client caches built against an older one are recognised as stale.
+  uint64_t get_log_id() const { return _log_id; }
+  void set_log_id(uint64_t log_id) { _log_id = log_id; }
+  const std::unordered_map<int64_t, uint32_t> &get_blocks() const {
+    return _blocks;
+  }
+  void clear();
+
+  static int64_t pack(const Vector3i &block);
+  static Vector3i unpack(int64_t key);
+
+private:
+  std::unordered_map<int64_t, uint32_t> _blocks;
+  std::unordered_map<int, std::unordered_map<int64_t, uint32_t>> _sent;
+  uint32_t _latest_version = 0;
+  uint64_t _log_id = 0;
+};
+
+} // namespace morphic
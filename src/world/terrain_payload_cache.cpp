@@ -0,0 +1,88 @@
+#include "terrain_payload_cache.h"
+
+namespace morphic {
+
+const PackedByteArray *TerrainPayloadCache::get(int64_t key,
+                                                uint32_t version,
+                                                TerrainCodec codec,
+                                                TerrainCodec &r_encoded) {
+  auto it = _entries.find(SlotKey{key, codec});
+  if (it == _entries.end()) {
+    _misses++;
+    return nullptr;
+  }
+  if (it->second.version != version) {
+    erase(it);
+    _misses++;
+    return nullptr;
+  }
+  _lru.splice(_lru.begin(), _lru, it->second.lru);
+  _hits++;
+  _bytes_saved += it->second.payload.size();
+  r_encoded = it->second.encoded;
+  return &it->second.payload;
+}
+
+void TerrainPayloadCache::put(int64_t key, uint32_t version,
+                              TerrainCodec codec, TerrainCodec encoded,
+                              const PackedByteArray &payload) {
+  // Larger than the whole budget: would only flush everything else.
+  const SlotKey slot{key, codec};
+  if (payload.size() > _budget) {
+    auto it = _entries.find(slot);
+    if (it != _entries.end()) {
+      erase(it);
+    }
+    return;
+  }
+  auto it = _entries.find(slot);
+  if (it == _entries.end()) {
+    _lru.push_front(slot);
+    it = _entries.emplace(slot, Entry()).first;
+    it->second.lru = _lru.begin();
+  } else {
+    _used -= it->second.payload.size();
+    _lru.splice(_lru.begin(), _lru, it->second.lru);
+  }
+  it->second.version = version;
+  it->second.encoded = encoded;
+  it->second.payload = payload;
+  _used += payload.size();
+  evict_to_budget();
+}
+
+void TerrainPayloadCache::invalidate(int64_t key) {
+  for (int codec = 0; codec < static_cast<int>(TerrainCodec::COUNT);
+       codec++) {
+    auto it = _entries.find(SlotKey{key, static_cast<TerrainCodec>(codec)});
+    if (it != _entries.end()) {
+      erase(it);
+    }
+  }
+}
+
+void TerrainPayloadCache::clear() {
+  _entries.clear();
+  _lru.clear();
+  _used = 0;
+}
+
+void TerrainPayloadCache::set_budget_bytes(int64_t budget) {
+  _budget = budget > 0 ? budget : 0;
+  evict_to_budget();
+}
+
+void TerrainPayloadCache::erase(EntryMap::iterator it) {
+  _used -= it->second.payload.size();
+  _lru.erase(it->second.lru);
+  _entries.erase(it);
+}
+
+void TerrainPayloadCache::evict_to_budget() {
+  while (_used > _budget && !_lru.empty()) {
+    erase(_entries.find(_lru.back()));
+    _evictions++;
+  }
+}
+
+} // namespace morphic
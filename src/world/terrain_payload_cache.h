@@ -0,0 +1,84 @@
+#pragma once
+
+#include "net/net_messages.h"
+
+#include <godot_cpp/variant/packed_byte_array.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+using namespace godot;
+
+namespace morphic {
+
+// Server-side cache of serialized (compressed) terrain block payloads,
+// one entry per TerrainEditLog block key and codec, tagged with the block
+// version, so a block needed by several peers is copied and compressed
+// once per codec. PackedByteArray is
+// copy-on-write: every peer's message shares the cached bytes. Bounded by
+// a byte budget, least recently used first out.
+class TerrainPayloadCache {
+public:
+  // Null when missing or cached at another version (such an entry is
+  // dropped on the spot). `codec` is the one asked for; `r_encoded` is the
+  // one the payload is in, as an encoder may fall back to another.
+  const PackedByteArray *get(int64_t key, uint32_t version,
+                             TerrainCodec codec, TerrainCodec &r_encoded);
+  void put(int64_t key, uint32_t version, TerrainCodec codec,
+           TerrainCodec encoded, const PackedByteArray &payload);
+  // Every codec's entry for the block.
+  void invalidate(int64_t key);
+  void clear();
+
+  void set_budget_bytes(int64_t budget);
+  int64_t get_budget_bytes() const { return _budget; }
+  int64_t get_used_bytes() const { return _used; }
+  int get_entry_count() const { return static_cast<int>(_entries.size()); }
+
+  int64_t get_hits() const { return _hits; }
+  int64_t get_misses() const { return _misses; }
+  int64_t get_evictions() const { return _evictions; }
+  // Payload bytes served from the cache instead of being encoded again.
+  int64_t get_bytes_saved() const { return _bytes_saved; }
+
+private:
+  struct SlotKey {
+    int64_t block = 0;
+    TerrainCodec codec = TerrainCodec::VOXEL;
+
+    bool operator==(const SlotKey &other) const {
+      return block == other.block && codec == other.codec;
+    }
+  };
+  struct SlotKeyHash {
+    size_t operator()(const SlotKey &key) const {
+      return std::hash<int64_t>()(key.block) * 31 +
+             static_cast<size_t>(key.codec);
+    }
+  };
+  struct Entry {
+    uint32_t version = 0;
+    TerrainCodec encoded = TerrainCodec::VOXEL;
+    PackedByteArray payload;
+    std::list<SlotKey>::iterator lru;
+  };
+  using EntryMap = std::unordered_map<SlotKey, Entry, SlotKeyHash>;
+
+  EntryMap _entries;
+  // Most recently used at the front.
+  std::list<SlotKey> _lru;
+  int64_t _budget = 32 * 1024 * 1024;
+  int64_t _used = 0;
+
+  int64_t _hits = 0;
+  int64_t _misses = 0;
+  int64_t _evictions = 0;
+  int64_t _bytes_saved = 0;
+
+  void erase(EntryMap::iterator it);
+  void evict_to_budget();
+};
+
+} // namespace morphic
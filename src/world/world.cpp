@@ -1,4 +1,6 @@
 #include "world.h"
+#include "core/network_manager.h"
+#include "player/player.h"
 #include "utils/bind_methods.h"
 #include "utils/debug_utils.h"
 #include "utils/network_utils.h"
@@ -7,14 +9,34 @@
 #include "godot_cpp/classes/voxel_stream_sq_lite.hpp"
 #include <godot_cpp/classes/display_server.hpp>
 #include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/file_access.hpp>
 #include <godot_cpp/classes/multiplayer_api.hpp>
 #include <godot_cpp/classes/scene_tree.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/classes/voxel_buffer.hpp>
 #include <godot_cpp/classes/voxel_stream.hpp>
+#include <godot_cpp/core/math.hpp>
 
 using namespace godot;
 
 namespace morphic {
 
+namespace {
+// VoxelBuffer channel mask covering every channel.
+constexpr int k_all_channels_mask = 0xFF;
+constexpr uint32_t k_edits_magic = 0x4C44454D; // "MEDL"
+// 2 added the log id.
+constexpr uint32_t k_edits_format_version = 2;
+// How far around an edit dormant players are woken, in meters.
+constexpr float k_dormancy_wake_margin = 2.0f;
+
+uint64_t make_edit_log_id() {
+  Time *time = Time::get_singleton();
+  return (static_cast<uint64_t>(time->get_unix_time_from_system()) << 20) ^
+         time->get_ticks_usec();
+}
+} // namespace
+
 void World::_enter_tree() {
   connect_terrain_node();
   _terrain->connect("mesh_block_entered",
@@ -22,8 +44,64 @@ void World::_enter_tree() {
 }
 
 void World::_ready() {
+  if (Engine::get_singleton()->is_editor_hint()) {
+    set_physics_process(false);
+    return;
+  }
+
+  _players_root = get_node_or_null(_players_path);
+  set_voxel_tool();
+  bind_messages();
+
   if (NetUtils::is_server(this)) {
-    set_voxel_tool();
+    NetworkManager *net = NetUtils::get_net_manager(this);
+    if (net) {
+      net->connect("player_left", Callable(this, "_on_peer_left"));
+    }
+  }
+  set_physics_process(true);
+}
+
+void World::_exit_tree() {
+  if (Engine::get_singleton()->is_editor_hint()) {
+    return;
+  }
+  unbind_messages();
+  if (_edits_dirty) {
+    server_save_edits();
+  }
+  if (_cache_validated && _cache.is_dirty()) {
+    _cache.save(_cache_path);
+  }
+}
+
+void World::_physics_process(double delta) {
+  if (NetUtils::is_server(this)) {
+    _edit_sync_left -= static_cast<float>(delta);
+    if (_edit_sync_left <= 0.0f) {
+      _edit_sync_left = k_edit_sync_interval_s;
+      server_sync_edits();
+    }
+    _edit_save_left -= static_cast<float>(delta);
+    if (_edit_save_left <= 0.0f) {
+      _edit_save_left = k_edit_save_interval_s;
+      if (_edits_dirty) {
+        server_save_edits();
+      }
+    }
+  } else {
+    if (_client_unapplied > 0) {
+      // Blocks that arrived before their area was loaded.
+      client_apply_pending();
+    }
+    // Written now and then too, so a crash keeps most of what we got.
+    _cache_save_left -= static_cast<float>(delta);
+    if (_cache_save_left <= 0.0f) {
+      _cache_save_left = k_cache_save_interval_s;
+      if (_cache_validated && _cache.is_dirty()) {
+        _cache.save(_cache_path);
+      }
+    }
   }
 }
 
@@ -39,18 +117,589 @@ void World::setup_server(Dictionary p_save_info) {
   Ref<VoxelStreamSQLite> stream = memnew(VoxelStreamSQLite);
   stream->set_database_path(p_save_info["terrain_db_path"]);
   _terrain->set_stream(stream);
+
+  _edits_path = p_save_info.get("terrain_edits_path", "");
+  server_load_edits();
+
+  // Nothing is rendered on a dedicated server.
+  NetworkManager *net = NetUtils::get_net_manager(this);
+  if (net && net->is_dedicated()) {
+    Node *environment = get_node_or_null("WorldEnvironment");
+    if (environment) {
+      environment->queue_free();
+    }
+  }
 }
 
 void World::setup_client(Dictionary p_save_info) {
   ERR_FAIL_COND_MSG(!_terrain, "Cant setup client. _terrain is nullptr");
 
+  // The seed is only known once the handshake ran; until then nothing may
+  // be generated with the graph's default seeds.
+  _client_generator = _terrain->get_generator();
   _terrain->set_generator(Ref<VoxelGenerator>());
   _terrain->set_generate_collisions(true);
   _terrain->set_stream(Ref<VoxelStream>());
+
+  NetworkManager *net = NetUtils::get_net_manager(this);
+  ERR_FAIL_COND_MSG(!net, "Cant setup client. NetworkManager missing");
+  net->connect("session_seed_received", Callable(this, "client_on_seed"));
+  _terrain->connect("block_loaded", Callable(this, "_on_block_loaded"));
+}
+
+void World::edit_sphere(Vector3 p_center, float p_radius, bool p_dig) {
+  ERR_FAIL_COND_MSG(!NetUtils::is_server(this),
+                    "World: terrain edits are server only");
+  ERR_FAIL_COND_MSG(_vt.is_null(), "World: voxel tool missing");
+
+  // Voxel space is the terrain's local space (the terrain node is scaled).
+  const Vector3 center = _terrain->to_local(p_center);
+  const float radius =
+      p_radius / _terrain->get_global_transform().basis.get_scale().x;
+
+  _vt->set_mode(p_dig ? VoxelTool::MODE_REMOVE : VoxelTool::MODE_ADD);
+  _vt->do_sphere(center, radius);
+
+  // One voxel of margin: SDF smoothing touches the voxels around the shape.
+  const float reach = radius + 2.0f;
+  _edited_keys.clear();
+  _edit_log.mark_area(
+      Vector3i(Math::floor(center.x - reach), Math::floor(center.y - reach),
+               Math::floor(center.z - reach)),
+      Vector3i(Math::ceil(center.x + reach), Math::ceil(center.y + reach),
+               Math::ceil(center.z + reach)),
+      _terrain->get_data_block_size(), &_edited_keys);
+  for (int64_t key : _edited_keys) {
+    _payload_cache.invalidate(key);
+  }
+  _edits_dirty = true;
+
+  wake_players_near(
+      AABB(p_center, Vector3()).grow(p_radius + k_dormancy_wake_margin));
+}
+
+//////// SERVER ////////////////
+
+void World::server_sync_edits() {
+  if (!_players_root || _edit_log.get_modified_count() == 0) {
+    return;
+  }
+  NetworkManager *net = NetUtils::get_net_manager(this);
+  if (!net) {
+    return;
+  }
+
+  const int block_size = _terrain->get_data_block_size();
+  const int default_view = static_cast<int>(_terrain->get_max_view_distance());
+  const int my_id = NetUtils::get_mp(this)->get_unique_id();
+
+  for (int i = 0; i < _players_root->get_child_count(); i++) {
+    Player *player = Object::cast_to<Player>(_players_root->get_child(i));
+    if (!player || player->get_peer_id() == my_id ||
+        net->get_peer_queued_bytes(player->get_peer_id()) >
+            k_max_queued_terrain_bytes) {
+      continue;
+    }
+    const Vector3 local = _terrain->to_local(player->get_global_position());
+    const Vector3i center(Math::floor(local.x / block_size),
+                          Math::floor(local.y / block_size),
+                          Math::floor(local.z / block_size));
+
+    // Only as far as the peer loads terrain (see NetworkManager radii).
+    const int view = net->get_peer_view_distance(player->get_peer_id());
+    const int radius =
+        Math::min(view > 0 ? view : default_view, default_view) / block_size +
+        1;
+    _edit_log.collect_pending(player->get_peer_id(), center, radius,
+                              k_edit_blocks_per_sync, _pending_blocks);
+    for (const TerrainEditLog::Block &block : _pending_blocks) {
+      // Nearer blocks first; the send queue ranks them against each other
+      // and behind player state.
+      const Vector3i offset = block.position - center;
+      const int distance =
+          Math::max(Math::abs(offset.x),
+                    Math::max(Math::abs(offset.y), Math::abs(offset.z)));
+      const float priority = 1.0f / static_cast<float>(1 + distance);
+      if (server_send_block(player->get_peer_id(), block, priority)) {
+        _edit_log.mark_sent(player->get_peer_id(), block);
+      }
+    }
+  }
+}
+
+bool World::server_send_block(int p_peer_id,
+                              const TerrainEditLog::Block &block,
+                              float p_priority) {
+  TerrainBlockMessage message;
+  message.x = block.position.x;
+  message.y = block.position.y;
+  message.z = block.position.z;
+  message.version = block.version;
+
+  NetworkManager *net = NetUtils::get_net_manager(this);
+  if (!net) {
+    return false;
+  }
+  const TerrainCodec codec = net->get_peer_terrain_codec(p_peer_id);
+
+  // Peers in the same area want the same blocks; encode each version once.
+  const int64_t key = TerrainEditLog::pack(block.position);
+  if (const PackedByteArray *cached =
+          _payload_cache.get(key, block.version, codec, message.codec)) {
+    message.voxels.bytes = *cached;
+  } else {
+    const int block_size = _terrain->get_data_block_size();
+    const Vector3i origin = block.position * block_size;
+    // Not loaded on the server right now; retried on the next pass.
+    if (!_vt->is_area_editable(AABB(
+            Vector3(origin), Vector3(block_size, block_size, block_size)))) {
+      return false;
+    }
+
+    Ref<VoxelBuffer> buffer;
+    buffer.instantiate();
+    buffer->create(block_size, block_size, block_size);
+    _vt->copy(origin, buffer, k_all_channels_mask);
+
+    message.voxels.bytes = TerrainBlockCodec::encode(
+        codec, buffer, _terrain->get_generator(), origin, message.codec);
+    // Under the codec asked for, fallback or not, so the next peer asking
+    // for it does not encode again.
+    _payload_cache.put(key, block.version, codec, message.codec,
+                       message.voxels.bytes);
+  }
+  ERR_FAIL_COND_V_MSG(
+      message.voxels.bytes.size() > decltype(message.voxels)::k_max_size,
+      false, "World: serialized terrain block too large");
+
+  if (net->queue_message(p_peer_id, message, p_priority) != OK) {
+    return false;
+  }
+  _blocks_sent++;
+  _block_bytes_sent += message.voxels.bytes.size();
+  return true;
+}
+
+void World::server_load_edits() {
+  _edit_log.clear();
+  _edit_log.set_log_id(make_edit_log_id());
+  if (_edits_path.is_empty() || !FileAccess::file_exists(_edits_path)) {
+    _edits_dirty = true;
+    return;
+  }
+  Ref<FileAccess> file = FileAccess::open(_edits_path, FileAccess::READ);
+  ERR_FAIL_COND_MSG(file.is_null(), "World: cant open terrain edits");
+  const uint32_t magic = file->get_32();
+  const uint32_t format = file->get_32();
+  if (magic != k_edits_magic || format == 0 ||
+      format > k_edits_format_version) {
+    ERR_PRINT("World: terrain edits file has an unknown format");
+    return;
+  }
+  if (format >= 2) {
+    _edit_log.set_log_id(file->get_64());
+  } else {
+    _edits_dirty = true;
+  }
+
+  const uint32_t count = file->get_32();
+  for (uint32_t i = 0; i < count && !file->eof_reached(); i++) {
+    const int64_t key = static_cast<int64_t>(file->get_64());
+    const uint32_t version = file->get_32();
+    _edit_log.mark_block(TerrainEditLog::unpack(key), version);
+  }
+  LOG("World: loaded %d modified terrain blocks",
+      _edit_log.get_modified_count());
+}
+
+void World::server_save_edits() {
+  if (_edits_path.is_empty()) {
+    return;
+  }
+  Ref<FileAccess> file = FileAccess::open(_edits_path, FileAccess::WRITE);
+  ERR_FAIL_COND_MSG(file.is_null(), "World: cant write terrain edits");
+  file->store_32(k_edits_magic);
+  file->store_32(k_edits_format_version);
+  file->store_64(_edit_log.get_log_id());
+  file->store_32(static_cast<uint32_t>(_edit_log.get_modified_count()));
+  for (const auto &entry : _edit_log.get_blocks()) {
+    file->store_64(static_cast<uint64_t>(entry.first));
+    file->store_32(entry.second);
+  }
+  _edits_dirty = false;
+}
+
+Dictionary World::benchmark_terrain_codecs(int p_max_blocks) {
+  Dictionary result;
+  ERR_FAIL_COND_V_MSG(!NetUtils::is_server(this) || _vt.is_null(), result,
+                      "World: the codec benchmark runs on the server");
+
+  struct Run {
+    const char *name;
+    TerrainCodec codec;
+    int64_t bytes = 0;
+    uint64_t encode_usec = 0;
+    uint64_t decode_usec = 0;
+  };
+  Run runs[] = {{"voxel", TerrainCodec::VOXEL},
+                {"generator_delta", TerrainCodec::GENERATOR_DELTA}};
+  Run zstd = {"zstd", TerrainCodec::VOXEL};
+
+  Time *time = Time::get_singleton();
+  const Ref<VoxelGenerator> generator = _terrain->get_generator();
+  const int block_size = _terrain->get_data_block_size();
+  int blocks = 0;
+  int64_t raw_bytes = 0;
+
+  for (const auto &entry : _edit_log.get_blocks()) {
+    if (blocks >= p_max_blocks) {
+      break;
+    }
+    const Vector3i origin = TerrainEditLog::unpack(entry.first) * block_size;
+    if (!_vt->is_area_editable(AABB(
+            Vector3(origin), Vector3(block_size, block_size, block_size)))) {
+      continue;
+    }
+    Ref<VoxelBuffer> buffer;
+    buffer.instantiate();
+    buffer->create(block_size, block_size, block_size);
+    _vt->copy(origin, buffer, k_all_channels_mask);
+    const PackedByteArray raw = TerrainBlockCodec::serialize(buffer, false);
+    raw_bytes += raw.size();
+    blocks++;
+
+    for (Run &run : runs) {
+      TerrainCodec used = run.codec;
+      uint64_t start = time->get_ticks_usec();
+      const PackedByteArray payload =
+          TerrainBlockCodec::encode(run.codec, buffer, generator, origin, used);
+      run.encode_usec += time->get_ticks_usec() - start;
+      run.bytes += payload.size();
+      start = time->get_ticks_usec();
+      TerrainBlockCodec::decode(used, payload, generator, origin, block_size);
+      run.decode_usec += time->get_ticks_usec() - start;
+    }
+
+    // Generic compression of the same bytes, without the dictionary.
+    uint64_t start = time->get_ticks_usec();
+    const PackedByteArray compressed =
+        raw.compress(FileAccess::COMPRESSION_ZSTD);
+    zstd.encode_usec += time->get_ticks_usec() - start;
+    zstd.bytes += compressed.size();
+    start = time->get_ticks_usec();
+    compressed.decompress(raw.size(), FileAccess::COMPRESSION_ZSTD);
+    zstd.decode_usec += time->get_ticks_usec() - start;
+  }
+
+  auto mb_per_s = [raw_bytes](uint64_t usec) {
+    return usec > 0 ? static_cast<double>(raw_bytes) / usec : 0.0;
+  };
+  auto report = [&](const Run &run) {
+    Dictionary codec;
+    codec["bytes"] = run.bytes;
+    codec["ratio"] =
+        run.bytes > 0 ? static_cast<double>(raw_bytes) / run.bytes : 0.0;
+    codec["encode_mb_s"] = mb_per_s(run.encode_usec);
+    codec["decode_mb_s"] = mb_per_s(run.decode_usec);
+    result[run.name] = codec;
+  };
+  for (const Run &run : runs) {
+    report(run);
+  }
+  report(zstd);
+  result["blocks"] = blocks;
+  result["raw_bytes"] = raw_bytes;
+  return result;
+}
+
+void World::server_on_manifest(int p_sender_id,
+                               const TerrainManifestMessage &message) {
+  // Blocks the client holds at the current version count as sent. From a
+  // different log the versions mean nothing; the ack tells it to drop them.
+  if (message.log_id == _edit_log.get_log_id()) {
+    const PackedByteArray &bytes = message.entries.bytes;
+    const int count = static_cast<int>(bytes.size()) /
+                      TerrainManifestMessage::k_entry_size;
+    NetReader reader(bytes.ptr(), static_cast<int>(bytes.size()));
+    for (int i = 0; i < count; i++) {
+      int64_t key = 0;
+      uint32_t version = 0;
+      reader.read_le(key);
+      reader.read_le(version);
+      TerrainEditLog::Block block;
+      block.position = TerrainEditLog::unpack(key);
+      block.version = version;
+      if (_edit_log.get_version(block.position) == version) {
+        _edit_log.mark_sent(p_sender_id, block);
+        _manifest_matched[p_sender_id]++;
+      }
+    }
+  }
+  if (!message.last) {
+    return;
+  }
+
+  TerrainManifestAckMessage ack;
+  ack.log_id = _edit_log.get_log_id();
+  ack.matched = _manifest_matched[p_sender_id];
+  _manifest_matched.erase(p_sender_id);
+  _manifest_blocks_matched += ack.matched;
+
+  NetworkManager *net = NetUtils::get_net_manager(this);
+  if (net) {
+    net->send_message(p_sender_id, ack);
+  }
+}
+
+void World::_on_peer_left(int p_peer_id) {
+  _edit_log.forget_peer(p_peer_id);
+  _manifest_matched.erase(p_peer_id);
+}
+
+//////// CLIENT ////////////////
+
+void World::client_on_seed(int p_seed) {
+  ERR_FAIL_COND_MSG(_client_generator.is_null(),
+                    "World: no generator to seed on the client");
+  apply_seed_to_all_graph_noises(_client_generator, p_seed);
+  _terrain->set_generator(_client_generator);
+
+  NetworkManager *net = NetUtils::get_net_manager(this);
+  ERR_FAIL_COND_MSG(!net, "World: NetworkManager missing");
+  _cache_path =
+      TerrainBlockCache::make_path(net->get_session_world_id_hash(), p_seed);
+  _cache.load(_cache_path);
+  _cache_validated = false;
+  client_send_manifest();
+}
+
+void World::client_send_manifest() {
+  NetworkManager *net = NetUtils::get_net_manager(this);
+  ERR_FAIL_COND_MSG(!net, "World: NetworkManager missing");
+
+  const int entry_size = TerrainManifestMessage::k_entry_size;
+  TerrainManifestMessage message;
+  message.log_id = _cache.get_log_id();
+  message.entries.bytes.resize(TerrainManifestMessage::k_max_entries *
+                               entry_size);
+  NetWriter writer(message.entries.bytes.ptrw(),
+                   static_cast<int>(message.entries.bytes.size()));
+  int pending = 0;
+
+  auto flush = [&](bool last) {
+    message.last = last;
+    message.entries.bytes.resize(pending * entry_size);
+    net->send_message(1, message);
+    message.entries.bytes.resize(TerrainManifestMessage::k_max_entries *
+                                 entry_size);
+    writer = NetWriter(message.entries.bytes.ptrw(),
+                       static_cast<int>(message.entries.bytes.size()));
+    pending = 0;
+  };
+
+  for (const auto &entry : _cache.get_entries()) {
+    writer.write_le(entry.first);
+    writer.write_le(entry.second.version);
+    if (++pending == TerrainManifestMessage::k_max_entries) {
+      flush(false);
+    }
+  }
+  // Always end with a `last` message, even an empty one: the ack carries
+  // the log id the cache is saved under.
+  flush(true);
+}
+
+void World::client_on_manifest_ack(const TerrainManifestAckMessage &message) {
+  if (_cache_validated) {
+    return;
+  }
+  _cache_validated = true;
+
+  if (message.log_id != _cache.get_log_id()) {
+    // Built against an older edit log (the server world was reset).
+    _cache.clear();
+    _cache.set_log_id(message.log_id);
+    // Blocks the server sent before the ack are current; keep them.
+    for (const auto &entry : _client_blocks) {
+      const ClientBlock &block = entry.second;
+      _cache.put(entry.first, block.version, block.codec, block.voxels);
+    }
+    return;
+  }
+
+  // The server skips blocks we hold at its version and sends newer ones
+  // itself, so everything cached can go in unless a newer copy came first.
+  for (const auto &entry : _cache.get_entries()) {
+    ClientBlock &block = _client_blocks[entry.first];
+    if (block.version >= entry.second.version) {
+      continue;
+    }
+    if (block.version > 0 && !block.applied) {
+      _client_unapplied--;
+    }
+    block.version = entry.second.version;
+    block.codec = entry.second.codec;
+    block.voxels = entry.second.voxels;
+    block.applied = client_apply_block(entry.first, block);
+    if (!block.applied) {
+      _client_unapplied++;
+    }
+    _cache_hits++;
+  }
+}
+
+void World::client_on_terrain_block(const TerrainBlockMessage &message) {
+  const int64_t key =
+      TerrainEditLog::pack(Vector3i(message.x, message.y, message.z));
+  ClientBlock &block = _client_blocks[key];
+  if (block.version > message.version) {
+    return;
+  }
+  if (block.version > 0 && !block.applied) {
+    _client_unapplied--;
+  }
+  block.version = message.version;
+  block.codec = message.codec;
+  block.voxels = message.voxels.bytes;
+  block.applied = client_apply_block(key, block);
+  if (!block.applied) {
+    _client_unapplied++;
+  }
+  _blocks_received++;
+  _cache.put(key, message.version, message.codec, message.voxels.bytes);
+}
+
+bool World::client_apply_block(int64_t key, ClientBlock &block) {
+  const int block_size = _terrain->get_data_block_size();
+  const Vector3i origin = TerrainEditLog::unpack(key) * block_size;
+  if (_vt.is_null() ||
+      !_vt->is_area_editable(
+          AABB(Vector3(origin), Vector3(block_size, block_size, block_size)))) {
+    return false;
+  }
+
+  Ref<VoxelBuffer> buffer = TerrainBlockCodec::decode(
+      block.codec, block.voxels, _client_generator, origin, block_size);
+  if (buffer.is_null()) {
+    // Undecodable; counted as applied so it is not retried every frame.
+    return true;
+  }
+  _vt->paste(origin, buffer, k_all_channels_mask);
+
+  const AABB area = _terrain->get_global_transform().xform(
+      AABB(Vector3(origin), Vector3(block_size, block_size, block_size)));
+  wake_players_near(area.grow(k_dormancy_wake_margin));
+  return true;
+}
+
+void World::client_apply_pending() {
+  for (auto &entry : _client_blocks) {
+    ClientBlock &block = entry.second;
+    if (!block.applied && client_apply_block(entry.first, block)) {
+      block.applied = true;
+      _client_unapplied--;
+    }
+  }
+}
+
+void World::_on_block_loaded(Vector3i p_block) {
+  // A reloaded block comes back from the generator; put the edit back.
+  auto it = _client_blocks.find(TerrainEditLog::pack(p_block));
+  if (it == _client_blocks.end()) {
+    return;
+  }
+  ClientBlock &block = it->second;
+  if (block.applied) {
+    block.applied = false;
+    _client_unapplied++;
+  }
+}
+
+//////// MESSAGES ////////////////
+
+void World::bind_messages() {
+  NetworkManager *net = NetUtils::get_net_manager(this);
+  ERR_FAIL_COND_MSG(!net, "World: NetworkManager missing");
+  NetDispatcher &dispatcher = net->get_dispatcher();
+  dispatcher.bind<TerrainBlockMessage>(
+      [this](int, const TerrainBlockMessage &message) {
+        client_on_terrain_block(message);
+      });
+  dispatcher.bind<TerrainManifestMessage>(
+      [this](int sender_id, const TerrainManifestMessage &message) {
+        server_on_manifest(sender_id, message);
+      });
+  dispatcher.bind<TerrainManifestAckMessage>(
+      [this](int, const TerrainManifestAckMessage &message) {
+        client_on_manifest_ack(message);
+      });
+}
+
+void World::unbind_messages() {
+  NetworkManager *net = NetUtils::get_net_manager(this);
+  if (net) {
+    NetDispatcher &dispatcher = net->get_dispatcher();
+    dispatcher.unbind<TerrainBlockMessage>();
+    dispatcher.unbind<TerrainManifestMessage>();
+    dispatcher.unbind<TerrainManifestAckMessage>();
+  }
 }
 
 ////////////////////////////////////
 
+int World::get_modified_block_count() const {
+  return _edit_log.get_modified_count();
+}
+
+int64_t World::get_terrain_blocks_sent() const { return _blocks_sent; }
+
+int64_t World::get_terrain_bytes_sent() const { return _block_bytes_sent; }
+
+int64_t World::get_terrain_blocks_received() const { return _blocks_received; }
+
+int World::get_terrain_cache_block_count() const {
+  return _cache.get_block_count();
+}
+
+int64_t World::get_terrain_cache_hits() const { return _cache_hits; }
+
+int64_t World::get_manifest_blocks_matched() const {
+  return _manifest_blocks_matched;
+}
+
+int World::get_payload_cache_entry_count() const {
+  return _payload_cache.get_entry_count();
+}
+
+int64_t World::get_payload_cache_used_bytes() const {
+  return _payload_cache.get_used_bytes();
+}
+
+int64_t World::get_payload_cache_hits() const {
+  return _payload_cache.get_hits();
+}
+
+int64_t World::get_payload_cache_misses() const {
+  return _payload_cache.get_misses();
+}
+
+int64_t World::get_payload_cache_bytes_saved() const {
+  return _payload_cache.get_bytes_saved();
+}
+
+void World::wake_players_near(const AABB &p_area) {
+  if (!_players_root) {
+    return;
+  }
+  for (int i = 0; i < _players_root->get_child_count(); i++) {
+    Player *player = Object::cast_to<Player>(_players_root->get_child(i));
+    if (player && player->is_dormant() &&
+        p_area.has_point(player->get_global_position())) {
+      player->wake_dormant();
+    }
+  }
+}
+
 void World::set_voxel_tool() {
   ERR_FAIL_COND_MSG(
       !_terrain, "Failed getting instance of voxel tool. _terrain is nullptr");
@@ -118,6 +767,19 @@ void World::set_terrain_path(NodePath path) { _terrain_path = path; }
 
 NodePath World::get_terrain_path() const { return _terrain_path; }
 
+void World::set_players_path(NodePath path) { _players_path = path; }
+
+NodePath World::get_players_path() const { return _players_path; }
+
+int World::get_payload_cache_budget_mb() const {
+  return static_cast<int>(_payload_cache.get_budget_bytes() / (1024 * 1024));
+}
+
+void World::set_payload_cache_budget_mb(int p_budget_mb) {
+  _payload_cache.set_budget_bytes(static_cast<int64_t>(p_budget_mb) * 1024 *
+                                  1024);
+}
+
 void World::connect_terrain_node() {
   ERR_FAIL_COND_MSG(_terrain_path.is_empty(),
                     "Terrain path is not set in World");
@@ -135,9 +797,47 @@ void World::_bind_methods() {
                        &World::setup_client);
   ClassDB::bind_method(D_METHOD("_on_mesh_block_entered", "p_pos"),
                        &World::_on_mesh_block_entered);
+  ClassDB::bind_method(D_METHOD("_on_block_loaded", "p_block"),
+                       &World::_on_block_loaded);
+  ClassDB::bind_method(D_METHOD("_on_peer_left", "p_peer_id"),
+                       &World::_on_peer_left);
+  ClassDB::bind_method(D_METHOD("client_on_seed", "seed"),
+                       &World::client_on_seed);
+  ClassDB::bind_method(D_METHOD("edit_sphere", "center", "radius", "dig"),
+                       &World::edit_sphere);
+  ClassDB::bind_method(D_METHOD("get_modified_block_count"),
+                       &World::get_modified_block_count);
+  ClassDB::bind_method(D_METHOD("get_terrain_blocks_sent"),
+                       &World::get_terrain_blocks_sent);
+  ClassDB::bind_method(D_METHOD("get_terrain_bytes_sent"),
+                       &World::get_terrain_bytes_sent);
+  ClassDB::bind_method(D_METHOD("get_terrain_blocks_received"),
+                       &World::get_terrain_blocks_received);
+  ClassDB::bind_method(D_METHOD("get_terrain_cache_block_count"),
+                       &World::get_terrain_cache_block_count);
+  ClassDB::bind_method(D_METHOD("get_terrain_cache_hits"),
+                       &World::get_terrain_cache_hits);
+  ClassDB::bind_method(D_METHOD("get_manifest_blocks_matched"),
+                       &World::get_manifest_blocks_matched);
+  ClassDB::bind_method(D_METHOD("get_payload_cache_entry_count"),
+                       &World::get_payload_cache_entry_count);
+  ClassDB::bind_method(D_METHOD("get_payload_cache_used_bytes"),
+                       &World::get_payload_cache_used_bytes);
+  ClassDB::bind_method(D_METHOD("get_payload_cache_hits"),
+                       &World::get_payload_cache_hits);
+  ClassDB::bind_method(D_METHOD("get_payload_cache_misses"),
+                       &World::get_payload_cache_misses);
+  ClassDB::bind_method(D_METHOD("get_payload_cache_bytes_saved"),
+                       &World::get_payload_cache_bytes_saved);
+  ClassDB::bind_method(D_METHOD("benchmark_terrain_codecs", "max_blocks"),
+                       &World::benchmark_terrain_codecs, DEFVAL(256));
 
   BIND_PROPERTY_HINT(World, Variant::NODE_PATH, "terrain_path", terrain_path,
                      PROPERTY_HINT_NODE_PATH_VALID_TYPES);
+  BIND_PROPERTY_HINT(World, Variant::NODE_PATH, "players_path", players_path,
+                     PROPERTY_HINT_NODE_PATH_VALID_TYPES);
+  BIND_PROPERTY(World, Variant::INT, "payload_cache_budget_mb",
+                payload_cache_budget_mb);
 }
 
 } // namespace morphic
@@ -1,5 +1,11 @@
 #pragma once
 
+#include "net/net_messages.h"
+#include "world/terrain_block_cache.h"
+#include "world/terrain_block_codec.h"
+#include "world/terrain_edit_log.h"
+#include "world/terrain_payload_cache.h"
+
 #include "godot_cpp/classes/voxel_generator_graph.hpp"
 #include <godot_cpp/classes/multiplayer_spawner.hpp>
 #include <godot_cpp/classes/node3d.hpp>
@@ -7,10 +13,16 @@
 #include <godot_cpp/classes/voxel_terrain.hpp>
 #include <godot_cpp/classes/voxel_tool.hpp>
 
+#include <unordered_map>
+#include <vector>
+
 using namespace godot;
 
 namespace morphic {
 
+// Clients generate terrain themselves from the session seed; the server
+// only streams blocks that were edited (TerrainEditLog), as typed
+// TerrainBlockMessages on the terrain channel.
 class World : public Node3D {
   GDCLASS(World, Node3D)
 
@@ -20,22 +32,115 @@ protected:
 public:
   void _enter_tree() override;
   void _ready() override;
+  void _exit_tree() override;
+  void _physics_process(double delta) override;
 
   // should be called by WorldLoader
   void setup_server(Dictionary p_save_info);
   void setup_client(Dictionary p_save_info);
 
+  // Server: carves (or fills) a sphere and records the touched blocks.
+  void edit_sphere(Vector3 p_center, float p_radius, bool p_dig);
+  VoxelTerrain *get_terrain() const { return _terrain; }
+
+  int get_modified_block_count() const;
+  int64_t get_terrain_blocks_sent() const;
+  int64_t get_terrain_bytes_sent() const;
+  int64_t get_terrain_blocks_received() const;
+  int get_terrain_cache_block_count() const;
+  int64_t get_terrain_cache_hits() const;
+  int64_t get_manifest_blocks_matched() const;
+  int get_payload_cache_entry_count() const;
+  int64_t get_payload_cache_used_bytes() const;
+  int64_t get_payload_cache_hits() const;
+  int64_t get_payload_cache_misses() const;
+  int64_t get_payload_cache_bytes_saved() const;
+
+  // Server: encodes up to `max_blocks` loaded edited blocks with every
+  // codec and reports size ratio and encode/decode MB/s against the raw
+  // serialized blocks, plus plain zstd for comparison.
+  Dictionary benchmark_terrain_codecs(int p_max_blocks);
+
 private:
+  // Edited blocks sent per peer per sync pass, nearest first.
+  static constexpr int k_edit_blocks_per_sync = 8;
+  // No new blocks for a peer while this much terrain waits in its queue.
+  static constexpr int64_t k_max_queued_terrain_bytes = 256 * 1024;
+  static constexpr float k_edit_sync_interval_s = 0.1f;
+  static constexpr float k_edit_save_interval_s = 5.0f;
+  static constexpr float k_cache_save_interval_s = 10.0f;
+
+  struct ClientBlock {
+    uint32_t version = 0;
+    TerrainCodec codec = TerrainCodec::VOXEL;
+    PackedByteArray voxels;
+    bool applied = false;
+  };
+
   NodePath _terrain_path;
+  NodePath _players_path;
   VoxelTerrain *_terrain = nullptr;
+  Node *_players_root = nullptr;
   Ref<VoxelTool> _vt;
 
+  // server
+  TerrainEditLog _edit_log;
+  std::vector<TerrainEditLog::Block> _pending_blocks;
+  String _edits_path;
+  bool _edits_dirty = false;
+  float _edit_sync_left = 0.0f;
+  float _edit_save_left = k_edit_save_interval_s;
+  int64_t _blocks_sent = 0;
+  int64_t _block_bytes_sent = 0;
+  // Manifest entries matched so far, per peer, until its last message.
+  std::unordered_map<int, uint32_t> _manifest_matched;
+  int64_t _manifest_blocks_matched = 0;
+  TerrainPayloadCache _payload_cache;
+  std::vector<int64_t> _edited_keys;
+
+  // client
+  Ref<VoxelGenerator> _client_generator;
+  std::unordered_map<int64_t, ClientBlock> _client_blocks;
+  int _client_unapplied = 0;
+  int64_t _blocks_received = 0;
+  TerrainBlockCache _cache;
+  String _cache_path;
+  // Set by the manifest ack; only then may cached blocks be used or saved.
+  bool _cache_validated = false;
+  float _cache_save_left = k_cache_save_interval_s;
+  int64_t _cache_hits = 0;
+
   void set_voxel_tool();
+  // Terrain changed under or around these players; resume simulating them.
+  void wake_players_near(const AABB &p_area);
+  void bind_messages();
+  void unbind_messages();
+
+  void server_sync_edits();
+  bool server_send_block(int p_peer_id, const TerrainEditLog::Block &block,
+                         float p_priority);
+  void server_load_edits();
+  void server_save_edits();
+  void server_on_manifest(int p_sender_id,
+                          const TerrainManifestMessage &message);
+
+  void client_on_seed(int p_seed);
+  void client_on_terrain_block(const TerrainBlockMessage &message);
+  void client_send_manifest();
+  void client_on_manifest_ack(const TerrainManifestAckMessage &message);
+  bool client_apply_block(int64_t key, ClientBlock &block);
+  void client_apply_pending();
+  void _on_block_loaded(Vector3i p_block);
+  void _on_peer_left(int p_peer_id);
 
   // inspector getters and setters
 
   NodePath get_terrain_path() const;
   void set_terrain_path(const NodePath p_path);
+  NodePath get_players_path() const;
+  void set_players_path(const NodePath p_path);
+  int get_payload_cache_budget_mb() const;
+  void set_payload_cache_budget_mb(int p_budget_mb);
   void connect_terrain_node();
   void apply_seed_to_all_graph_noises(Ref<VoxelGeneratorGraph> generator,
                                       int global_seed);